@@ -0,0 +1,204 @@
+#include "BackgroundLoader.h"
+#include "PdfBackgroundRenderer.h"
+#include "Trace.h"
+
+#include <QFileInfo>
+#include <QImageIOHandler>
+#include <QImageReader>
+#include <QCoreApplication>
+#include <QtPdf/QPdfDocument>
+
+#include <algorithm>
+
+namespace {
+// Rozmiar obrazu po uwzględnieniu orientacji EXIF (setAutoTransform).
+QSize orientedSize(const QImageReader& reader, const QSize& rawSize) {
+    if (reader.transformation() & QImageIOHandler::TransformationRotate90) {
+        return rawSize.transposed();
+    }
+    return rawSize;
+}
+
+BackgroundHandle registerImage(const std::shared_ptr<BackgroundStore>& store, const QImage& image,
+                               const QByteArray& sourceKey,
+                               std::shared_ptr<QPdfDocument> pdf = {}, int pdfPage = 0) {
+    if (store) {
+        return store->insert(image, sourceKey, std::move(pdf), pdfPage);
+    }
+    return BackgroundStore::makeAsset(image, std::move(pdf), pdfPage);
+}
+
+// Podgląd z już zdekodowanego obrazu.
+QImage previewFromImage(const QImage& image) {
+    return image.scaled(BackgroundLoader::kPreviewMaxSide, BackgroundLoader::kPreviewMaxSide,
+                        Qt::KeepAspectRatio, Qt::FastTransformation);
+}
+
+/**
+ * Ten sam plik wczytany wcześniej (np. dla innego piętra) nie jest
+ * ponownie dekodowany: jeśli magazyn zawiera już jego podkład, zgłasza go
+ * jako wynik i zwraca true.  Skrót pliku liczony jest dopiero po
+ * podglądzie, blokami, ze sprawdzaniem anulowania; sourceKey otrzymuje
+ * klucz do rejestracji nowego podkładu.
+ */
+bool reuseStored(QPromise<BackgroundLoadResult>& promise, const QString& file,
+                 const std::shared_ptr<BackgroundStore>& store, QByteArray& sourceKey) {
+    if (!store) {
+        return false;
+    }
+    const QByteArray fileKey = BackgroundStore::fileKey(file, [&promise]() { return promise.isCanceled(); });
+    sourceKey = BackgroundStore::sourceKey(fileKey, 0);
+    BackgroundHandle existing = store->findBySource(sourceKey);
+    if (!existing) {
+        return false;
+    }
+    BackgroundLoadResult result;
+    result.fullSize = existing->size;
+    result.asset = existing;
+    promise.setProgressValue(100);
+    promise.addResult(result);
+    return true;
+}
+
+void loadPdf(QPromise<BackgroundLoadResult>& promise, const QString& file,
+             const std::shared_ptr<BackgroundStore>& store) {
+    auto pdf = std::make_shared<QPdfDocument>();
+    if (pdf->load(file) != QPdfDocument::Error::None || pdf->pageCount() < 1) {
+        return;
+    }
+    promise.setProgressValue(10);
+
+    const int pageIndex = 0;
+    const QSize fullSize = PdfBackgroundRenderer::pageRasterSize(*pdf, pageIndex);
+    if (fullSize.isEmpty()) {
+        return;
+    }
+
+    // Podgląd: ta sama strona w niskiej rozdzielczości
+    BackgroundLoadResult preview;
+    preview.preview = true;
+    preview.image = PdfBackgroundRenderer::renderPage(*pdf, pageIndex, BackgroundLoader::kPreviewMaxSide);
+    preview.fullSize = fullSize;
+    if (promise.isCanceled()) {
+        return;
+    }
+    if (!preview.image.isNull()) {
+        promise.addResult(preview);
+    }
+    promise.setProgressValue(20);
+
+    QByteArray sourceKey;
+    if (reuseStored(promise, file, store, sourceKey) || promise.isCanceled()) {
+        return;
+    }
+    promise.setProgressValue(30);
+
+    BackgroundLoadResult result = BackgroundLoader::renderPdfPage(pdf, pageIndex, store, sourceKey);
+    if (!result.asset || promise.isCanceled()) {
+        return;
+    }
+    // Dokument będzie używany i zwalniany w wątku GUI
+    pdf->moveToThread(QCoreApplication::instance()->thread());
+    promise.setProgressValue(100);
+    promise.addResult(result);
+}
+
+void loadRaster(QPromise<BackgroundLoadResult>& promise, const QString& file,
+                const std::shared_ptr<BackgroundStore>& store) {
+    // Pełny obraz, jeśli został zdekodowany już na potrzeby podglądu
+    QImage image;
+    {
+        QImageReader reader(file);
+        reader.setAutoTransform(true);
+        const QSize rawSize = reader.size();
+        const bool large = rawSize.isValid()
+            && std::max(rawSize.width(), rawSize.height()) > BackgroundLoader::kPreviewMaxSide;
+        BackgroundLoadResult preview;
+        preview.preview = true;
+        if (large && reader.format() == "jpeg" && reader.supportsOption(QImageIOHandler::ScaledSize)) {
+            // JPEG skaluje w trakcie dekodowania – podgląd za ułamek kosztu
+            reader.setScaledSize(rawSize.scaled(BackgroundLoader::kPreviewMaxSide,
+                                                BackgroundLoader::kPreviewMaxSide,
+                                                Qt::KeepAspectRatio));
+            preview.image = reader.read();
+            preview.fullSize = orientedSize(reader, rawSize);
+        } else if (large) {
+            // PNG, TIFF i pozostałe: podgląd wymaga pełnego dekodowania, więc
+            // pokazujemy go zaraz po nim – przed skrótem pliku i piramidą.
+            image = reader.read();
+            if (image.isNull()) {
+                return;
+            }
+            preview.image = previewFromImage(image);
+            preview.fullSize = image.size();
+        }
+        if (promise.isCanceled()) {
+            return;
+        }
+        if (!preview.image.isNull()) {
+            promise.addResult(preview);
+        }
+    }
+    promise.setProgressValue(30);
+
+    QByteArray sourceKey;
+    if (reuseStored(promise, file, store, sourceKey) || promise.isCanceled()) {
+        return;
+    }
+    promise.setProgressValue(40);
+
+    if (image.isNull()) {
+        QImageReader reader(file);
+        reader.setAutoTransform(true);
+        image = reader.read();
+    }
+    if (image.isNull() || promise.isCanceled()) {
+        return;
+    }
+    promise.setProgressValue(70);
+    BackgroundLoadResult result;
+    result.fullSize = image.size();
+    result.asset = registerImage(store, image, sourceKey);
+    if (!result.asset || promise.isCanceled()) {
+        return;
+    }
+    promise.setProgressValue(100);
+    promise.addResult(result);
+}
+} // namespace
+
+void BackgroundLoader::run(QPromise<BackgroundLoadResult>& promise, const QString& file,
+                           std::shared_ptr<BackgroundStore> store) {
+    TRACE_SCOPE("BackgroundLoader::run");
+    promise.setProgressRange(0, 100);
+    promise.setProgressValue(0);
+
+    if (QFileInfo(file).suffix().toLower() == "pdf") {
+        loadPdf(promise, file, store);
+    } else {
+        loadRaster(promise, file, store);
+    }
+}
+
+BackgroundLoadResult BackgroundLoader::renderPdfPage(const std::shared_ptr<QPdfDocument>& pdf,
+                                                     int pageIndex,
+                                                     const std::shared_ptr<BackgroundStore>& store,
+                                                     const QByteArray& sourceKey) {
+    TRACE_SCOPE("BackgroundLoader::renderPdfPage");
+    BackgroundLoadResult result;
+    if (!pdf) {
+        return result;
+    }
+    if (BackgroundHandle existing = store ? store->findBySource(sourceKey) : nullptr) {
+        result.fullSize = existing->size;
+        result.asset = existing;
+        return result;
+    }
+    const QImage image = PdfBackgroundRenderer::renderPage(*pdf, pageIndex);
+    if (image.isNull()) {
+        return result;
+    }
+    result.fullSize = image.size();
+    result.asset = registerImage(store, image, sourceKey, pdf, pageIndex);
+    return result;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <QImage>
+#include <QPromise>
+#include <QSize>
+#include <QString>
+#include <memory>
+#include "BackgroundStore.h"
+
+class QPdfDocument;
+
+/**
+ * Wynik wczytywania podkładu w tle.  Zadanie zgłasza najpierw (o ile to
+ * możliwe) szybki podgląd w obniżonej rozdzielczości, a na końcu gotowy
+ * podkład z magazynu (raster wraz z piramidą kafelków).
+ */
+struct BackgroundLoadResult {
+    bool preview = false;   ///< true – podgląd, false – wynik końcowy
+    QImage image;           ///< obraz podglądu (tylko dla preview)
+    QSize fullSize;         ///< rozmiar pełnego rastra (układ współrzędnych podkładu)
+    BackgroundHandle asset; ///< gotowy podkład (tylko wynik końcowy)
+};
+
+/**
+ * Dekodowanie pliku podkładu poza wątkiem GUI.  Funkcja run jest
+ * przeznaczona dla QtConcurrent::run; postęp (0–100) i wyniki
+ * przekazuje przez QPromise, a między etapami sprawdza anulowanie.
+ * Jeśli podano magazyn, plik wczytany już wcześniej nie jest ponownie
+ * dekodowany; jego skrót liczony jest dopiero po zgłoszeniu podglądu.
+ */
+class BackgroundLoader {
+public:
+    /// Dłuższy bok podglądu w pikselach.
+    static constexpr int kPreviewMaxSide = 1024;
+
+    static void run(QPromise<BackgroundLoadResult>& promise, const QString& file,
+                    std::shared_ptr<BackgroundStore> store);
+
+    /**
+     * Renderuje stronę otwartego już dokumentu PDF i rejestruje ją
+     * w magazynie (strona obecna już w magazynie nie jest renderowana).
+     * Przeznaczona do importu wielu stron jednego dokumentu w puli wątków
+     * (QtConcurrent::mapped); dokument jest otwierany tylko raz
+     * i współdzielony przez wszystkie zadania.  QtPdf szereguje samo
+     * renderowanie globalną blokadą pdfium, więc równolegle przebiega
+     * tylko budowa piramidy i rejestracja w magazynie.
+     */
+    static BackgroundLoadResult renderPdfPage(const std::shared_ptr<QPdfDocument>& pdf,
+                                              int pageIndex,
+                                              const std::shared_ptr<BackgroundStore>& store,
+                                              const QByteArray& sourceKey = QByteArray());
+};
@@ -0,0 +1,94 @@
+#include "BackgroundPyramid.h"
+
+#include <QPainter>
+
+#include <algorithm>
+#include <cmath>
+
+BackgroundPyramid::BackgroundPyramid(const QImage& source) {
+    if (source.isNull()) {
+        return;
+    }
+    m_sourceSize = source.size();
+
+    // Format premultiplied jest najszybszą ścieżką dla silnika rastrowego,
+    // więc konwertujemy raz, a kolejne poziomy dziedziczą format.
+    QImage level = source.format() == QImage::Format_ARGB32_Premultiplied
+                       ? source
+                       : source.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    m_levels.push_back(makeLevel(level, m_sourceSize));
+
+    // Kolejne poziomy powstają z poprzedniego, aż cały obraz zmieści się
+    // w jednym kafelku.
+    while (level.width() > kTileSize || level.height() > kTileSize) {
+        const QSize next(std::max(1, level.width() / 2), std::max(1, level.height() / 2));
+        level = level.scaled(next, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        m_levels.push_back(makeLevel(level, m_sourceSize));
+    }
+}
+
+BackgroundPyramid::Level BackgroundPyramid::makeLevel(const QImage& image, const QSize& sourceSize) {
+    Level lvl;
+    lvl.size = image.size();
+    lvl.scaleX = double(image.width()) / double(sourceSize.width());
+    lvl.scaleY = double(image.height()) / double(sourceSize.height());
+    lvl.columns = (image.width() + kTileSize - 1) / kTileSize;
+    lvl.rows = (image.height() + kTileSize - 1) / kTileSize;
+    lvl.tiles.reserve(size_t(lvl.columns) * size_t(lvl.rows));
+    for (int r = 0; r < lvl.rows; ++r) {
+        for (int c = 0; c < lvl.columns; ++c) {
+            const QRect tileRect(c * kTileSize, r * kTileSize,
+                                 std::min(kTileSize, image.width() - c * kTileSize),
+                                 std::min(kTileSize, image.height() - r * kTileSize));
+            lvl.tiles.push_back(image.copy(tileRect));
+        }
+    }
+    return lvl;
+}
+
+int BackgroundPyramid::levelForZoom(double deviceZoom) const {
+    if (m_levels.empty()) {
+        return -1;
+    }
+    int level = 0;
+    // Schodzimy w dół piramidy, dopóki następny poziom ma wciąż co najmniej
+    // tyle pikseli, ile ekran wyświetli na piksel źródła.
+    while (level + 1 < levelCount() && m_levels[level + 1].scaleX >= deviceZoom) {
+        ++level;
+    }
+    return level;
+}
+
+int BackgroundPyramid::draw(QPainter& painter, const QRectF& visibleRect, double deviceZoom) const {
+    const int levelIndex = levelForZoom(deviceZoom);
+    if (levelIndex < 0) {
+        return 0;
+    }
+    const Level& lvl = m_levels[levelIndex];
+
+    const QRectF sourceBounds(QPointF(0, 0), QSizeF(m_sourceSize));
+    const QRectF visible = visibleRect.intersected(sourceBounds);
+    if (visible.isEmpty()) {
+        return 0;
+    }
+
+    // Zakres kafelków w pikselach wybranego poziomu
+    const int c0 = std::clamp(int(std::floor(visible.left() * lvl.scaleX / kTileSize)), 0, lvl.columns - 1);
+    const int c1 = std::clamp(int(std::floor(visible.right() * lvl.scaleX / kTileSize)), 0, lvl.columns - 1);
+    const int r0 = std::clamp(int(std::floor(visible.top() * lvl.scaleY / kTileSize)), 0, lvl.rows - 1);
+    const int r1 = std::clamp(int(std::floor(visible.bottom() * lvl.scaleY / kTileSize)), 0, lvl.rows - 1);
+
+    int drawn = 0;
+    for (int r = r0; r <= r1; ++r) {
+        for (int c = c0; c <= c1; ++c) {
+            const QImage& tile = lvl.tiles[size_t(r) * size_t(lvl.columns) + size_t(c)];
+            const QRectF target(c * kTileSize / lvl.scaleX,
+                                r * kTileSize / lvl.scaleY,
+                                tile.width() / lvl.scaleX,
+                                tile.height() / lvl.scaleY);
+            painter.drawImage(target, tile);
+            ++drawn;
+        }
+    }
+    return drawn;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <QImage>
+#include <QRectF>
+#include <QSize>
+#include <vector>
+
+class QPainter;
+
+/**
+ * Wielorozdzielcza piramida kafelków dla obrazu podkładu.  Obraz źródłowy
+ * (poziom 0) oraz jego kolejne pomniejszenia (każde o połowę mniejsze)
+ * są dzielone na kafelki o stałym rozmiarze.  Podczas rysowania wybierany
+ * jest poziom odpowiadający bieżącemu powiększeniu, a rysowane są tylko
+ * kafelki przecinające widoczny obszar.  Dzięki temu koszt klatki zależy
+ * od rozmiaru okna, a nie od rozdzielczości skanu.
+ */
+class BackgroundPyramid {
+public:
+    /// Bok kafelka w pikselach danego poziomu.
+    static constexpr int kTileSize = 512;
+
+    BackgroundPyramid() = default;
+    /**
+     * Buduje piramidę z podanego obrazu.  Operuje wyłącznie na QImage,
+     * więc może być wywołany także poza wątkiem GUI.
+     */
+    explicit BackgroundPyramid(const QImage& source);
+
+    bool isNull() const { return m_levels.empty(); }
+    QSize sourceSize() const { return m_sourceSize; }
+    int levelCount() const { return static_cast<int>(m_levels.size()); }
+
+    /**
+     * Zwraca indeks najmniejszego poziomu, którego rozdzielczość jest nadal
+     * nie mniejsza niż rozdzielczość ekranu przy podanym powiększeniu
+     * (liczba pikseli urządzenia na piksel obrazu źródłowego).
+     */
+    int levelForZoom(double deviceZoom) const;
+
+    /**
+     * Rysuje kafelki przecinające visibleRect.  Prostokąt oraz bieżąca
+     * transformacja malarza są wyrażone w pikselach obrazu źródłowego.
+     * Zwraca liczbę narysowanych kafelków.
+     */
+    int draw(QPainter& painter, const QRectF& visibleRect, double deviceZoom) const;
+
+private:
+    struct Level {
+        QSize size;
+        double scaleX = 1.0; ///< piksele poziomu na piksel źródła (oś X)
+        double scaleY = 1.0; ///< piksele poziomu na piksel źródła (oś Y)
+        int columns = 0;
+        int rows = 0;
+        std::vector<QImage> tiles; ///< kafelki wierszami: rows * columns
+    };
+
+    static Level makeLevel(const QImage& image, const QSize& sourceSize);
+
+    QSize m_sourceSize;
+    std::vector<Level> m_levels;
+};
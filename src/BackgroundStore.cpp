@@ -0,0 +1,138 @@
+#include "BackgroundStore.h"
+#include "Trace.h"
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QMutexLocker>
+
+QByteArray BackgroundStore::contentKey(const QImage& image) {
+    if (image.isNull()) {
+        return QByteArray();
+    }
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    const QByteArray header = QByteArray::number(image.width()) + 'x'
+                              + QByteArray::number(image.height()) + ':'
+                              + QByteArray::number(int(image.format()));
+    hash.addData(header);
+    // Haszujemy wiersz po wierszu – bajty wyrównania na końcu linii
+    // mogą zawierać przypadkowe wartości.
+    const qsizetype rowBytes = (qsizetype(image.width()) * image.depth() + 7) / 8;
+    for (int y = 0; y < image.height(); ++y) {
+        hash.addData(QByteArray::fromRawData(reinterpret_cast<const char*>(image.constScanLine(y)), rowBytes));
+    }
+    return hash.result();
+}
+
+QByteArray BackgroundStore::fileKey(const QString& file, const std::function<bool()>& isCanceled) {
+    QFile f(file);
+    if (!f.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    // Bloki po 1 MiB – duży skan można anulować w trakcie czytania
+    constexpr qint64 kChunkSize = 1 << 20;
+    QByteArray chunk(kChunkSize, Qt::Uninitialized);
+    for (;;) {
+        if (isCanceled && isCanceled()) {
+            return QByteArray();
+        }
+        const qint64 read = f.read(chunk.data(), kChunkSize);
+        if (read < 0) {
+            return QByteArray();
+        }
+        if (read == 0) {
+            break;
+        }
+        hash.addData(QByteArrayView(chunk.constData(), read));
+    }
+    return hash.result();
+}
+
+QByteArray BackgroundStore::sourceKey(const QByteArray& fileKey, int pdfPage) {
+    if (fileKey.isEmpty()) {
+        return QByteArray();
+    }
+    return fileKey + ':' + QByteArray::number(pdfPage);
+}
+
+BackgroundHandle BackgroundStore::makeAsset(const QImage& image, std::shared_ptr<QPdfDocument> pdf,
+                                            int pdfPage) {
+    if (image.isNull()) {
+        return nullptr;
+    }
+    auto asset = std::make_shared<BackgroundAsset>();
+    asset->key = contentKey(image);
+    asset->size = image.size();
+    asset->pyramid = BackgroundPyramid(image);
+    asset->pdf = std::move(pdf);
+    asset->pdfPage = pdfPage;
+    return asset;
+}
+
+BackgroundHandle BackgroundStore::findBySource(const QByteArray& sourceKey) const {
+    if (sourceKey.isEmpty()) {
+        return nullptr;
+    }
+    QMutexLocker locker(&m_mutex);
+    auto it = m_bySource.constFind(sourceKey);
+    return it == m_bySource.constEnd() ? nullptr : it->lock();
+}
+
+BackgroundHandle BackgroundStore::insert(const QImage& image, const QByteArray& sourceKey,
+                                         std::shared_ptr<QPdfDocument> pdf, int pdfPage) {
+    TRACE_SCOPE("BackgroundStore::insert");
+    if (image.isNull()) {
+        return nullptr;
+    }
+    // Skrót i piramidę liczymy poza blokadą – to najdroższe etapy.
+    const QByteArray key = contentKey(image);
+    {
+        QMutexLocker locker(&m_mutex);
+        if (BackgroundHandle existing = m_byContent.value(key).lock()) {
+            if (!sourceKey.isEmpty()) {
+                m_bySource.insert(sourceKey, existing);
+            }
+            return existing;
+        }
+    }
+
+    auto asset = std::make_shared<BackgroundAsset>();
+    asset->key = key;
+    asset->size = image.size();
+    asset->pyramid = BackgroundPyramid(image);
+    asset->pdf = std::move(pdf);
+    asset->pdfPage = pdfPage;
+
+    QMutexLocker locker(&m_mutex);
+    // Inny wątek mógł w międzyczasie zarejestrować ten sam obraz
+    BackgroundHandle handle = m_byContent.value(key).lock();
+    if (!handle) {
+        purgeExpiredLocked();
+        handle = asset;
+        m_byContent.insert(key, handle);
+    }
+    if (!sourceKey.isEmpty()) {
+        m_bySource.insert(sourceKey, handle);
+    }
+    return handle;
+}
+
+int BackgroundStore::assetCount() const {
+    QMutexLocker locker(&m_mutex);
+    int count = 0;
+    for (auto it = m_byContent.constBegin(); it != m_byContent.constEnd(); ++it) {
+        if (!it->expired()) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+void BackgroundStore::purgeExpiredLocked() {
+    for (auto it = m_byContent.begin(); it != m_byContent.end();) {
+        it = it->expired() ? m_byContent.erase(it) : std::next(it);
+    }
+    for (auto it = m_bySource.begin(); it != m_bySource.end();) {
+        it = it->expired() ? m_bySource.erase(it) : std::next(it);
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+#include <functional>
+#include <memory>
+#include "BackgroundPyramid.h"
+
+class QPdfDocument;
+
+/**
+ * Zdekodowany podkład współdzielony przez płótna.  Obiekt jest
+ * niemodyfikowalny; płótna przechowują jedynie wskaźnik, a przesunięcie,
+ * obrót i przezroczystość pozostają ustawieniami każdego piętra.
+ */
+struct BackgroundAsset {
+    QByteArray key;            ///< skrót treści rastra (BackgroundStore::contentKey)
+    QSize size;                ///< rozmiar rastra źródłowego w pikselach
+    BackgroundPyramid pyramid; ///< piramida kafelków – jedyna kopia pikseli rastra
+    std::shared_ptr<QPdfDocument> pdf; ///< otwarty dokument (tylko podkłady PDF)
+    int pdfPage = 0;
+};
+
+using BackgroundHandle = std::shared_ptr<const BackgroundAsset>;
+
+/**
+ * Projektowy magazyn podkładów adresowany treścią.  Identyczne plany
+ * (ten sam plik albo te same piksele) są dekodowane i przechowywane
+ * w pamięci tylko raz.  Magazyn trzyma słabe odniesienia – podkład jest
+ * zwalniany, gdy nie używa go już żadne płótno.
+ *
+ * Metody są bezpieczne wątkowo, aby zadania wczytujące w tle mogły
+ * sprawdzić magazyn przed dekodowaniem pliku.
+ */
+class BackgroundStore {
+public:
+    /// Skrót pikseli obrazu (razem z rozmiarem i formatem).
+    static QByteArray contentKey(const QImage& image);
+    /**
+     * Skrót zawartości pliku źródłowego, czytanego blokami.  Jeśli podano
+     * isCanceled, jest sprawdzana przed każdym blokiem; po anulowaniu
+     * zwracany jest pusty klucz.
+     */
+    static QByteArray fileKey(const QString& file, const std::function<bool()>& isCanceled = {});
+    /// Klucz źródła: skrót pliku wraz z numerem strony PDF.
+    static QByteArray sourceKey(const QByteArray& fileKey, int pdfPage);
+    /// Tworzy podkład bez rejestrowania go w magazynie.
+    static BackgroundHandle makeAsset(const QImage& image,
+                                      std::shared_ptr<QPdfDocument> pdf = {},
+                                      int pdfPage = 0);
+
+    /// Zwraca podkład wczytany wcześniej z tego samego źródła.
+    BackgroundHandle findBySource(const QByteArray& sourceKey) const;
+
+    /**
+     * Rejestruje obraz.  Jeśli magazyn zawiera już podkład o identycznej
+     * treści, zwracany jest istniejący (nowy obraz zostaje porzucony).
+     * W przeciwnym razie budowana jest piramida i tworzony nowy wpis.
+     */
+    BackgroundHandle insert(const QImage& image, const QByteArray& sourceKey = QByteArray(),
+                            std::shared_ptr<QPdfDocument> pdf = {}, int pdfPage = 0);
+
+    /// Liczba podkładów używanych obecnie przez co najmniej jedno płótno.
+    int assetCount() const;
+
+private:
+    void purgeExpiredLocked();
+
+    mutable QMutex m_mutex;
+    QHash<QByteArray, std::weak_ptr<const BackgroundAsset>> m_byContent;
+    QHash<QByteArray, std::weak_ptr<const BackgroundAsset>> m_bySource;
+};
@@ -0,0 +1,89 @@
+#include "CalloutIndex.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Styk prostokątów z uwzględnieniem zdegenerowanych (o zerowym boku),
+// których QRectF::intersects nie uznaje za przecinające się.
+bool touches(const QRectF& a, const QRectF& b) {
+    return a.left() <= b.right() && b.left() <= a.right()
+        && a.top() <= b.bottom() && b.top() <= a.bottom();
+}
+} // namespace
+
+CalloutIndex::CalloutIndex(double cellSize)
+    : m_cellSize(cellSize > 0.0 ? cellSize : kDefaultCellSize) {}
+
+int CalloutIndex::cellCoord(double v) const {
+    return int(std::floor(v / m_cellSize));
+}
+
+quint64 CalloutIndex::cellKey(int column, int row) {
+    return (quint64(quint32(column)) << 32) | quint64(quint32(row));
+}
+
+void CalloutIndex::addToCells(int item, const QRectF& envelope) {
+    const QRectF r = envelope.normalized();
+    for (int row = cellCoord(r.top()); row <= cellCoord(r.bottom()); ++row) {
+        for (int c = cellCoord(r.left()); c <= cellCoord(r.right()); ++c) {
+            m_cells[cellKey(c, row)].push_back(item);
+        }
+    }
+}
+
+void CalloutIndex::removeFromCells(int item, const QRectF& envelope) {
+    const QRectF r = envelope.normalized();
+    for (int row = cellCoord(r.top()); row <= cellCoord(r.bottom()); ++row) {
+        for (int c = cellCoord(r.left()); c <= cellCoord(r.right()); ++c) {
+            auto it = m_cells.find(cellKey(c, row));
+            if (it == m_cells.end()) {
+                continue;
+            }
+            auto& cell = it.value();
+            cell.erase(std::remove(cell.begin(), cell.end(), item), cell.end());
+            if (cell.empty()) {
+                m_cells.erase(it);
+            }
+        }
+    }
+}
+
+void CalloutIndex::set(int item, const QRectF& envelope) {
+    if (item < 0) {
+        return;
+    }
+    if (item >= int(m_envelopes.size())) {
+        m_envelopes.resize(size_t(item) + 1);
+    } else {
+        removeFromCells(item, m_envelopes[item]);
+    }
+    m_envelopes[item] = envelope.normalized();
+    addToCells(item, m_envelopes[item]);
+}
+
+void CalloutIndex::clear() {
+    m_envelopes.clear();
+    m_cells.clear();
+}
+
+std::vector<int> CalloutIndex::candidates(const QRectF& area) const {
+    std::vector<int> result;
+    const QRectF r = area.normalized();
+    for (int row = cellCoord(r.top()); row <= cellCoord(r.bottom()); ++row) {
+        for (int c = cellCoord(r.left()); c <= cellCoord(r.right()); ++c) {
+            auto it = m_cells.constFind(cellKey(c, row));
+            if (it == m_cells.constEnd()) {
+                continue;
+            }
+            for (int item : it.value()) {
+                if (touches(m_envelopes[item], r)) {
+                    result.push_back(item);
+                }
+            }
+        }
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
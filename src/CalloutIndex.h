@@ -0,0 +1,43 @@
+#pragma once
+#include <QHash>
+#include <QRectF>
+#include <vector>
+
+/**
+ * Indeks przestrzenny dymków (TextItem) – równomierna siatka w układzie
+ * świata.  Dla każdego dymka przechowywany jest prostokąt obejmujący
+ * (dymek, koniec strzałki), a zapytanie zwraca tylko dymki z komórek
+ * wokół kliknięcia.  Elementy są identyfikowane indeksem w m_textItems;
+ * po usunięciu elementu (przesunięcie indeksów) indeks należy zbudować
+ * od nowa.
+ */
+class CalloutIndex {
+public:
+    /// Domyślny bok komórki w jednostkach świata.
+    static constexpr double kDefaultCellSize = 128.0;
+
+    explicit CalloutIndex(double cellSize = kDefaultCellSize);
+
+    /// Wstawia element albo aktualizuje jego prostokąt obejmujący.
+    void set(int item, const QRectF& envelope);
+    void clear();
+
+    /**
+     * Zwraca elementy, których prostokąt obejmujący styka się z area,
+     * bez powtórzeń i w kolejności rosnących indeksów (jak dotychczasowe
+     * pętle po m_textItems).
+     */
+    std::vector<int> candidates(const QRectF& area) const;
+
+    int itemCount() const { return int(m_envelopes.size()); }
+
+private:
+    int cellCoord(double v) const;
+    static quint64 cellKey(int column, int row);
+    void addToCells(int item, const QRectF& envelope);
+    void removeFromCells(int item, const QRectF& envelope);
+
+    double m_cellSize;
+    std::vector<QRectF> m_envelopes; ///< pusty (null) – brak elementu
+    QHash<quint64, std::vector<int>> m_cells;
+};
@@ -1,23 +1,27 @@
 #include "CanvasWidget.h"
 #include <unordered_map>
 #include "Settings.h"
+#include "PdfBackgroundRenderer.h"
+#include "Trace.h"
 
 #include <QPainter>
 #include <QPainterPath>
+#include <QStaticText>
 #include <QMouseEvent>
+#include <QPaintEvent>
 #include <QWheelEvent>
 #include <QKeyEvent>
 #include <QInputDialog>
-#include <QFileInfo>
-#include <QImageReader>
 #include <QtMath>
 
 // std::max, std::min, std::sqrt
 #include <cmath>
 #include <algorithm>
 #include <array>
+#include <memory>
 
 #include <QtPdf/QPdfDocument>
+#include <QtConcurrent/QtConcurrentRun>
 #include <QSize>
 #include <QImage>
 #include <QTextEdit>
@@ -218,12 +222,13 @@ void CanvasWidget::insertPendingText(const QString& text) {
     // Warstwa dla komentarzy
     item.layer = QStringLiteral("Komentarze");
     m_textItems.push_back(item);
+    updateCalloutIndex((int)m_textItems.size() - 1);
     // Wyczyść stan
     m_hasTextInsertPos = false;
     m_pendingText.clear();
     // Zakończ tryb
     m_mode = ToolMode::None;
-    update();
+    invalidateLayer(CanvasLayer::Callouts);
     emit measurementFinished();
 }
 
@@ -252,7 +257,7 @@ void CanvasWidget::startSelect() {
     m_isDraggingSelectedText = false;
     // Use arrow cursor for selection
     setCursor(Qt::ArrowCursor);
-    update();
+    invalidateLayer(CanvasLayer::Callouts);
 }
 
 // Rozpoczyna tryb wstawiania tekstu.  Jeśli parent jest nullptr,
@@ -284,7 +289,7 @@ void CanvasWidget::startInsertText(QWidget* parent) {
     m_mode = ToolMode::InsertText;
     // Ustaw kursor krzyża
     setCursor(Qt::CrossCursor);
-    update();
+    invalidateLayer(CanvasLayer::Callouts);
 }
 
 // Rozpoczyna tryb usuwania pomiarów.  Czyści bieżące punkty i stos cofnięć
@@ -299,7 +304,7 @@ void CanvasWidget::startDelete() {
     m_isDraggingSelectedText = false;
     // Use cross cursor to indicate deletion (eraser-like)
     setCursor(Qt::CrossCursor);
-    update();
+    invalidateLayer(CanvasLayer::Callouts);
 }
 
 // Ustawia kolor zaznaczonego pomiaru
@@ -317,21 +322,21 @@ void CanvasWidget::setSelectedMeasureLineWidth(int w) {
 void CanvasWidget::setSelectedTextColor(const QColor &c) {
     if (!hasSelectedText()) return;
     m_textItems[m_selectedTextIndex].color = c;
-    update();
+    invalidateLayer(CanvasLayer::Callouts);
 }
 
 // Ustawia kolor wypełnienia dymka zaznaczonego tekstu
 void CanvasWidget::setSelectedTextBgColor(const QColor &c) {
     if (!hasSelectedText()) return;
     m_textItems[m_selectedTextIndex].bgColor = c;
-    update();
+    invalidateLayer(CanvasLayer::Callouts);
 }
 
 // Ustawia kolor obramowania dymka zaznaczonego tekstu
 void CanvasWidget::setSelectedTextBorderColor(const QColor &c) {
     if (!hasSelectedText()) return;
     m_textItems[m_selectedTextIndex].borderColor = c;
-    update();
+    invalidateLayer(CanvasLayer::Callouts);
 }
 
 void CanvasWidget::setSelectedTextFont(const QFont &f) {
@@ -355,7 +360,8 @@ void CanvasWidget::setSelectedTextFont(const QFont &f) {
     }
     const double gapWorld = 12.0 / pixPerM;
     ti.pos = clampAnchorOutsideBubble(ti.boundingRect, ti.pos, ti.anchor, gapWorld);
-    update();
+    updateCalloutIndex(m_selectedTextIndex);
+    invalidateLayer(CanvasLayer::Callouts);
 }
 
 void CanvasWidget::updateSelectedText(const QString &text, const QColor &color, const QFont &font) {
@@ -396,14 +402,16 @@ void CanvasWidget::updateSelectedText(const QString &text, const QColor &color,
     ti.boundingRect = QRectF(x_m, y_m, w_m, h_m);
     const double gapWorld = 12.0 / pixPerM;
     ti.pos = clampAnchorOutsideBubble(ti.boundingRect, ti.pos, ti.anchor, gapWorld);
-    update();
+    updateCalloutIndex(idx);
+    invalidateLayer(CanvasLayer::Callouts);
 }
 
 void CanvasWidget::deleteSelectedText() {
     if (!hasSelectedText()) return;
     m_textItems.erase(m_textItems.begin() + m_selectedTextIndex);
     m_selectedTextIndex = -1;
-    update();
+    rebuildCalloutIndex();
+    invalidateLayer(CanvasLayer::Callouts);
 }
 
 /**
@@ -437,7 +445,8 @@ void CanvasWidget::setSelectedTextAnchor(CalloutAnchor a) {
     if (pixPerM <= 0.0) pixPerM = 1.0;
     const double gapWorld = 12.0 / pixPerM;
     ti.pos = clampAnchorOutsideBubble(ti.boundingRect, ti.pos, ti.anchor, gapWorld);
-    update();
+    updateCalloutIndex(idx);
+    invalidateLayer(CanvasLayer::Callouts);
 }
 
 void CanvasWidget::startEditExistingText(int index) {
@@ -523,6 +532,7 @@ void CanvasWidget::startEditExistingText(int index) {
             break;
         }
         t.boundingRect = QRectF(x_m, y_m, w_m, h_m);
+        updateCalloutIndex(index);
         // Move the editor widget on screen to follow the bubble's top-left.
         QPointF tl = toScreen(t.boundingRect.topLeft());
         int width2 = std::max(40, (int)std::round(docSize.width() + marginX * 2));
@@ -531,12 +541,12 @@ void CanvasWidget::startEditExistingText(int index) {
             m_textEdit->move(tl.toPoint());
             m_textEdit->resize(width2, height2);
         }
-        update();
+        invalidateLayer(CanvasLayer::Callouts);
     });
     // Przejdź do trybu InsertText, aby obsłużyć zatwierdzenie/Anuluj
     m_mode = ToolMode::InsertText;
     // Zaktualizuj widok
-    update();
+    invalidateLayer(CanvasLayer::Callouts);
 }
 
 // Usuwa zaznaczony pomiar
@@ -559,59 +569,110 @@ void CanvasWidget::setCurrentLineWidth(int w) {
     m_measurementsTool.setCurrentLineWidth(w);
 }
 
-bool CanvasWidget::loadBackgroundFile(const QString& file) {
-    QImage img;
-    if (!loadBackgroundImage(file, img)) {
-        return false;
-    }
-    m_bgImage = img;
+void CanvasWidget::applyLoadedBackground(const BackgroundHandle& asset) {
+    setBackgroundAssetInternal(asset);
+    m_bgPreview = QImage();
+    m_bgPreviewSize = QSize();
     m_showBackground = true;
     m_bgOffset = QPointF(0, 0);
     m_bgRotationDeg = 0.0;
-    update();
-    return true;
+    invalidateLayer(CanvasLayer::Background);
 }
 
-bool CanvasWidget::loadBackgroundImage(const QString& file, QImage& image) const {
-    QFileInfo fi(file);
-    const QString ext = fi.suffix().toLower();
-    if (ext == "pdf") {
-        QPdfDocument pdf;
-        auto err = pdf.load(file);
-        if (err != QPdfDocument::Error::None) {
-            return false;
-        }
-        if (pdf.pageCount() < 1) {
-            return false;
-        }
+void CanvasWidget::setBackgroundAssetInternal(const BackgroundHandle& asset) {
+    const bool samePdf = m_bgAsset && asset && m_bgAsset->pdf == asset->pdf
+                         && m_bgAsset->pdfPage == asset->pdfPage;
+    m_bgAsset = asset;
+    m_bgRotatedCache.clear();
+    if (!samePdf) {
+        setPdfRenderer(m_bgAsset && m_bgAsset->pdf
+                           ? new PdfBackgroundRenderer(m_bgAsset->pdf, m_bgAsset->pdfPage, this)
+                           : nullptr);
+    }
+}
 
-        const int pageIndex = 0;
-        const QSizeF pt = pdf.pagePointSize(pageIndex);
-        if (pt.isEmpty()) {
-            return false;
-        }
+void CanvasWidget::setLoadedBackground(const BackgroundLoadResult& result) {
+    if (!result.asset) {
+        return;
+    }
+    cancelBackgroundLoad();
+    applyLoadedBackground(result.asset);
+}
 
-        const double targetWidth = 2000.0;
-        const double scale = targetWidth / pt.width();
-        const QSize imgSize(qMax(1, int(pt.width() * scale)),
-                            qMax(1, int(pt.height() * scale)));
+void CanvasWidget::setBackgroundStore(std::shared_ptr<BackgroundStore> store) {
+    m_bgStore = std::move(store);
+}
 
-        QImage rendered = pdf.render(pageIndex, imgSize);
-        if (rendered.isNull()) {
-            return false;
-        }
+void CanvasWidget::loadBackgroundFileAsync(const QString& file) {
+    cancelBackgroundLoad();
+    m_bgLoadWatcher = new QFutureWatcher<BackgroundLoadResult>(this);
+    connect(m_bgLoadWatcher, &QFutureWatcher<BackgroundLoadResult>::progressValueChanged,
+            this, &CanvasWidget::backgroundLoadProgress);
+    connect(m_bgLoadWatcher, &QFutureWatcher<BackgroundLoadResult>::resultReadyAt,
+            this, &CanvasWidget::onBackgroundLoadResult);
+    connect(m_bgLoadWatcher, &QFutureWatcher<BackgroundLoadResult>::finished,
+            this, &CanvasWidget::onBackgroundLoadFinished);
+    m_bgLoadWatcher->setFuture(QtConcurrent::run(&BackgroundLoader::run, file, m_bgStore));
+}
 
-        image = rendered.convertToFormat(QImage::Format_ARGB32_Premultiplied);
-        return true;
+void CanvasWidget::cancelBackgroundLoad() {
+    if (!m_bgLoadWatcher) {
+        return;
+    }
+    // Zadanie kończy się przy najbliższym sprawdzeniu anulowania; jego
+    // wyniki są ignorowane, a obserwator zwalniany po zakończeniu.
+    QFutureWatcher<BackgroundLoadResult>* watcher = m_bgLoadWatcher;
+    m_bgLoadWatcher = nullptr;
+    watcher->disconnect(this);
+    connect(watcher, &QFutureWatcher<BackgroundLoadResult>::finished, watcher, &QObject::deleteLater);
+    watcher->cancel();
+    if (watcher->isFinished()) {
+        watcher->deleteLater();
+    }
+    m_bgPreview = QImage();
+    m_bgPreviewSize = QSize();
+    invalidateLayer(CanvasLayer::Background);
+    emit backgroundLoadCanceled();
+}
+
+void CanvasWidget::onBackgroundLoadResult(int index) {
+    if (!m_bgLoadWatcher) {
+        return;
+    }
+    const BackgroundLoadResult result = m_bgLoadWatcher->resultAt(index);
+    if (!result.preview) {
+        return; // wynik końcowy obsługuje onBackgroundLoadFinished()
+    }
+    // Przesunięcie, obrót i widoczność obecnego podkładu zostają bez zmian
+    // do chwili zatwierdzenia wczytania (applyLoadedBackground), aby
+    // anulowanie lub błąd dekodowania ich nie traciły.
+    m_bgPreview = result.image;
+    m_bgPreviewSize = result.fullSize;
+    invalidateLayer(CanvasLayer::Background);
+}
+
+void CanvasWidget::onBackgroundLoadFinished() {
+    QFutureWatcher<BackgroundLoadResult>* watcher = m_bgLoadWatcher;
+    if (!watcher) {
+        return;
     }
-    QImageReader reader(file);
-    reader.setAutoTransform(true);
-    QImage img = reader.read();
-    if (img.isNull()) {
-        return false;
+    m_bgLoadWatcher = nullptr;
+    watcher->deleteLater();
+
+    const QFuture<BackgroundLoadResult> future = watcher->future();
+    const int count = future.resultCount();
+    if (count > 0) {
+        const BackgroundLoadResult result = future.resultAt(count - 1);
+        if (!result.preview) {
+            setLoadedBackground(result);
+            emit backgroundLoadFinished(true);
+            return;
+        }
     }
-    image = img;
-    return true;
+    m_bgPreview = QImage();
+    m_bgPreviewSize = QSize();
+    invalidateLayer(CanvasLayer::Background);
+    emit backgroundLoadFinished(false);
 }
 
 // --- Zarządzanie widocznością warstw ---
@@ -625,7 +686,7 @@ void CanvasWidget::toggleLayerVisibility(const QString& layer) {
     }
     // Przełącz wartość logiczną
     it->second = !it->second;
-    update();
+    invalidateAllLayers();
 }
 
 bool CanvasWidget::isLayerVisible(const QString& layer) const {
@@ -636,40 +697,72 @@ bool CanvasWidget::isLayerVisible(const QString& layer) const {
     return it->second;
 }
 
-void CanvasWidget::toggleBackgroundVisibility() { m_showBackground = !m_showBackground; update(); }
+void CanvasWidget::toggleBackgroundVisibility() { m_showBackground = !m_showBackground; invalidateLayer(CanvasLayer::Background); }
 void CanvasWidget::setBackgroundVisible(bool visible) {
     m_showBackground = visible;
-    update();
+    invalidateLayer(CanvasLayer::Background);
 }
 
 void CanvasWidget::setBackgroundOpacity(double opacity) {
     m_bgOpacity = std::clamp(opacity, 0.0, 1.0);
-    update();
+    invalidateLayer(CanvasLayer::Background);
 }
 
 double CanvasWidget::backgroundOpacity() const { return m_bgOpacity; }
 
-bool CanvasWidget::hasBackground() const { return !m_bgImage.isNull(); }
+bool CanvasWidget::hasBackground() const { return m_bgAsset != nullptr; }
 
 bool CanvasWidget::isBackgroundVisible() const { return m_showBackground; }
 
 void CanvasWidget::clearBackground() {
-    m_bgImage = QImage();
+    cancelBackgroundLoad();
+    setBackgroundAssetInternal(nullptr);
     m_bgOffset = QPointF(0, 0);
     m_bgRotationDeg = 0.0;
     m_bgOpacity = 1.0;
-    update();
+    invalidateLayer(CanvasLayer::Background);
 }
 
 void CanvasWidget::setBackgroundImage(const QImage& image) {
-    m_bgImage = image;
+    setBackgroundAsset(m_bgStore ? m_bgStore->insert(image) : BackgroundStore::makeAsset(image));
+}
+
+void CanvasWidget::setBackgroundAsset(const BackgroundHandle& asset) {
+    cancelBackgroundLoad();
+    setBackgroundAssetInternal(asset);
     m_bgOffset = QPointF(0, 0);
     m_bgRotationDeg = 0.0;
     m_bgOpacity = 1.0;
-    update();
+    invalidateLayer(CanvasLayer::Background);
+}
+
+QSize CanvasWidget::backgroundSize() const {
+    return m_bgAsset ? m_bgAsset->size : QSize();
+}
+
+void CanvasWidget::setPdfRenderer(PdfBackgroundRenderer* renderer) {
+    if (m_pdfRenderer == renderer) {
+        return;
+    }
+    delete m_pdfRenderer;
+    m_pdfRenderer = renderer;
+    m_pdfTileRect = QRectF();
+    if (m_pdfRenderer) {
+        connect(m_pdfRenderer, &PdfBackgroundRenderer::tileReady, this, [this]() {
+            if (m_bgAsset && m_pdfRenderer) {
+                // Zmienia się tylko obszar poprzedniego i nowego kafelka
+                // (z pikselem zapasu na wygładzanie krawędzi)
+                const QTransform t = backgroundTransform(m_bgAsset->size);
+                const QRectF tileRect = m_pdfRenderer->tileRect();
+                const QRectF changed = m_pdfTileRect.united(tileRect).adjusted(-1, -1, 1, 1);
+                m_bgRotatedCache.invalidate(t.mapRect(changed));
+                m_pdfTileRect = tileRect;
+            }
+            invalidateLayer(CanvasLayer::Background);
+        });
+    }
 }
 
-const QImage& CanvasWidget::backgroundImage() const { return m_bgImage; }
 void CanvasWidget::startBackgroundAdjust() {
     if (!hasBackground()) {
         return;
@@ -683,7 +776,7 @@ void CanvasWidget::startBackgroundAdjust() {
     m_bgSavedRotationDeg = m_bgRotationDeg;
     unsetCursor();
     setFocus();
-    update();
+    invalidateLayer(CanvasLayer::Background);
 }
 
 void CanvasWidget::setBackgroundMoveMode(bool enabled) {
@@ -722,7 +815,7 @@ void CanvasWidget::confirmBackgroundAdjust() {
     m_bgDragging = false;
     m_mode = ToolMode::None;
     unsetCursor();
-    update();
+    invalidateLayer(CanvasLayer::Background);
     emit backgroundAdjustFinished();
 }
 
@@ -738,7 +831,7 @@ void CanvasWidget::cancelBackgroundAdjust() {
     m_bgDragging = false;
     m_mode = ToolMode::None;
     unsetCursor();
-    update();
+    invalidateLayer(CanvasLayer::Background);
     emit backgroundAdjustFinished();
 }
 
@@ -749,7 +842,7 @@ void CanvasWidget::undoBackgroundAdjust() {
     m_bgOffset = m_bgSavedOffset;
     m_bgRotationDeg = m_bgSavedRotationDeg;
     m_bgDragging = false;
-    update();
+    invalidateLayer(CanvasLayer::Background);
 }
 
 bool CanvasWidget::isBackgroundMoveMode() const { return m_bgMoveMode; }
@@ -759,8 +852,22 @@ bool CanvasWidget::isBackgroundRotateMode() const { return m_bgRotateMode; }
 void CanvasWidget::toggleMeasuresVisibility() {
     m_showMeasures = !m_showMeasures;
     m_measurementsTool.setVisible(m_showMeasures);
+    invalidateLayer(CanvasLayer::Measures);
+}
+void CanvasWidget::setView(double zoom, const QPointF& viewOffset) {
+    m_zoom = std::clamp(zoom, 0.1, 50.0);
+    m_viewOffset = viewOffset;
     update();
 }
+
+int CanvasWidget::addTextItem(const TextItem& item) {
+    m_textItems.push_back(item);
+    const int index = (int)m_textItems.size() - 1;
+    updateCalloutIndex(index);
+    invalidateLayer(CanvasLayer::Callouts);
+    return index;
+}
+
 void CanvasWidget::startScaleDefinition(double) {
     m_scaleStep = ScaleStep::FirstPending;
     m_scaleHasFirst = false;
@@ -861,200 +968,357 @@ void CanvasWidget::startMeasureAdvanced(QWidget* parent) {
 QPointF CanvasWidget::toWorld(const QPointF& screen) const { return (screen - m_viewOffset) / m_zoom; }
 QPointF CanvasWidget::toScreen(const QPointF& world) const { return world * m_zoom + m_viewOffset; }
 
-void CanvasWidget::paintEvent(QPaintEvent*) {
+void CanvasWidget::invalidateLayer(CanvasLayer layer) {
+    if (layer == CanvasLayer::Measures) {
+        m_measurementsTool.invalidateLabelLayout();
+    }
+    m_layers.invalidate(layer);
+    update();
+}
+
+void CanvasWidget::invalidateAllLayers() {
+    m_measurementsTool.invalidateLabelLayout();
+    m_layers.invalidateAll();
+    update();
+}
+
+QRect CanvasWidget::worldToScreenRect(const QRectF& worldRect) const {
+    // Pióra kosmetyczne, kropki i uchwyty wystają poza geometrię świata
+    const int margin = 8;
+    const QRectF screen = QRectF(toScreen(worldRect.topLeft()),
+                                 toScreen(worldRect.bottomRight())).normalized();
+    return screen.toAlignedRect().adjusted(-margin, -margin, margin, margin);
+}
+
+void CanvasWidget::requestUpdateRect(const QRectF& worldRect) {
+    updateDirtyRect(worldToScreenRect(worldRect));
+}
+
+void CanvasWidget::updateDirtyRect(const QRect& rect) {
+    // Panel profilera leży poza odświeżanymi fragmentami, a jego liczby
+    // zmieniają się w każdej klatce – dołączamy go do każdego odświeżenia.
+    if (m_profiler.isEnabled() && !m_hudRect.isEmpty()) {
+        update(QRegion(rect).united(m_hudRect));
+    } else {
+        update(rect);
+    }
+}
+
+void CanvasWidget::invalidateLayerRect(CanvasLayer layer, const QRectF& worldRect) {
+    const QRect rect = worldToScreenRect(worldRect);
+    m_layers.invalidate(layer, rect);
+    updateDirtyRect(rect);
+}
+
+QRect CanvasWidget::calloutScreenRect(const TextItem& item) const {
+    const QPointF topLeft = toScreen(item.boundingRect.topLeft());
+    const QSizeF sizePx(item.boundingRect.width() * m_pixelsPerMeter * m_zoom,
+                        item.boundingRect.height() * m_pixelsPerMeter * m_zoom);
+    QPolygonF pts(QRectF(topLeft, sizePx));
+    pts << toScreen(item.pos);
+    const QRectF rect = pts.boundingRect();
+    // Uchwyty (promień 5 px) i obramowanie
+    const int margin = 8;
+    return rect.toAlignedRect().adjusted(-margin, -margin, margin, margin);
+}
+
+QRectF CanvasWidget::calloutWorldEnvelope(const TextItem& item) const {
+    // Dymek jest rysowany od boundingRect.topLeft() z rozmiarem
+    // przeliczonym przez skalę; obejmujemy też surowy boundingRect
+    // i koniec strzałki, bo tak testują je różne tryby myszy.
+    const QRectF bubble(item.boundingRect.topLeft(), item.boundingRect.size() * m_pixelsPerMeter);
+    QPolygonF pts(bubble);
+    pts << QPolygonF(item.boundingRect) << item.pos;
+    return pts.boundingRect();
+}
+
+void CanvasWidget::updateCalloutIndex(int index) {
+    if (index >= 0 && index < (int)m_textItems.size()) {
+        m_calloutIndex.set(index, calloutWorldEnvelope(m_textItems[index]));
+    }
+}
+
+void CanvasWidget::rebuildCalloutIndex() {
+    m_calloutIndex.clear();
+    for (int i = 0; i < (int)m_textItems.size(); ++i) {
+        updateCalloutIndex(i);
+    }
+}
+
+std::vector<int> CanvasWidget::calloutsNear(const QPointF& world, double toleranceWorld) const {
+    const double t = std::max(toleranceWorld, 0.0);
+    return m_calloutIndex.candidates(QRectF(world.x() - t, world.y() - t, 2.0 * t, 2.0 * t));
+}
+
+void CanvasWidget::invalidateCalloutRect(const QRect& before, const QRect& after) {
+    const QRect rect = before.united(after);
+    m_layers.invalidate(CanvasLayer::Callouts, rect);
+    updateDirtyRect(rect);
+}
+
+void CanvasWidget::paintEvent(QPaintEvent* ev) {
+    TRACE_SCOPE("CanvasWidget::paintEvent");
     QPainter p(this);
-    p.fillRect(rect(), Qt::white);
+    m_profiler.beginFrame();
+    // Rysujemy wyłącznie odsłonięty obszar; Qt obcina malarza do tego
+    // regionu, a warstwy kopiujemy tylko w jego prostokątach.
+    const QRegion exposed = ev->region();
+    for (const QRect& r : exposed) {
+        p.fillRect(r, Qt::white);
+    }
+
+    // Warstwy są renderowane ponownie tylko po unieważnieniu lub zmianie
+    // widoku; w pozostałych klatkach jedynie je kopiujemy.
+    m_layers.setView(size(), devicePixelRatioF(), m_zoom, m_viewOffset);
+    const auto toWorldPainter = [this](QPainter& lp) {
+        lp.translate(m_viewOffset);
+        lp.scale(m_zoom, m_zoom);
+    };
+    const auto countLayer = [this](bool rendered) {
+        m_profiler.addCacheStats(PaintProfiler::Cache::Layers, rendered ? 0 : 1, rendered ? 1 : 0);
+    };
+    {
+        PaintProfiler::PhaseScope phase(m_profiler, PaintProfiler::Phase::Background);
+        countLayer(m_layers.compose(p, CanvasLayer::Background, exposed, [&](QPainter& lp) {
+            if ((m_showBackground && m_bgAsset) || !m_bgPreview.isNull()) {
+                toWorldPainter(lp);
+                applyBackgroundTransform(lp);
+            }
+        }));
+    }
+    {
+        PaintProfiler::PhaseScope phase(m_profiler, PaintProfiler::Phase::Measures);
+        countLayer(m_layers.compose(p, CanvasLayer::Measures, exposed, [&](QPainter& lp) {
+            if (m_showMeasures) {
+                toWorldPainter(lp);
+                m_measurementsTool.draw(lp);
+                if (m_profiler.isEnabled()) {
+                    const auto& stats = m_measurementsTool.lastDrawStats();
+                    m_profiler.addCount(PaintProfiler::Counter::MeasuresDrawn, stats.drawn);
+                    m_profiler.addCount(PaintProfiler::Counter::MeasuresCulled, stats.culled);
+                    m_profiler.addCacheStats(PaintProfiler::Cache::MeasureLod, stats.lodHits, stats.lodMisses);
+                    m_profiler.addCacheStats(PaintProfiler::Cache::DotSprites, stats.spriteHits, stats.spriteMisses);
+                }
+            }
+        }));
+    }
+    {
+        // Dymki są wyznaczane w pikselach ekranu, dlatego rysujemy je bez
+        // przekształcenia świata.
+        PaintProfiler::PhaseScope phase(m_profiler, PaintProfiler::Phase::Callouts);
+        countLayer(m_layers.compose(p, CanvasLayer::Callouts, exposed, [&](QPainter& lp) { drawTextItems(lp); }));
+    }
 
-    p.translate(m_viewOffset);
-    p.scale(m_zoom, m_zoom);
+    {
+        PaintProfiler::PhaseScope phase(m_profiler, PaintProfiler::Phase::Overlay);
+        p.save();
+        toWorldPainter(p);
+        drawOverlay(p); // overlay is also in world coords
+        p.restore();
+        drawTempTextItem(p);
 
-    if (m_showBackground && !m_bgImage.isNull()) {
-        applyBackgroundTransform(p);
+        p.setPen(Qt::gray);
+        p.drawText(10, height()-10, "PPM: pan, kółko/+/-: zoom; Pomiary: menu; Enter kończy; Ctrl+Enter zatwierdza komentarz; Backspace cofa; Esc anuluje");
+    }
+    m_profiler.endFrame();
+    if (m_profiler.isEnabled()) {
+        m_hudRect = m_profiler.drawHud(p, QPoint(10, 10));
     }
+}
 
-    if (m_showMeasures) {
-        m_measurementsTool.draw(p);
+void CanvasWidget::setPaintProfilerVisible(bool visible) {
+    if (visible == m_profiler.isEnabled()) {
+        return;
     }
-    drawTextItems(p);
-    drawOverlay(p); // overlay is also in world coords
+    m_profiler.reset();
+    m_profiler.setEnabled(visible);
+    update();
+}
+
+bool CanvasWidget::isPaintProfilerVisible() const {
+    return m_profiler.isEnabled();
+}
+
+bool CanvasWidget::exportPaintProfile(const QString& path) const {
+    return m_profiler.exportStats(path);
+}
+
+int CanvasWidget::paintProfileFrameCount() const {
+    return m_profiler.frameCount();
+}
+
+/**
+ * Geometria i układ tekstu dymka w pikselach ekranu, względem lewego
+ * górnego narożnika dymka (dzięki temu przesuwanie widoku nie unieważnia
+ * pamięci).  Klucz obejmuje wszystko, od czego zależy kształt: treść,
+ * czcionkę, kotwicę, boundingRect, pozycję strzałki oraz skalę widoku.
+ */
+struct CalloutRenderCache {
+    QString text;
+    QFont font;
+    CalloutAnchor anchor = CalloutAnchor::Bottom;
+    QRectF boundingRect;
+    QPointF pos;
+    double zoom = 0.0;
+    double pixelsPerMeter = 0.0;
+
+    QPainterPath path;
+    QRectF bubbleRect;   ///< prostokąt dymka (od (0,0))
+    QPointF anchorPoint; ///< koniec strzałki
+    QPointF textOrigin;
+    QStaticText staticText;
+
+    bool matches(const TextItem& item, const QFont& f, double z, double ppm) const {
+        return text == item.text && font == f && anchor == item.anchor
+            && boundingRect == item.boundingRect && pos == item.pos && zoom == z
+            && pixelsPerMeter == ppm;
+    }
+};
+
+const CalloutRenderCache& CanvasWidget::calloutRenderCache(const TextItem& txt, const QFont& font) const {
+    auto& cache = txt.renderCache;
+    if (cache && cache->matches(txt, font, m_zoom, m_pixelsPerMeter)) {
+        m_profiler.addCacheStats(PaintProfiler::Cache::CalloutLayout, 1, 0);
+        return *cache;
+    }
+    m_profiler.addCacheStats(PaintProfiler::Cache::CalloutLayout, 0, 1);
+    // Pamięć może być współdzielona z kopią elementu (np. dymek
+    // tymczasowy po zatwierdzeniu) – przy zmianie tworzymy nową.
+    auto c = std::make_shared<CalloutRenderCache>();
+    c->text = txt.text;
+    c->font = font;
+    c->anchor = txt.anchor;
+    c->boundingRect = txt.boundingRect;
+    c->pos = txt.pos;
+    c->zoom = m_zoom;
+    c->pixelsPerMeter = m_pixelsPerMeter;
 
-    p.resetTransform();
-    p.setPen(Qt::gray);
-    p.drawText(10, height()-10, "PPM: pan, kółko/+/-: zoom; Pomiary: menu; Enter kończy; Ctrl+Enter zatwierdza komentarz; Backspace cofa; Esc anuluje");
+    const double marginX = 8.0;
+    const double marginY = 6.0;
+    // Rozmiar dymka w pikselach oraz kotwica strzałki względem jego narożnika
+    c->bubbleRect = QRectF(QPointF(0, 0), QSizeF(txt.boundingRect.width() * m_pixelsPerMeter * m_zoom,
+                                                 txt.boundingRect.height() * m_pixelsPerMeter * m_zoom));
+    c->anchorPoint = (txt.pos - txt.boundingRect.topLeft()) * m_zoom;
+    const QRectF& bubbleRect = c->bubbleRect;
+    const QPointF& anchorScreen = c->anchorPoint;
+    // Ścieżka dymka z zaokrąglonymi rogami i strzałką
+    const double radius = 8.0;
+    c->path.addRoundedRect(bubbleRect, radius, radius);
+    const double halfBase = 9.0;
+    QPolygonF tail;
+    if (txt.anchor == CalloutAnchor::Bottom) {
+        double baseX = std::clamp(anchorScreen.x(), bubbleRect.left() + radius, bubbleRect.right() - radius);
+        tail << QPointF(baseX - halfBase, bubbleRect.bottom()) << anchorScreen
+             << QPointF(baseX + halfBase, bubbleRect.bottom());
+    } else if (txt.anchor == CalloutAnchor::Top) {
+        double baseX = std::clamp(anchorScreen.x(), bubbleRect.left() + radius, bubbleRect.right() - radius);
+        tail << QPointF(baseX - halfBase, bubbleRect.top()) << anchorScreen
+             << QPointF(baseX + halfBase, bubbleRect.top());
+    } else if (txt.anchor == CalloutAnchor::Left) {
+        double baseY = std::clamp(anchorScreen.y(), bubbleRect.top() + radius, bubbleRect.bottom() - radius);
+        tail << QPointF(bubbleRect.left(), baseY - halfBase) << anchorScreen
+             << QPointF(bubbleRect.left(), baseY + halfBase);
+    } else if (txt.anchor == CalloutAnchor::Right) {
+        double baseY = std::clamp(anchorScreen.y(), bubbleRect.top() + radius, bubbleRect.bottom() - radius);
+        tail << QPointF(bubbleRect.right(), baseY - halfBase) << anchorScreen
+             << QPointF(bubbleRect.right(), baseY + halfBase);
+    }
+    c->path.addPolygon(tail);
+    // Tekst z zawijaniem wierszy – układ liczony raz i zapamiętany
+    const QRectF textRect = bubbleRect.adjusted(marginX, marginY, -marginX, -marginY);
+    c->textOrigin = textRect.topLeft();
+    c->staticText.setTextFormat(Qt::PlainText);
+    c->staticText.setTextWidth(std::max(1.0, textRect.width()));
+    // QStaticText nie łamie wiersza na '\n' w zwykłym tekście
+    QString text = txt.text;
+    text.replace(QLatin1Char('\n'), QChar::LineSeparator);
+    c->staticText.setText(text);
+    c->staticText.prepare(QTransform(), font);
+    cache = std::move(c);
+    return *cache;
+}
+
+void CanvasWidget::drawCallout(QPainter& p, const TextItem& txt, bool selected, double handleRadius) {
+    // Zapamiętaj aktualne ustawienia pędzla, czcionki i koloru
+    QFont oldFont = p.font();
+    QPen oldPen = p.pen();
+    if (txt.font != QFont()) {
+        p.setFont(txt.font);
+    }
+    const CalloutRenderCache& cache = calloutRenderCache(txt, p.font());
+    p.save();
+    p.translate(toScreen(txt.boundingRect.topLeft()));
+    // Wypełnij tło dymka określonym kolorem tła z kanałem alfa
+    p.setPen(Qt::NoPen);
+    p.fillPath(cache.path, txt.bgColor);
+    // Narysuj obramowanie dymka w kolorze borderColor
+    QPen bubblePen(txt.borderColor);
+    bubblePen.setWidthF(1.2);
+    bubblePen.setCosmetic(true);
+    p.setPen(bubblePen);
+    p.drawPath(cache.path);
+    // Wypisz tekst wewnątrz dymka z odpowiednim marginesem w kolorze tekstu
+    p.setPen(txt.color);
+    p.drawStaticText(cache.textOrigin, cache.staticText);
+    // Jeśli element jest zaznaczony, narysuj czerwone przerywane obramowanie wokół dymka
+    if (selected) {
+        QPen selPen(QColor(255,0,0));
+        selPen.setStyle(Qt::DashLine);
+        selPen.setWidth(1);
+        selPen.setCosmetic(true);
+        p.setPen(selPen);
+        p.drawPath(cache.path);
+    }
+    if (handleRadius > 0.0) {
+        // Uchwytowe kropki na rogach i kotwicy
+        QPen handlePen(Qt::black);
+        handlePen.setCosmetic(true);
+        p.setPen(handlePen);
+        p.setBrush(Qt::white);
+        const QRectF& r = cache.bubbleRect;
+        p.drawEllipse(r.topLeft(), handleRadius, handleRadius);
+        p.drawEllipse(r.topRight(), handleRadius, handleRadius);
+        p.drawEllipse(r.bottomLeft(), handleRadius, handleRadius);
+        p.drawEllipse(r.bottomRight(), handleRadius, handleRadius);
+        p.drawEllipse(cache.anchorPoint, handleRadius, handleRadius);
+    }
+    p.restore();
+    // Przywróć stan
+    p.setFont(oldFont);
+    p.setPen(oldPen);
 }
 
 void CanvasWidget::drawTextItems(QPainter& p) {
     p.setRenderHint(QPainter::Antialiasing, true);
-    for (size_t ti = 0; ti < m_textItems.size(); ++ti) {
+    // Tylko dymki, których obrys z indeksu przecina widok lub odświeżany
+    // fragment; margines obejmuje uchwyty zaznaczenia.
+    QRectF visible = visibleWorldRect();
+    if (p.hasClipping()) {
+        const QRectF clip = p.clipBoundingRect();
+        visible = visible.intersected(QRectF(toWorld(clip.topLeft()), toWorld(clip.bottomRight())).normalized());
+    }
+    const double margin = 8.0 / m_zoom;
+    const std::vector<int> onScreen = m_calloutIndex.candidates(visible.adjusted(-margin, -margin, margin, margin));
+    m_profiler.addCount(PaintProfiler::Counter::CalloutsDrawn, int(onScreen.size()));
+    m_profiler.addCount(PaintProfiler::Counter::CalloutsCulled, int(m_textItems.size() - onScreen.size()));
+    for (int ti : onScreen) {
         const auto &txt = m_textItems[ti];
         if (txt.text.isEmpty()) continue;
         // Jeżeli warstwa tekstu jest wyłączona, pomiń rysowanie
         if (!isLayerVisible(txt.layer)) {
             continue;
         }
-        const double marginX = 8.0;
-        const double marginY = 6.0;
-        // Przelicz górny lewy narożnik oraz rozmiar dymka w pikselach
-        QPointF topLeftScreen = toScreen(txt.boundingRect.topLeft());
-        QSizeF sizePx(txt.boundingRect.width() * m_pixelsPerMeter * m_zoom,
-                      txt.boundingRect.height() * m_pixelsPerMeter * m_zoom);
-        QRectF bubbleRect(topLeftScreen, sizePx);
-        // Wyznacz anchor strzałki w pikselach
-        QPointF anchorScreen = toScreen(txt.pos);
-        // Zapamiętaj aktualne ustawienia pędzla, czcionki i koloru
-        QFont oldFont = p.font();
-        QPen oldPen = p.pen();
-        // Ustaw czcionkę tekstu
-        if (txt.font != QFont()) {
-            p.setFont(txt.font);
-        }
-        // Stwórz ścieżkę dymka z zaokrąglonymi rogami i strzałką
-        QPainterPath calloutPath;
-        const double radius = 8.0;
-        calloutPath.addRoundedRect(bubbleRect, radius, radius);
-        // Dodaj strzałkę w zależności od ustawionej kotwicy
-        const double halfBase = 9.0;
-        if (txt.anchor == CalloutAnchor::Bottom) {
-            double baseX = std::clamp(anchorScreen.x(), bubbleRect.left() + radius, bubbleRect.right() - radius);
-            QPointF baseLeft(baseX - halfBase, bubbleRect.bottom());
-            QPointF baseRight(baseX + halfBase, bubbleRect.bottom());
-            QPolygonF tail;
-            tail << baseLeft << anchorScreen << baseRight;
-            calloutPath.addPolygon(tail);
-        } else if (txt.anchor == CalloutAnchor::Top) {
-            double baseX = std::clamp(anchorScreen.x(), bubbleRect.left() + radius, bubbleRect.right() - radius);
-            QPointF baseLeft(baseX - halfBase, bubbleRect.top());
-            QPointF baseRight(baseX + halfBase, bubbleRect.top());
-            QPolygonF tail;
-            tail << baseLeft << anchorScreen << baseRight;
-            calloutPath.addPolygon(tail);
-        } else if (txt.anchor == CalloutAnchor::Left) {
-            double baseY = std::clamp(anchorScreen.y(), bubbleRect.top() + radius, bubbleRect.bottom() - radius);
-            QPointF baseTop(bubbleRect.left(), baseY - halfBase);
-            QPointF baseBottom(bubbleRect.left(), baseY + halfBase);
-            QPolygonF tail;
-            tail << baseTop << anchorScreen << baseBottom;
-            calloutPath.addPolygon(tail);
-        } else if (txt.anchor == CalloutAnchor::Right) {
-            double baseY = std::clamp(anchorScreen.y(), bubbleRect.top() + radius, bubbleRect.bottom() - radius);
-            QPointF baseTop(bubbleRect.right(), baseY - halfBase);
-            QPointF baseBottom(bubbleRect.right(), baseY + halfBase);
-            QPolygonF tail;
-            tail << baseTop << anchorScreen << baseBottom;
-            calloutPath.addPolygon(tail);
-        }
-        // Wypełnij tło dymka określonym kolorem tła z kanałem alfa
-        p.setPen(Qt::NoPen);
-        p.fillPath(calloutPath, txt.bgColor);
-        // Narysuj obramowanie dymka w kolorze borderColor
-        QPen bubblePen(txt.borderColor);
-        bubblePen.setWidthF(1.2);
-        bubblePen.setCosmetic(true);
-        p.setPen(bubblePen);
-        p.drawPath(calloutPath);
-        // Wypisz tekst wewnątrz dymka z odpowiednim marginesem w kolorze tekstu
-        QRectF textRect = bubbleRect.adjusted(marginX, marginY, -marginX, -marginY);
-        p.setPen(txt.color);
-        p.drawText(textRect, Qt::AlignLeft | Qt::AlignTop | Qt::TextWordWrap, txt.text);
-        // Jeśli element jest zaznaczony, narysuj czerwone przerywane obramowanie wokół dymka
-        if ((int)ti == m_selectedTextIndex && m_debugDrawTextHandles) {
-            QPen selPen(QColor(255,0,0));
-            selPen.setStyle(Qt::DashLine);
-            selPen.setWidth(1);
-            selPen.setCosmetic(true);
-            p.setPen(selPen);
-            p.drawPath(calloutPath);
-            // Uchwytowe kropki na rogach i kotwicy
-            QPen handlePen(Qt::black);
-            handlePen.setCosmetic(true);
-            p.setPen(handlePen);
-            p.setBrush(Qt::white);
-            const double handleRadius = 4.0;
-            p.drawEllipse(bubbleRect.topLeft(), handleRadius, handleRadius);
-            p.drawEllipse(bubbleRect.topRight(), handleRadius, handleRadius);
-            p.drawEllipse(bubbleRect.bottomLeft(), handleRadius, handleRadius);
-            p.drawEllipse(bubbleRect.bottomRight(), handleRadius, handleRadius);
-            p.drawEllipse(anchorScreen, handleRadius, handleRadius);
-        }
-        // Przywróć stan
-        p.setFont(oldFont);
-        p.setPen(oldPen);
+        const bool selected = (int)ti == m_selectedTextIndex && m_debugDrawTextHandles;
+        drawCallout(p, txt, selected, selected ? 4.0 : 0.0);
     }
-    // Narysuj tymczasowy dymek podczas wstawiania
+}
+
+void CanvasWidget::drawTempTextItem(QPainter& p) {
+    // Tymczasowy dymek zmienia się przy każdym ruchu myszy, dlatego jest
+    // rysowany jako nakładka, poza buforowaną warstwą dymków.
+    p.setRenderHint(QPainter::Antialiasing, true);
     if (m_mode == ToolMode::InsertText && m_hasTempTextItem) {
-        const auto &txt = m_tempTextItem;
-        const double marginX = 8.0;
-        const double marginY = 6.0;
-        // Przelicz górny lewy narożnik oraz rozmiar dymka w pikselach
-        QPointF topLeftScreen = toScreen(txt.boundingRect.topLeft());
-        QSizeF sizePx(txt.boundingRect.width() * m_pixelsPerMeter * m_zoom,
-                      txt.boundingRect.height() * m_pixelsPerMeter * m_zoom);
-        QRectF bubbleRect(topLeftScreen, sizePx);
-        // Wyznacz anchor strzałki w pikselach
-        QPointF anchorScreen = toScreen(txt.pos);
-        QFont oldFont = p.font();
-        QPen oldPen = p.pen();
-        if (txt.font != QFont()) {
-            p.setFont(txt.font);
-        }
-        QPainterPath calloutPath;
-        const double radius = 8.0;
-        calloutPath.addRoundedRect(bubbleRect, radius, radius);
-        const double halfBase = 9.0;
-        if (txt.anchor == CalloutAnchor::Bottom) {
-            double baseX = std::clamp(anchorScreen.x(), bubbleRect.left() + radius, bubbleRect.right() - radius);
-            QPointF baseLeft(baseX - halfBase, bubbleRect.bottom());
-            QPointF baseRight(baseX + halfBase, bubbleRect.bottom());
-            QPolygonF tail;
-            tail << baseLeft << anchorScreen << baseRight;
-            calloutPath.addPolygon(tail);
-        } else if (txt.anchor == CalloutAnchor::Top) {
-            double baseX = std::clamp(anchorScreen.x(), bubbleRect.left() + radius, bubbleRect.right() - radius);
-            QPointF baseLeft(baseX - halfBase, bubbleRect.top());
-            QPointF baseRight(baseX + halfBase, bubbleRect.top());
-            QPolygonF tail;
-            tail << baseLeft << anchorScreen << baseRight;
-            calloutPath.addPolygon(tail);
-        } else if (txt.anchor == CalloutAnchor::Left) {
-            double baseY = std::clamp(anchorScreen.y(), bubbleRect.top() + radius, bubbleRect.bottom() - radius);
-            QPointF baseTop(bubbleRect.left(), baseY - halfBase);
-            QPointF baseBottom(bubbleRect.left(), baseY + halfBase);
-            QPolygonF tail;
-            tail << baseTop << anchorScreen << baseBottom;
-            calloutPath.addPolygon(tail);
-        } else if (txt.anchor == CalloutAnchor::Right) {
-            double baseY = std::clamp(anchorScreen.y(), bubbleRect.top() + radius, bubbleRect.bottom() - radius);
-            QPointF baseTop(bubbleRect.right(), baseY - halfBase);
-            QPointF baseBottom(bubbleRect.right(), baseY + halfBase);
-            QPolygonF tail;
-            tail << baseTop << anchorScreen << baseBottom;
-            calloutPath.addPolygon(tail);
-        }
-        p.setPen(Qt::NoPen);
-        p.fillPath(calloutPath, txt.bgColor);
-        QPen bubblePen(txt.borderColor);
-        bubblePen.setWidthF(1.2);
-        bubblePen.setCosmetic(true);
-        p.setPen(bubblePen);
-        p.drawPath(calloutPath);
-        QRectF textRect = bubbleRect.adjusted(marginX, marginY, -marginX, -marginY);
-        p.setPen(txt.color);
-        p.drawText(textRect, Qt::AlignLeft | Qt::AlignTop | Qt::TextWordWrap, txt.text);
-        if (m_debugDrawTextHandles) {
-            // Uchwytowe kropki na rogach i kotwicy
-            QPen handlePen(Qt::black);
-            handlePen.setCosmetic(true);
-            p.setPen(handlePen);
-            p.setBrush(Qt::white);
-            const double handleRadius = 5.0;
-            p.drawEllipse(bubbleRect.topLeft(), handleRadius, handleRadius);
-            p.drawEllipse(bubbleRect.topRight(), handleRadius, handleRadius);
-            p.drawEllipse(bubbleRect.bottomLeft(), handleRadius, handleRadius);
-            p.drawEllipse(bubbleRect.bottomRight(), handleRadius, handleRadius);
-            p.drawEllipse(anchorScreen, handleRadius, handleRadius);
-        }
-        p.setFont(oldFont);
-        p.setPen(oldPen);
+        drawCallout(p, m_tempTextItem, false, m_debugDrawTextHandles ? 5.0 : 0.0);
     }
 }
 
@@ -1086,20 +1350,80 @@ void CanvasWidget::drawOverlay(QPainter& p) {
     }
 }
 
+QTransform CanvasWidget::backgroundTransform(const QSize& bgSize) const {
+    QTransform t;
+    t.translate(m_bgOffset.x(), m_bgOffset.y());
+    const QPointF center(bgSize.width() / 2.0, bgSize.height() / 2.0);
+    t.translate(center.x(), center.y());
+    if (!qFuzzyIsNull(m_bgRotationDeg)) {
+        t.rotate(m_bgRotationDeg);
+    }
+    t.translate(-center.x(), -center.y());
+    return t;
+}
+
+QRectF CanvasWidget::visibleWorldRect() const {
+    return QRectF(toWorld(QPointF(0, 0)), toWorld(QPointF(width(), height()))).normalized();
+}
+
 void CanvasWidget::applyBackgroundTransform(QPainter& painter) const {
-    if (m_bgImage.isNull()) {
+    // Podgląd wczytywanego podkładu ma pierwszeństwo przed poprzednim
+    // obrazem; rysujemy go w rozmiarze docelowego rastra, w położeniu,
+    // które nowy podkład dostanie po wczytaniu (początek układu, bez obrotu).
+    if (!m_bgPreview.isNull()) {
+        painter.save();
+        painter.setOpacity(m_bgOpacity);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+        painter.drawImage(QRectF(QPointF(0, 0), QSizeF(m_bgPreviewSize)), m_bgPreview);
+        painter.restore();
+        return;
+    }
+    if (!m_bgAsset) {
         return;
     }
+    const QRectF visibleWorld = visibleWorldRect();
+    const double deviceZoom = m_zoom * devicePixelRatioF();
+    if (m_pdfRenderer) {
+        // Ostry fragment PDF jest renderowany w tle; dopóki nie jest
+        // gotowy, widoczny pozostaje raster o niższej rozdzielczości.
+        const QTransform t = backgroundTransform(m_bgAsset->size);
+        m_pdfRenderer->requestRegion(t.inverted().mapRect(visibleWorld), deviceZoom);
+    }
+
+    if (!qFuzzyIsNull(m_bgRotationDeg) && !m_isAdjustingBackground) {
+        // Obrócony podkład rysujemy z kafelków przygotowanych wcześniej,
+        // aby przesuwanie widoku nie wymagało ponownego obracania obrazu.
+        RotatedBackgroundCache::Key key;
+        key.asset = m_bgAsset.get();
+        key.offset = m_bgOffset;
+        key.rotationDeg = m_bgRotationDeg;
+        key.opacity = m_bgOpacity;
+        const int rendered = m_bgRotatedCache.draw(painter, visibleWorld, deviceZoom, key,
+                                                   [this](QPainter& p, const QRectF& area, double zoom) {
+                                                       paintTransformedBackground(p, area, zoom);
+                                                   });
+        m_profiler.addCacheStats(PaintProfiler::Cache::BackgroundTiles,
+                                 m_bgRotatedCache.lastVisibleTileCount() - rendered, rendered);
+        return;
+    }
+    // Podczas dopasowywania (i bez obrotu) rysujemy bezpośrednio
+    m_bgRotatedCache.clear();
+    paintTransformedBackground(painter, visibleWorld, deviceZoom);
+}
+
+void CanvasWidget::paintTransformedBackground(QPainter& painter, const QRectF& visibleWorld,
+                                              double deviceZoom) const {
+    const QTransform t = backgroundTransform(m_bgAsset->size);
     painter.save();
     painter.setOpacity(m_bgOpacity);
-    painter.translate(m_bgOffset);
-    QPointF center(m_bgImage.width() / 2.0, m_bgImage.height() / 2.0);
-    painter.translate(center);
-    if (!qFuzzyIsNull(m_bgRotationDeg)) {
-        painter.rotate(m_bgRotationDeg);
+    painter.setTransform(t, true);
+    // Widoczny obszar przeliczony do pikseli obrazu; przy obrocie
+    // bierzemy prostokąt opisany, co wystarcza do wyboru kafelków.
+    m_bgAsset->pyramid.draw(painter, t.inverted().mapRect(visibleWorld), deviceZoom);
+    if (m_pdfRenderer && m_pdfRenderer->hasTile()) {
+        painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+        painter.drawImage(m_pdfRenderer->tileRect(), m_pdfRenderer->tile());
     }
-    painter.translate(-center);
-    painter.drawImage(QPointF(0, 0), m_bgImage);
     painter.restore();
 }
 
@@ -1113,7 +1437,7 @@ void CanvasWidget::mousePressEvent(QMouseEvent* ev) {
                 marginWorldX = 8.0 / (m_pixelsPerMeter * m_zoom);
                 marginWorldY = 6.0 / (m_pixelsPerMeter * m_zoom);
             }
-            for (int i = 0; i < (int)m_textItems.size(); ++i) {
+            for (int i : calloutsNear(pos, std::max(marginWorldX, marginWorldY))) {
                 const auto &ti = m_textItems[i];
                 QRectF hitRect = ti.boundingRect.adjusted(-marginWorldX, -marginWorldY, marginWorldX, marginWorldY);
                 if (hitRect.contains(pos)) {
@@ -1171,7 +1495,7 @@ void CanvasWidget::mousePressEvent(QMouseEvent* ev) {
         if (m_bgRotateMode) {
             m_bgDragging = true;
             m_bgStartRotationDeg = m_bgRotationDeg;
-            m_bgRotateCenter = m_bgOffset + QPointF(m_bgImage.width() / 2.0, m_bgImage.height() / 2.0);
+            m_bgRotateCenter = m_bgOffset + QPointF(backgroundSize().width() / 2.0, backgroundSize().height() / 2.0);
             m_bgStartAngleDeg = std::atan2(wpos.y() - m_bgRotateCenter.y(),
                                            wpos.x() - m_bgRotateCenter.x()) * 180.0 / M_PI;
             grabMouse();
@@ -1189,7 +1513,7 @@ void CanvasWidget::mousePressEvent(QMouseEvent* ev) {
         // przeciąganie kotwicy.
         int anchorIdx = -1;
         double threshold = 8.0 / safePixelsPerMeter(m_pixelsPerMeter, m_zoom);
-        for (int i = 0; i < (int)m_textItems.size(); ++i) {
+        for (int i : calloutsNear(wpos, threshold)) {
             const auto &ti = m_textItems[i];
             double dx = wpos.x() - ti.pos.x();
             double dy = wpos.y() - ti.pos.y();
@@ -1204,14 +1528,14 @@ void CanvasWidget::mousePressEvent(QMouseEvent* ev) {
             m_measurementsTool.clearSelection();
             m_isDraggingSelectedAnchor = true;
             m_isDraggingSelectedText = false;
-            update();
+            invalidateLayer(CanvasLayer::Callouts);
             return;
         }
         // Sprawdź, czy kliknięto w uchwyt rozmiaru któregoś dymka
         int resizeIdx = -1;
         ResizeHandle handle = ResizeHandle::None;
         double handleThreshold = 10.0;
-        for (int i = 0; i < (int)m_textItems.size(); ++i) {
+        for (int i : calloutsNear(wpos, handleThreshold / m_zoom)) {
             const auto &ti = m_textItems[i];
             QPointF topLeftScreen = toScreen(ti.boundingRect.topLeft());
             QSizeF sizePx(ti.boundingRect.width() * m_pixelsPerMeter * m_zoom,
@@ -1237,12 +1561,12 @@ void CanvasWidget::mousePressEvent(QMouseEvent* ev) {
             m_isDraggingSelectedText = false;
             m_isDraggingSelectedAnchor = false;
             grabMouse();
-            update();
+            invalidateLayer(CanvasLayer::Callouts);
             return;
         }
         // Jeśli kliknięto wewnątrz dymka, rozpocznij przeciąganie całego dymka
         int bubbleIdx = -1;
-        for (int i = 0; i < (int)m_textItems.size(); ++i) {
+        for (int i : calloutsNear(wpos, 1.0 / m_zoom)) {
             const auto &ti = m_textItems[i];
             QPointF topLeftScreen = toScreen(ti.boundingRect.topLeft());
             QSizeF sizePx(ti.boundingRect.width() * m_pixelsPerMeter * m_zoom,
@@ -1261,14 +1585,14 @@ void CanvasWidget::mousePressEvent(QMouseEvent* ev) {
             // Offset między kliknięciem a lewym górnym rogiem dymka
             m_dragStartOffset = wpos - m_textItems[bubbleIdx].boundingRect.topLeft();
             grabMouse();
-            update();
+            invalidateLayer(CanvasLayer::Callouts);
             return;
         }
         // W przeciwnym razie szukaj najbliższego pomiaru
         double bestDist = 5.0 / m_zoom; // próg w jednostkach world (przybliżony)
         m_measurementsTool.selectMeasureAt(wpos, bestDist);
         m_selectedTextIndex = -1;
-        update();
+        invalidateLayer(CanvasLayer::Callouts);
         return;
     }
     // Tryb wstawiania tekstu: pierwsze kliknięcie ustawia pozycję kotwicy,
@@ -1414,14 +1738,15 @@ void CanvasWidget::mousePressEvent(QMouseEvent* ev) {
     if (m_mode == ToolMode::Delete) {
         QPointF wpos = pos;
         // Najpierw sprawdź, czy kliknięto w element tekstowy
-        for (int i = 0; i < (int)m_textItems.size(); ++i) {
+        for (int i : calloutsNear(wpos, 1.0 / m_zoom)) {
             const auto &ti = m_textItems[i];
             if (ti.boundingRect.contains(wpos)) {
                 // Usuń tekst i zakończ
                 m_textItems.erase(m_textItems.begin() + i);
                 if (m_selectedTextIndex == i) m_selectedTextIndex = -1;
                 else if (m_selectedTextIndex > i) m_selectedTextIndex--;
-                update();
+                rebuildCalloutIndex();
+                invalidateLayer(CanvasLayer::Callouts);
                 return;
             }
         }
@@ -1451,7 +1776,7 @@ void CanvasWidget::mouseDoubleClickEvent(QMouseEvent* ev) {
             marginWorldX = 8.0 / (m_pixelsPerMeter * m_zoom);
             marginWorldY = 6.0 / (m_pixelsPerMeter * m_zoom);
         }
-        for (int i = 0; i < (int)m_textItems.size(); ++i) {
+        for (int i : calloutsNear(wpos, std::max(marginWorldX, marginWorldY))) {
             const auto &ti = m_textItems[i];
             QRectF hitRect = ti.boundingRect.adjusted(-marginWorldX, -marginWorldY, marginWorldX, marginWorldY);
             if (hitRect.contains(wpos)) {
@@ -1482,6 +1807,14 @@ void CanvasWidget::mouseMoveEvent(QMouseEvent* ev) {
         return;
     }
     if (m_mode == ToolMode::DefineScale && m_scaleDragPoint != 0) {
+        // Obszar punktów skali (i łączącej je linii) przed i po przesunięciu
+        const auto scalePoints = [this]() {
+            QPolygonF pts;
+            if (m_scaleHasFirst) pts << m_scaleFirstPoint;
+            if (m_scaleHasSecond) pts << m_scaleSecondPoint;
+            return pts;
+        };
+        QPolygonF dirtyPts = scalePoints();
         QPointF wpos = toWorld(ev->position());
         if (m_scaleDragPoint == 1) {
             if (m_scaleHasSecond && ev->modifiers().testFlag(Qt::ShiftModifier)) {
@@ -1504,7 +1837,8 @@ void CanvasWidget::mouseMoveEvent(QMouseEvent* ev) {
             }
             m_scaleSecondPoint = wpos;
         }
-        update();
+        dirtyPts << scalePoints();
+        requestUpdateRect(dirtyPts.boundingRect());
         return;
     }
     if (m_mode == ToolMode::AdjustBackground && m_bgDragging) {
@@ -1516,10 +1850,11 @@ void CanvasWidget::mouseMoveEvent(QMouseEvent* ev) {
                                          wpos.x() - m_bgRotateCenter.x()) * 180.0 / M_PI;
             m_bgRotationDeg = m_bgStartRotationDeg + (angleDeg - m_bgStartAngleDeg);
         }
-        update();
+        invalidateLayer(CanvasLayer::Background);
         return;
     }
     if (m_isResizingTempBubble) {
+        const QRect before = calloutScreenRect(m_tempTextItem);
         QPointF spos = ev->position();
         QRectF rect = m_resizeStartRect;
         const double minW = 40.0;
@@ -1555,10 +1890,11 @@ void CanvasWidget::mouseMoveEvent(QMouseEvent* ev) {
                                                           gapWorld);
         }
         repositionTempTextEdit();
-        update();
+        updateDirtyRect(before.united(calloutScreenRect(m_tempTextItem)));
         return;
     }
     if (m_isResizingSelectedBubble && hasSelectedText()) {
+        const QRect before = calloutScreenRect(m_textItems[m_selectedTextIndex]);
         QPointF spos = ev->position();
         QRectF rect = m_resizeStartRect;
         const double minW = 40.0;
@@ -1590,16 +1926,18 @@ void CanvasWidget::mouseMoveEvent(QMouseEvent* ev) {
             TextItem &ti = m_textItems[m_selectedTextIndex];
             ti.pos = clampAnchorOutsideBubble(ti.boundingRect, ti.pos, ti.anchor, gapWorld);
         }
+        updateCalloutIndex(m_selectedTextIndex);
         if (m_textEdit && m_editingTextIndex == m_selectedTextIndex) {
             m_textEdit->move(rect.topLeft().toPoint());
             m_textEdit->resize(std::max(40, (int)std::round(rect.width())),
                                std::max(20, (int)std::round(rect.height())));
         }
-        update();
+        invalidateCalloutRect(before, calloutScreenRect(m_textItems[m_selectedTextIndex]));
         return;
     }
     // Przeciąganie tymczasowego dymka w trybie InsertText
     if (m_mode == ToolMode::InsertText && m_hasTempTextItem) {
+        const QRect before = calloutScreenRect(m_tempTextItem);
         if (m_isDraggingTempBubble) {
             // Przesuwamy boundingRect względem kotwicy i korygujemy kotwicę
             // tak, aby pozostała poza dymkiem.
@@ -1616,7 +1954,7 @@ void CanvasWidget::mouseMoveEvent(QMouseEvent* ev) {
             }
             // Przesuń pole edycji
             repositionTempTextEdit();
-            update();
+            updateDirtyRect(before.united(calloutScreenRect(m_tempTextItem)));
             return;
         }
         if (m_isDraggingTempAnchor) {
@@ -1630,12 +1968,13 @@ void CanvasWidget::mouseMoveEvent(QMouseEvent* ev) {
                                                           wpos,
                                                           m_tempTextItem.anchor,
                                                           gapWorld);
-            update();
+            updateDirtyRect(before.united(calloutScreenRect(m_tempTextItem)));
             return;
         }
     }
     // Jeśli przeciągamy zaznaczony tekst w trybie zaznaczania lub jego kotwicę
     if (m_mode == ToolMode::Select && hasSelectedText()) {
+        const QRect before = calloutScreenRect(m_textItems[m_selectedTextIndex]);
         if (m_isDraggingSelectedText) {
             // Przeciąganie całego dymka – przesuwamy boundingRect i pilnujemy
             // aby kotwica nie znalazła się wewnątrz dymka.
@@ -1648,7 +1987,8 @@ void CanvasWidget::mouseMoveEvent(QMouseEvent* ev) {
                 double gapWorld = 12.0 / (m_pixelsPerMeter * m_zoom);
                 ti.pos = clampAnchorOutsideBubble(ti.boundingRect, ti.pos, ti.anchor, gapWorld);
             }
-            update();
+            updateCalloutIndex(m_selectedTextIndex);
+            invalidateCalloutRect(before, calloutScreenRect(ti));
             return;
         }
         if (m_isDraggingSelectedAnchor) {
@@ -1660,16 +2000,17 @@ void CanvasWidget::mouseMoveEvent(QMouseEvent* ev) {
                 ? 12.0 / (m_pixelsPerMeter * m_zoom)
                 : 0.0;
             ti.pos = clampAnchorOutsideBubble(ti.boundingRect, wpos, ti.anchor, gapWorld);
-            update();
+            updateCalloutIndex(m_selectedTextIndex);
+            invalidateCalloutRect(before, calloutScreenRect(ti));
             return;
         }
     }
     m_mouseWorld = toWorld(ev->position());
     m_hasMouseWorld = true;
+    // Narzędzie samo odświeża zmieniony fragment nakładki
     if (m_activeTool) {
         m_activeTool->mouseMove(ev, m_mouseWorld);
     }
-    update();
     QWidget::mouseMoveEvent(ev);
 }
 
@@ -1805,6 +2146,7 @@ void CanvasWidget::commitTextEdit() {
         if (text.isEmpty()) {
             m_textItems.erase(m_textItems.begin() + m_editingTextIndex);
             m_selectedTextIndex = -1;
+            rebuildCalloutIndex();
         } else {
             TextItem &ti = m_textItems[m_editingTextIndex];
             ti.text = text;
@@ -1821,13 +2163,14 @@ void CanvasWidget::commitTextEdit() {
                 y_m = ti.pos.y() - h_m;
             }
             ti.boundingRect = QRectF(x_m, y_m, w_m, h_m);
+            updateCalloutIndex(m_editingTextIndex);
             // Ustaw zaznaczenie na edytowany element
             m_selectedTextIndex = m_editingTextIndex;
             m_measurementsTool.clearSelection();
         }
         m_editingTextIndex = -1;
         m_mode = ToolMode::None;
-        update();
+        invalidateLayer(CanvasLayer::Callouts);
         emit measurementFinished();
         return;
     }
@@ -1835,7 +2178,7 @@ void CanvasWidget::commitTextEdit() {
     // nastąpiła próba zatwierdzenia bez wstawiania – po prostu
     // zakończ tryb
     m_mode = ToolMode::None;
-    update();
+    invalidateLayer(CanvasLayer::Callouts);
     emit measurementFinished();
 }
 
@@ -1937,6 +2280,7 @@ void CanvasWidget::commitTempTextItem() {
     m_textItems.push_back(m_tempTextItem);
     // Ustaw zaznaczenie na nowo dodany element
     m_selectedTextIndex = (int)m_textItems.size() - 1;
+    updateCalloutIndex(m_selectedTextIndex);
     m_measurementsTool.clearSelection();
     // Resetuj stan tymczasowego dymka
     m_hasTempTextItem = false;
@@ -1945,7 +2289,7 @@ void CanvasWidget::commitTempTextItem() {
     m_isTempBubblePinned = false;
     // Wróć do trybu None
     m_mode = ToolMode::None;
-    update();
+    invalidateLayer(CanvasLayer::Callouts);
     emit measurementFinished();
 }
 
@@ -1995,14 +2339,14 @@ void CanvasWidget::cancelTextEdit() {
     if (m_editingTextIndex >= 0) {
         m_editingTextIndex = -1;
         m_mode = ToolMode::None;
-        update();
+        invalidateLayer(CanvasLayer::Callouts);
         emit measurementFinished();
         return;
     }
     // Ogólne anulowanie: resetuj pozycję wstawiania i tryb
     m_hasTextInsertPos = false;
     m_mode = ToolMode::None;
-    update();
+    invalidateLayer(CanvasLayer::Callouts);
     emit measurementFinished();
 }
 
@@ -2091,7 +2435,7 @@ void CanvasWidget::keyPressEvent(QKeyEvent* ev) {
                 m_isDraggingSelectedText = false;
                 m_isDraggingSelectedAnchor = false;
                 unsetCursor();
-                update();
+                invalidateLayer(CanvasLayer::Callouts);
             }
             break;
         default: QWidget::keyPressEvent(ev);
@@ -2143,8 +2487,10 @@ void CanvasWidget::applyScaleFromPoints(QWidget* parent) {
 
     double oldPixelsPerMeter = m_pixelsPerMeter;
     m_pixelsPerMeter = distPx / val;
+    // Rozmiar dymków w świecie zależy od skali
+    rebuildCalloutIndex();
     m_measurementsTool.recalculateLengths();
-    update();
+    invalidateAllLayers();
 }
 
 void CanvasWidget::scaleCanvasContents(double factor) {
@@ -2155,15 +2501,14 @@ void CanvasWidget::scaleCanvasContents(double factor) {
     QPointF worldCenter = toWorld(screenCenter);
     m_measurementsTool.scaleContent(factor);
     for (auto &txt : m_textItems) {
-        txt.pos.setX(txt.pos.x() * factor);
-        txt.pos.setY(txt.pos.y() * factor);
+        txt.pos *= factor;
         QPointF topLeft = txt.boundingRect.topLeft() * factor;
         QPointF bottomRight = txt.boundingRect.bottomRight() * factor;
         txt.boundingRect = QRectF(topLeft, bottomRight).normalized();
     }
+    rebuildCalloutIndex();
     if (m_hasTempTextItem) {
-        m_tempTextItem.pos.setX(m_tempTextItem.pos.x() * factor);
-        m_tempTextItem.pos.setY(m_tempTextItem.pos.y() * factor);
+        m_tempTextItem.pos *= factor;
         QPointF topLeft = m_tempTextItem.boundingRect.topLeft() * factor;
         QPointF bottomRight = m_tempTextItem.boundingRect.bottomRight() * factor;
         m_tempTextItem.boundingRect = QRectF(topLeft, bottomRight).normalized();
@@ -2178,6 +2523,9 @@ void CanvasWidget::scaleCanvasContents(double factor) {
                            std::max(20, (int)std::round(sizePx.height())));
     }
     m_viewOffset = screenCenter - (worldCenter * factor) * m_zoom;
+    // Zmienia się geometria wszystkich warstw, a nie tylko przesunięcie
+    // widoku – buforów nie można przewinąć, trzeba je odrysować.
+    invalidateAllLayers();
 }
 
 void CanvasWidget::openReportDialog(QWidget* parent)
@@ -7,14 +7,23 @@
 #include <QRectF>
 #include <QTextEdit>
 #include <QDateTime>
+#include <memory>
 #include <vector>
 #include <unordered_map>
 #include "MeasurementsTool.h"
 #include "Settings.h"
+#include "BackgroundStore.h"
+#include "BackgroundLoader.h"
+#include "RotatedBackgroundCache.h"
+#include "LayerCompositor.h"
+#include "CalloutIndex.h"
+#include "PaintProfiler.h"
+#include <QFutureWatcher>
 
 class QWheelEvent;
 class QMainWindow;
 class ReportDialog;
+class PdfBackgroundRenderer;
 
 // Tryb aktywnego narzędzia na płótnie.  Umożliwiamy teraz także zaznaczanie,
 // wstawianie tekstu i usuwanie obiektów.  Wartości te kontrolują
@@ -38,6 +47,8 @@ enum class ToolMode {
  */
 enum class CalloutAnchor { Bottom, Top, Left, Right };
 
+struct CalloutRenderCache;
+
 // Pomocnicza struktura przechowująca tekst wstawiony na płótnie.  Każdy
 // element zawiera pozycję w współrzędnych świata (world) oraz treść
 // tekstu.  Tekst nie jest związany z żadnym pomiarem; jest rysowany
@@ -84,6 +95,13 @@ struct TextItem {
      * kontur.  Linie obramowania są rysowane w tej barwie.
      */
     QColor borderColor = Qt::black;
+
+    /**
+     * Zapamiętana ścieżka dymka i układ tekstu (patrz drawCallout).
+     * Odświeżana przy rysowaniu, gdy zmieni się treść, czcionka, kotwica,
+     * geometria albo skala widoku.
+     */
+    mutable std::shared_ptr<const CalloutRenderCache> renderCache;
 };
 
 class AdvancedMeasureDialog;
@@ -96,15 +114,43 @@ public:
     explicit CanvasWidget(QWidget* parent, ProjectSettings* settings);
 
     // Background
-    bool loadBackgroundFile(const QString& file);
-    bool loadBackgroundImage(const QString& file, QImage& image) const;
+    /**
+     * Wczytuje podkład w wątku roboczym.  Postęp jest zgłaszany sygnałem
+     * backgroundLoadProgress, a do czasu zakończenia płótno wyświetla
+     * szybki podgląd w obniżonej rozdzielczości (jeśli był dostępny).
+     * Trwające wcześniej wczytywanie jest anulowane.
+     */
+    void loadBackgroundFileAsync(const QString& file);
+    void cancelBackgroundLoad();
+    /**
+     * Ustawia podkład z gotowego wyniku wczytywania (raster, piramida
+     * oraz ewentualnie otwarty dokument PDF).  Przesunięcie i obrót
+     * podkładu są zerowane.
+     */
+    void setLoadedBackground(const BackgroundLoadResult& result);
+    bool isLoadingBackground() const { return m_bgLoadWatcher != nullptr; }
     void toggleBackgroundVisibility();
     void setBackgroundVisible(bool visible);
     bool hasBackground() const;
     bool isBackgroundVisible() const;
     void clearBackground();
+    /**
+     * Ustawia podkład z gotowego obrazu.  Blokuje wywołujący wątek na czas
+     * liczenia skrótu pikseli i budowy piramidy – dla plików należy używać
+     * loadBackgroundFileAsync.
+     */
     void setBackgroundImage(const QImage& image);
-    const QImage& backgroundImage() const;
+    /// Rozmiar rastra podkładu (pusty bez podkładu).
+    QSize backgroundSize() const;
+    /**
+     * Podkład współdzielony z magazynu projektu.  Przypisanie tego samego
+     * uchwytu do wielu pięter nie kopiuje obrazu; przesunięcie, obrót
+     * i przezroczystość pozostają ustawieniami danego płótna.
+     */
+    BackgroundHandle backgroundAsset() const { return m_bgAsset; }
+    void setBackgroundAsset(const BackgroundHandle& asset);
+    /// Magazyn podkładów projektu; bez niego płótno tworzy prywatne podkłady.
+    void setBackgroundStore(std::shared_ptr<BackgroundStore> store);
     void setBackgroundOpacity(double opacity);
     double backgroundOpacity() const;
     void startBackgroundAdjust();
@@ -124,6 +170,23 @@ public:
     bool scaleHasSecondPoint() const;
     int scaleStep() const;
     void toggleMeasuresVisibility();
+    /// Ustawia powiększenie (ograniczone jak przy kółku myszy) i przesunięcie widoku.
+    void setView(double zoom, const QPointF& viewOffset);
+    QPointF viewOffset() const { return m_viewOffset; }
+
+    // Zawartość płótna (wczytywanie projektu, testy wydajności)
+    MeasurementsTool& measurementsTool() { return m_measurementsTool; }
+    const MeasurementsTool& measurementsTool() const { return m_measurementsTool; }
+    /// Dodaje gotowy dymek (współrzędne świata); zwraca jego indeks.
+    int addTextItem(const TextItem& item);
+    const std::vector<TextItem>& textItems() const { return m_textItems; }
+
+    // Profiler rysowania (nakładka ze statystykami klatek)
+    void setPaintProfilerVisible(bool visible);
+    bool isPaintProfilerVisible() const;
+    /// Zapisuje statystyki profilera do pliku CSV; false przy błędzie zapisu.
+    bool exportPaintProfile(const QString& path) const;
+    int paintProfileFrameCount() const;
 
     // Measurements
     void startMeasureLinear();
@@ -135,6 +198,9 @@ signals:
     void scaleStateChanged(int step, bool hasFirst, bool hasSecond);
     void scaleFinished();
     void backgroundAdjustFinished();
+    void backgroundLoadProgress(int percent);
+    void backgroundLoadFinished(bool success);
+    void backgroundLoadCanceled();
 
 protected:
     void paintEvent(QPaintEvent*) override;
@@ -152,11 +218,45 @@ private:
     void emitScaleStateChanged();
     void scaleCanvasContents(double factor);
     void applyBackgroundTransform(QPainter& painter) const;
+    void paintTransformedBackground(QPainter& painter, const QRectF& visibleWorld,
+                                    double deviceZoom) const;
+    QTransform backgroundTransform(const QSize& bgSize) const;
+    void setPdfRenderer(PdfBackgroundRenderer* renderer);
+    void applyLoadedBackground(const BackgroundHandle& asset);
+    void setBackgroundAssetInternal(const BackgroundHandle& asset);
+    void onBackgroundLoadResult(int index);
+    void onBackgroundLoadFinished();
     // Settings
     ProjectSettings* m_settings = nullptr;
 
+    // Buforowane warstwy płótna (podkład, pomiary, dymki); nakładka
+    // narzędzi jest rysowana na nich w każdej klatce.
+    LayerCompositor m_layers;
+    // Statystyki klatek; zbierane także w stałych metodach rysujących.
+    mutable PaintProfiler m_profiler;
+    // Obszar panelu profilera z ostatniej klatki (dołączany do odświeżeń)
+    QRect m_hudRect;
+
     // Background
-    QImage m_bgImage;
+    // Podkład (raster i piramida kafelków) współdzielony przez magazyn
+    // projektu; rysowane są tylko kafelki widoczne w oknie, z poziomu
+    // piramidy dobranego do m_zoom.
+    BackgroundHandle m_bgAsset;
+    std::shared_ptr<BackgroundStore> m_bgStore;
+    // Kafelki obróconego podkładu (z wbudowaną przezroczystością).  Klucz
+    // obejmuje podkład, przesunięcie, obrót i przezroczystość.
+    mutable RotatedBackgroundCache m_bgRotatedCache;
+    // Otwarty dokument PDF podkładu (tylko dla podkładów z PDF).  Przy
+    // dużym powiększeniu dorenderowuje widoczny fragment wektorowo.
+    PdfBackgroundRenderer* m_pdfRenderer = nullptr;
+    // Położenie ostatniego ostrego kafelka PDF (piksele rastra podkładu);
+    // przy nowym kafelku unieważniamy tylko obszar starego i nowego.
+    QRectF m_pdfTileRect;
+    // Wczytywanie w tle: obserwator zadania oraz podgląd wyświetlany do
+    // czasu otrzymania pełnego rastra (rysowany w rozmiarze m_bgPreviewSize).
+    QFutureWatcher<BackgroundLoadResult>* m_bgLoadWatcher = nullptr;
+    QImage m_bgPreview;
+    QSize m_bgPreviewSize;
     bool m_showBackground = true;
     double m_bgOpacity = 1.0;
     QPointF m_bgOffset{0,0};
@@ -208,6 +308,10 @@ private:
     // Lista tekstów wstawionych na płótnie.  Każdy wpis przechowuje
     // pozycję i treść.  Teksty są rysowane w drawTextItems().
     std::vector<TextItem> m_textItems;
+    // Siatka prostokątów obejmujących m_textItems (testy trafienia myszą).
+    // Aktualizowana przy każdej zmianie geometrii dymka; po usunięciu
+    // elementu budowana od nowa.
+    CalloutIndex m_calloutIndex;
 
     // --- Wstawianie nowego dymka tekstowego w trybie InsertText ---
     // Flagę ustawiamy na true po pierwszym kliknięciu na płótnie w trybie
@@ -341,13 +445,42 @@ public:
      */
     QPointF toWorld(const QPointF& screen) const override;
     QPointF toScreen(const QPointF& world) const override;
+    /// Obszar świata widoczny w oknie płótna.
+    QRectF visibleWorldRect() const override;
     double zoom() const override { return m_zoom; }
     double pixelsPerMeter() const override { return m_pixelsPerMeter; }
     ProjectSettings* settings() const override { return m_settings; }
     bool isLayerVisible(const QString& layer) const override;
+    QFont overlayFont() const override { return font(); }
     void requestUpdate() override { update(); }
+    void requestUpdateRect(const QRectF& worldRect) override;
+    void invalidateLayer(CanvasLayer layer) override;
+    void invalidateLayerRect(CanvasLayer layer, const QRectF& worldRect) override;
+    void invalidateAllLayers();
+    /**
+     * Prostokąt ekranu (z marginesem na grubość pióra i uchwyty)
+     * obejmujący podany prostokąt świata.
+     */
+    QRect worldToScreenRect(const QRectF& worldRect) const;
+    /// Odświeża fragment widżetu (wraz z panelem profilera, gdy jest włączony).
+    void updateDirtyRect(const QRect& rect);
+    /// Obszar ekranu zajmowany przez dymek wraz ze strzałką i uchwytami.
+    QRect calloutScreenRect(const TextItem& item) const;
+    void invalidateCalloutRect(const QRect& before, const QRect& after);
+    /// Prostokąt świata obejmujący dymek i koniec strzałki (do indeksu).
+    QRectF calloutWorldEnvelope(const TextItem& item) const;
+    void updateCalloutIndex(int index);
+    void rebuildCalloutIndex();
+    /**
+     * Indeksy dymków (rosnąco), które mogą leżeć w odległości
+     * toleranceWorld od punktu; właściwy test wykonuje wywołujący.
+     */
+    std::vector<int> calloutsNear(const QPointF& world, double toleranceWorld) const;
     void drawOverlay(QPainter& p);
     void drawTextItems(QPainter& p);
+    void drawTempTextItem(QPainter& p);
+    void drawCallout(QPainter& p, const TextItem& txt, bool selected, double handleRadius);
+    const CalloutRenderCache& calloutRenderCache(const TextItem& txt, const QFont& font) const;
 
     // --- Zaznaczanie i manipulacja tekstem ---
 public:
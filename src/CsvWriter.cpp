@@ -0,0 +1,172 @@
+#include "CsvWriter.h"
+
+#include <QColor>
+#include <QDateTime>
+#include <QIODevice>
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+CsvWriter::CsvWriter(QIODevice* device, char separator, QByteArray lineEnd, size_t bufferSize)
+    : m_device(device), m_separator(separator), m_lineEnd(std::move(lineEnd)),
+      m_buffer(std::max<size_t>(bufferSize, 256)) {
+    m_ok = m_device != nullptr;
+}
+
+CsvWriter::~CsvWriter() {
+    flush();
+}
+
+bool CsvWriter::flush() {
+    if (m_used == 0 || !m_ok) {
+        m_used = 0;
+        return m_ok;
+    }
+    const qint64 written = m_device->write(m_buffer.data(), qint64(m_used));
+    m_ok = written == qint64(m_used);
+    m_used = 0;
+    return m_ok;
+}
+
+void CsvWriter::writeBom() {
+    putAscii("\xEF\xBB\xBF", 3);
+}
+
+void CsvWriter::beginField() {
+    if (m_rowStarted) {
+        reserve(1);
+        put(m_separator);
+    }
+    m_rowStarted = true;
+}
+
+void CsvWriter::endRow() {
+    putAscii(m_lineEnd.constData(), size_t(m_lineEnd.size()));
+    m_rowStarted = false;
+}
+
+void CsvWriter::putAscii(const char* text, size_t length) {
+    while (length > 0) {
+        reserve(std::min(length, m_buffer.size()));
+        const size_t n = std::min(length, m_buffer.size() - m_used);
+        std::copy(text, text + n, m_buffer.data() + m_used);
+        m_used += n;
+        text += n;
+        length -= n;
+    }
+}
+
+void CsvWriter::putUtf8(QStringView text, bool quoted) {
+    const char16_t* p = text.utf16();
+    const char16_t* end = p + text.size();
+    while (p < end) {
+        // Najdłuższy zapis znaku to 4 bajty, cudzysłów podwojony – 2
+        reserve(4);
+        const char16_t c = *p++;
+        if (c < 0x80) {
+            if (quoted && c == u'"') {
+                put('"');
+            }
+            put(char(c));
+        } else if (c < 0x800) {
+            put(char(0xC0 | (c >> 6)));
+            put(char(0x80 | (c & 0x3F)));
+        } else if (QChar::isHighSurrogate(c) && p < end && QChar::isLowSurrogate(*p)) {
+            const char32_t u = QChar::surrogateToUcs4(c, *p++);
+            put(char(0xF0 | (u >> 18)));
+            put(char(0x80 | ((u >> 12) & 0x3F)));
+            put(char(0x80 | ((u >> 6) & 0x3F)));
+            put(char(0x80 | (u & 0x3F)));
+        } else {
+            // Samotny surogat zapisujemy jak QString::toUtf8() – znakiem zastępczym
+            const char16_t u = QChar::isSurrogate(c) ? char16_t(QChar::ReplacementCharacter) : c;
+            put(char(0xE0 | (u >> 12)));
+            put(char(0x80 | ((u >> 6) & 0x3F)));
+            put(char(0x80 | (u & 0x3F)));
+        }
+    }
+}
+
+void CsvWriter::field(QStringView text) {
+    beginField();
+    const bool quoted = std::any_of(text.begin(), text.end(), [this](QChar c) {
+        return c == QLatin1Char(m_separator) || c == u'"' || c == u'\n' || c == u'\r';
+    });
+    if (quoted) {
+        reserve(1);
+        put('"');
+    }
+    putUtf8(text, quoted);
+    if (quoted) {
+        reserve(1);
+        put('"');
+    }
+}
+
+void CsvWriter::field(qint64 value) {
+    beginField();
+    char digits[24];
+    const auto res = std::to_chars(digits, digits + sizeof(digits), value);
+    putAscii(digits, size_t(res.ptr - digits));
+}
+
+void CsvWriter::field(double value, int decimals, const char* suffix) {
+    beginField();
+    char digits[64];
+    const auto res = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::fixed,
+                                   std::clamp(decimals, 0, 17));
+    if (res.ec == std::errc()) {
+        putAscii(digits, size_t(res.ptr - digits));
+    } else {
+        // Bardzo duże wartości nie mieszczą się w buforze – rzadki przypadek
+        const QByteArray text = QByteArray::number(value, 'f', std::clamp(decimals, 0, 17));
+        putAscii(text.constData(), size_t(text.size()));
+    }
+    if (suffix) {
+        putAscii(suffix, std::strlen(suffix));
+    }
+}
+
+void CsvWriter::fieldColor(const QColor& color) {
+    beginField();
+    static const char hex[] = "0123456789abcdef";
+    const QRgb rgb = color.rgb();
+    const int channels[3] = {qRed(rgb), qGreen(rgb), qBlue(rgb)};
+    char text[7] = {'#'};
+    for (int i = 0; i < 3; ++i) {
+        text[1 + 2 * i] = hex[channels[i] >> 4];
+        text[2 + 2 * i] = hex[channels[i] & 0xF];
+    }
+    putAscii(text, sizeof(text));
+}
+
+void CsvWriter::fieldDateTime(const QDateTime& dateTime) {
+    beginField();
+    if (!dateTime.isValid()) {
+        return;
+    }
+    const QDate date = dateTime.date();
+    const QTime time = dateTime.time();
+    if (date.year() < 0 || date.year() > 9999) {
+        const QByteArray text = dateTime.toString(QStringLiteral("yyyy-MM-dd hh:mm")).toUtf8();
+        putAscii(text.constData(), size_t(text.size()));
+        return;
+    }
+    auto two = [](char* out, int v) {
+        out[0] = char('0' + v / 10);
+        out[1] = char('0' + v % 10);
+    };
+    char text[16];
+    two(text, date.year() / 100);
+    two(text + 2, date.year() % 100);
+    text[4] = '-';
+    two(text + 5, date.month());
+    text[7] = '-';
+    two(text + 8, date.day());
+    text[10] = ' ';
+    two(text + 11, time.hour());
+    text[13] = ':';
+    two(text + 14, time.minute());
+    putAscii(text, sizeof(text));
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <QByteArray>
+#include <QStringView>
+#include <vector>
+
+class QColor;
+class QDateTime;
+class QIODevice;
+
+/**
+ * Strumieniowy zapis CSV do urządzenia (np. QFile) przez własny bufor.
+ * Pola są kodowane w UTF-8 i w razie potrzeby cytowane bezpośrednio
+ * do bufora, bez tymczasowych QString i list na wiersz; liczby są
+ * formatowane przez std::to_chars, więc zawsze z kropką dziesiętną,
+ * niezależnie od ustawień regionalnych.
+ *
+ * Błąd zapisu jest zapamiętywany (ok()); kolejne wywołania niczego już
+ * nie zapisują.  Destruktor opróżnia bufor.
+ */
+class CsvWriter {
+public:
+    explicit CsvWriter(QIODevice* device, char separator = ';', QByteArray lineEnd = "\r\n",
+                       size_t bufferSize = 64 * 1024);
+    ~CsvWriter();
+    CsvWriter(const CsvWriter&) = delete;
+    CsvWriter& operator=(const CsvWriter&) = delete;
+
+    /// Znacznik kolejności bajtów UTF-8 (Excel rozpoznaje po nim kodowanie).
+    void writeBom();
+
+    void field(QStringView text);
+    void field(int value) { field(qint64(value)); }
+    void field(qint64 value);
+    /// Liczba w zapisie stałoprzecinkowym z decimals miejscami i opcjonalnym sufiksem (np. " cm").
+    void field(double value, int decimals, const char* suffix = nullptr);
+    /// Kolor jako #rrggbb (jak QColor::name()).
+    void fieldColor(const QColor& color);
+    /// Data w formacie yyyy-MM-dd hh:mm; pusta dla nieprawidłowej.
+    void fieldDateTime(const QDateTime& dateTime);
+    void endRow();
+
+    /// Zapisuje zawartość bufora; false po błędzie zapisu.
+    bool flush();
+    bool ok() const { return m_ok; }
+
+private:
+    void beginField();
+    /// Zapewnia co najmniej n wolnych bajtów w buforze.
+    void reserve(size_t n) {
+        if (m_used + n > m_buffer.size()) {
+            flush();
+        }
+    }
+    void put(char c) { m_buffer[m_used++] = c; }
+    void putAscii(const char* text, size_t length);
+    void putUtf8(QStringView text, bool quoted);
+
+    QIODevice* m_device = nullptr;
+    char m_separator = ';';
+    QByteArray m_lineEnd;
+    std::vector<char> m_buffer;
+    size_t m_used = 0;
+    bool m_rowStarted = false;
+    bool m_ok = true;
+};
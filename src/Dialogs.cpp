@@ -2,6 +2,10 @@
 #include "Dialogs.h"
 #include "Settings.h"
 #include "Measurements.h"
+#include "MeasureReportModel.h"
+#include "ExportManager.h"
+#include "CsvWriter.h"
+#include "Trace.h"
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -25,7 +29,9 @@
 #include <QAbstractTextDocumentLayout>
 #include <QPrinter>
 #include <QPainter>
+#include <QTableView>
 #include <QTableWidget>
+#include <QComboBox>
 #include <QHeaderView>
 #include <QApplication>
 #include <QDateTime>
@@ -35,6 +41,7 @@
 #include <QFont>
 #include <QInputDialog>
 #include <algorithm>
+#include <optional>
 #include <QPdfWriter>
 #include <QPageLayout>
 #include <QTextDocument>
@@ -147,6 +154,47 @@ FinalBufferDialog::FinalBufferDialog(QWidget* parent, ProjectSettings* settings)
 }
 double FinalBufferDialog::bufferValue() const { return m_buffer ? m_buffer->value() : 0.0; }
 
+// -------- MeasureSettingsDialog --------
+MeasureSettingsDialog::MeasureSettingsDialog(QWidget* parent, const ProjectSettings& settings)
+    : QDialog(parent), m_chosen(settings.defaultMeasureColor) {
+    setWindowTitle(QString::fromUtf8("Ustawienia pomiarów"));
+    auto lay = new QVBoxLayout(this);
+    auto form = new QFormLayout();
+    m_decimals = new QSpinBox();
+    m_decimals->setRange(0, 3);
+    m_decimals->setValue(settings.decimals);
+    m_lineWidth = new QSpinBox();
+    m_lineWidth->setRange(1, 8);
+    m_lineWidth->setValue(settings.lineWidthPx);
+    m_colorBtn = new QPushButton(QString::fromUtf8("Wybierz kolor…"));
+    m_applyExisting = new QCheckBox(QString::fromUtf8("Zastosuj kolor i grubość do istniejących pomiarów"));
+    form->addRow(QString::fromUtf8("Miejsca po przecinku:"), m_decimals);
+    form->addRow(QString::fromUtf8("Kolor domyślny:"), m_colorBtn);
+    form->addRow(QString::fromUtf8("Grubość linii:"), m_lineWidth);
+    lay->addLayout(form);
+    lay->addWidget(m_applyExisting);
+    auto buttons = new QDialogButtonBox(QDialogButtonBox::Ok|QDialogButtonBox::Cancel);
+    lay->addWidget(buttons);
+    QObject::connect(m_colorBtn, &QPushButton::clicked, this, [this](){
+        QColor c = QColorDialog::getColor(m_chosen, this, QString::fromUtf8("Kolor linii"));
+        if (c.isValid()) m_chosen = c;
+    });
+    QObject::connect(buttons, &QDialogButtonBox::accepted, this, &QDialog::accept);
+    QObject::connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+}
+
+ProjectSettings MeasureSettingsDialog::settings() const {
+    ProjectSettings s;
+    s.decimals = m_decimals->value();
+    s.defaultMeasureColor = m_chosen;
+    s.lineWidthPx = m_lineWidth->value();
+    return s;
+}
+
+bool MeasureSettingsDialog::applyToExisting() const {
+    return m_applyExisting->isChecked();
+}
+
 // -------- EditMeasureDialog --------
 EditMeasureDialog::EditMeasureDialog(QWidget* parent, ProjectSettings* settings, Measure* measure)
 : QDialog(parent), m_settings(settings), m(measure) {
@@ -190,180 +238,58 @@ EditMeasureDialog::EditMeasureDialog(QWidget* parent, ProjectSettings* settings,
         // Po zmianie zapasów oblicz ponownie długość z zapasami.  Całkowita
         // długość obejmuje długość, globalny zapas, zapas początkowy i zapas
         // końcowy.
-        m->totalWithBufferMeters = m->lengthMeters + m->bufferGlobalMeters + m->bufferDefaultMeters + m->bufferFinalMeters;
+        m->updateTotal();
         accept();
     });
     QObject::connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
 }
 
 // -------- ReportDialog --------
-ReportDialog::ReportDialog(QWidget* parent, ProjectSettings* settings, std::vector<Measure>* measures)
-: QDialog(parent), m_settings(settings), m_measures(measures) {
-    const int COL_CHECK   = 0;
-    const int COL_ID      = 1;
-    const int COL_NAME    = 2;
-    const int COL_TYPE    = 3;
-    const int COL_LEN_M   = 4;
-    const int COL_SUM_M   = 5;
-    const int COL_BUF_START = 6;
-    const int COL_BUF_END   = 7;
-    const int COL_COLOR = 8;
-    const int COL_DATE = 9;
-    const int COL_EDIT = 10;
-    const int COL_DEL = 11;
+ReportDialog::ReportDialog(QWidget* parent, ProjectSettings* settings, std::vector<Measure>* measures,
+                           MeasureTotals* totals)
+: QDialog(parent), m_settings(settings) {
+    TRACE_SCOPE("ReportDialog::ReportDialog");
+    using Col = MeasureReportModel;
 
     setWindowTitle(QString::fromUtf8("Raport pomiarów"));
     auto lay = new QVBoxLayout(this);
-    m_table = new QTableWidget(this);
-    // Zbuduj listę nagłówków z jednostką cm
-    const QString unitLabel = QStringLiteral("cm");
-    QStringList headers = {
-        QStringLiteral("Check"),
-        QStringLiteral("ID"),
-        QString::fromUtf8("Nazwa"),
-        QString::fromUtf8("Typ"),
-        // Nagłówek długości wraz z jednostką
-        QString::fromUtf8("Długość [%1]").arg(unitLabel),
-        // Nagłówek sumy (długość + zapasy) z jednostką
-        QString::fromUtf8("Suma z zapasami [%1]").arg(unitLabel),
-        // Zapas domyślny (początkowy) z jednostką
-        QString::fromUtf8("Zapas początkowy [%1]").arg(unitLabel),
-        // Zapas końcowy z jednostką
-        QString::fromUtf8("Zapas końcowy [%1]").arg(unitLabel),
-        QString::fromUtf8("Kolor"),
-        QString::fromUtf8("Data"),
-        QString::fromUtf8("Edytuj"),
-        QString::fromUtf8("Usuń")
-    };
-    m_table->setColumnCount(headers.size());
-    m_table->setHorizontalHeaderLabels(headers);
-    m_table->horizontalHeader()->setStretchLastSection(false);
-    m_table->verticalHeader()->setVisible(false);
-    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
-    m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
-    m_table->setRowCount((int)measures->size());
-
-    auto typeStr = [](const Measure& m)->QString{
-        switch (m.type) {
-            case MeasureType::Linear: return QString::fromUtf8("Liniowy");
-            case MeasureType::Polyline: return QString::fromUtf8("Polilinia");
-            case MeasureType::Advanced: default: return QString::fromUtf8("Zaawansowany");
-        }
-    };
-
-    for (int r=0;r<(int)measures->size();++r) {
-        const auto& m = (*measures)[r];
-        auto chk = new QTableWidgetItem();
-        chk->setFlags(Qt::ItemIsEnabled | Qt::ItemIsUserCheckable | Qt::ItemIsSelectable);
-        chk->setCheckState(Qt::Checked);
-        m_table->setItem(r, COL_CHECK, chk);
-        auto set = [&](int c, const QString& t){ m_table->setItem(r,c, new QTableWidgetItem(t)); };
-        set(COL_ID, QString::number(m.id));
-        set(COL_NAME, m.name);
-        set(COL_TYPE, typeStr(m));
-        // Formatowanie długości i sumy w cm
-        QString lenStr;
-        QString sumStr;
-        double lenVal = m.lengthMeters;
-        double sumVal = m.totalWithBufferMeters;
-        lenStr = QString("%1 cm").arg(lenVal, 0, 'f', m_settings->decimals);
-        sumStr = QString("%1 cm").arg(sumVal, 0, 'f', m_settings->decimals);
-        QTableWidgetItem* itLen = new QTableWidgetItem(lenStr);
-        itLen->setData(Qt::UserRole + 1, lenVal);
-        m_table->setItem(r, COL_LEN_M, itLen);
-        QTableWidgetItem* itSum = new QTableWidgetItem(sumStr);
-        itSum->setData(Qt::UserRole + 1, sumVal);
-        m_table->setItem(r, COL_SUM_M, itSum);
-        // Zapas początkowy i końcowy również w cm
-        double bufStartVal = m.bufferDefaultMeters;
-        double bufEndVal   = m.bufferFinalMeters;
-        QString bufStartStr;
-        QString bufEndStr;
-        bufStartStr = QString("%1 cm").arg(bufStartVal, 0, 'f', m_settings->decimals);
-        bufEndStr   = QString("%1 cm").arg(bufEndVal,   0, 'f', m_settings->decimals);
-        QTableWidgetItem* itBufStart = new QTableWidgetItem(bufStartStr);
-        itBufStart->setData(Qt::UserRole + 1, bufStartVal);
-        m_table->setItem(r, COL_BUF_START, itBufStart);
-        QTableWidgetItem* itBufEnd = new QTableWidgetItem(bufEndStr);
-        itBufEnd->setData(Qt::UserRole + 1, bufEndVal);
-        m_table->setItem(r, COL_BUF_END, itBufEnd);
-        // Kolor: wypełnij tło komórki i zapisz hex w Qt::UserRole
-        {
-            QString hex = m.color.name();
-            QTableWidgetItem *it = new QTableWidgetItem(QString());
-            it->setBackground(QBrush(QColor(hex)));
-            it->setData(Qt::UserRole, hex);
-            m_table->setItem(r, COL_COLOR, it);
+    // Model czyta pomiary bezpośrednio z listy narzędzia; widok pobiera
+    // wiersze porcjami, więc czas otwarcia nie zależy od liczby pomiarów.
+    m_model = new MeasureReportModel(measures, settings, totals, this);
+    m_view = new QTableView(this);
+    m_view->setModel(m_model);
+    m_view->horizontalHeader()->setStretchLastSection(false);
+    m_view->verticalHeader()->setVisible(false);
+    m_view->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_view->setSelectionBehavior(QAbstractItemView::SelectRows);
+
+    // Przyciski „Edytuj” i „Usuń” rysuje delegat – bez widżetu na wiersz
+    auto editDelegate = new ReportButtonDelegate(QString::fromUtf8("Edytuj"), m_view);
+    auto delDelegate = new ReportButtonDelegate(QString::fromUtf8("Usuń"), m_view);
+    m_view->setItemDelegateForColumn(Col::ColEdit, editDelegate);
+    m_view->setItemDelegateForColumn(Col::ColDelete, delDelegate);
+
+    QObject::connect(editDelegate, &ReportButtonDelegate::clicked, this, [this](const QModelIndex& idx) {
+        const int row = idx.row();
+        if (row < 0 || row >= m_model->measureCount()) return;
+        Measure& ref = m_model->measureAt(row);
+        const Measure before = ref;
+        EditMeasureDialog ed(this, m_settings, &ref);
+        if (ed.exec()==QDialog::Accepted) {
+            // Przelicz całkowitą długość z zapasami.  Obejmuje
+            // długość, globalny zapas, zapas początkowy i końcowy.
+            ref.updateTotal();
+            m_model->measureEdited(row, before);
         }
-        set(COL_DATE, m.createdAt.toString("yyyy-MM-dd hh:mm"));
-
-        // removed unused colorCell widget; the color is now represented by the table item itself
-        
-        auto btnEdit = new QPushButton(QString::fromUtf8("Edytuj"));
-        m_table->setCellWidget(r, COL_EDIT, btnEdit);
-        QObject::connect(btnEdit, &QPushButton::clicked, this, [=]() {
-            // Pobierz aktualny indeks wiersza przy kliknięciu, aby uniknąć błędu
-            int row = m_table->indexAt(btnEdit->pos()).row();
-            if (row < 0 || row >= m_table->rowCount()) return;
-            Measure& ref = (*m_measures)[row];
-            EditMeasureDialog ed(this, m_settings, &ref);
-            if (ed.exec()==QDialog::Accepted) {
-                // Przelicz całkowitą długość z zapasami.  Obejmuje
-                // długość, globalny zapas, zapas początkowy i końcowy.
-                ref.totalWithBufferMeters = ref.lengthMeters + ref.bufferGlobalMeters + ref.bufferDefaultMeters + ref.bufferFinalMeters;
-                // Aktualizuj widoczne komórki w cm
-                m_table->item(row,COL_NAME)->setText(ref.name);
-                double lenVal = ref.lengthMeters;
-                double sumVal = ref.totalWithBufferMeters;
-                QString lenStr;
-                QString sumStr;
-                lenStr = QString("%1 cm").arg(lenVal, 0, 'f', m_settings->decimals);
-                sumStr = QString("%1 cm").arg(sumVal, 0, 'f', m_settings->decimals);
-                QTableWidgetItem* itLen = m_table->item(row, COL_LEN_M);
-                itLen->setText(lenStr);
-                itLen->setData(Qt::UserRole + 1, lenVal);
-                QTableWidgetItem* itSum = m_table->item(row, COL_SUM_M);
-                itSum->setText(sumStr);
-                itSum->setData(Qt::UserRole + 1, sumVal);
-                // Zapas początkowy i końcowy
-                double bufStartVal = ref.bufferDefaultMeters;
-                double bufEndVal   = ref.bufferFinalMeters;
-                QString bufStartStr;
-                QString bufEndStr;
-                bufStartStr = QString("%1 cm").arg(bufStartVal, 0, 'f', m_settings->decimals);
-                bufEndStr   = QString("%1 cm").arg(bufEndVal,   0, 'f', m_settings->decimals);
-                QTableWidgetItem* itBufStart = m_table->item(row, COL_BUF_START);
-                itBufStart->setText(bufStartStr);
-                itBufStart->setData(Qt::UserRole + 1, bufStartVal);
-                QTableWidgetItem* itBufEnd = m_table->item(row, COL_BUF_END);
-                itBufEnd->setText(bufEndStr);
-                itBufEnd->setData(Qt::UserRole + 1, bufEndVal);
-                // Aktualizuj kolor
-                if (QTableWidgetItem *colorItem = m_table->item(row, COL_COLOR)) {
-                    colorItem->setBackground(QBrush(ref.color));
-                    colorItem->setData(Qt::UserRole, ref.color.name());
-                }
-                recalc();
-            }
-        });
-
-        auto btnDel = new QPushButton(QString::fromUtf8("Usuń"));
-        m_table->setCellWidget(r, COL_DEL, btnDel);
-        QObject::connect(btnDel, &QPushButton::clicked, this, [this, btnDel]() {
-            // Ustal faktyczny wiersz klikniętego przycisku
-            int row = m_table->indexAt(btnDel->pos()).row();
-            if (row < 0 || row >= m_table->rowCount()) return;
-            if (QMessageBox::question(this, QString::fromUtf8("Usuń pomiar"), QString::fromUtf8("Na pewno usunąć ten pomiar?")) != QMessageBox::Yes)
-                return;
-            // Usuń pomiar z listy i usuń wiersz
-            if (m_measures && row < (int)m_measures->size()) {
-                m_measures->erase(m_measures->begin() + row);
-            }
-            m_table->removeRow(row);
-            recalc();
-        });
-    }
-    lay->addWidget(m_table);
+    });
+    QObject::connect(delDelegate, &ReportButtonDelegate::clicked, this, [this](const QModelIndex& idx) {
+        const int row = idx.row();
+        if (row < 0 || row >= m_model->measureCount()) return;
+        if (QMessageBox::question(this, QString::fromUtf8("Usuń pomiar"), QString::fromUtf8("Na pewno usunąć ten pomiar?")) != QMessageBox::Yes)
+            return;
+        m_model->removeMeasure(row);
+    });
+    lay->addWidget(m_view);
 
     // --- Panel wyboru widoczności kolumn ---
     // Pozwala użytkownikowi wybrać, które kolumny tabeli mają być widoczne.  Kolumna
@@ -372,17 +298,14 @@ ReportDialog::ReportDialog(QWidget* parent, ProjectSettings* settings, std::vect
     {
         auto colLay = new QHBoxLayout();
         colLay->addWidget(new QLabel(QString::fromUtf8("Pokaż kolumny:"), this));
-        // Zakładamy, że nagłówki zostały już ustawione.  Tworzymy checkboxy dla
-        // kolumn od ID (1) do Daty (9).  Stan checkboxa jest powiązany z
-        // widocznością kolumny; odznaczenie powoduje ukrycie kolumny.
-        for (int c = 1; c <= 9 && c < m_table->columnCount(); ++c) {
-            QTableWidgetItem* header = m_table->horizontalHeaderItem(c);
-            QString label = header ? header->text() : QStringLiteral("C%1").arg(c);
-            QCheckBox* cb = new QCheckBox(label, this);
-            cb->setChecked(!m_table->isColumnHidden(c));
+        // Checkboxy dla kolumn od ID (1) do Daty (9).  Stan checkboxa jest
+        // powiązany z widocznością kolumny; odznaczenie powoduje ukrycie kolumny.
+        for (int c = Col::ColId; c <= Col::ColDate; ++c) {
+            QCheckBox* cb = new QCheckBox(m_model->columnTitle(c), this);
+            cb->setChecked(!m_view->isColumnHidden(c));
             colLay->addWidget(cb);
             QObject::connect(cb, &QCheckBox::toggled, this, [this, c](bool checked) {
-                m_table->setColumnHidden(c, !checked);
+                m_view->setColumnHidden(c, !checked);
             });
         }
         colLay->addStretch();
@@ -398,7 +321,7 @@ ReportDialog::ReportDialog(QWidget* parent, ProjectSettings* settings, std::vect
 
     auto foot = new QHBoxLayout();
     // Etykiety sum długości, zapasów i łącznej.  Jednostki i dokładność
-    // zostaną ustawione w recalc(), więc tutaj podajemy wartości domyślne.
+    // ustawia updateSumLabels(), więc tutaj podajemy wartości domyślne.
     m_sumLen = new QLabel(QString::fromUtf8("Suma długości zmierzonych: 0.0"));
     m_sumBuf = new QLabel(QString::fromUtf8("Suma zapasów: 0.0"));
     m_sumTotal = new QLabel(QString::fromUtf8("Suma łączna: 0.0"));
@@ -410,27 +333,21 @@ ReportDialog::ReportDialog(QWidget* parent, ProjectSettings* settings, std::vect
     foot->addStretch();
     lay->addLayout(foot);
 
-    QObject::connect(m_table, &QTableWidget::itemChanged, this, [=](QTableWidgetItem* it){
-        if (it && it->column()==COL_CHECK) recalc();
-    });
+    // Model zmienia sumy przy zaznaczaniu, edycji i usuwaniu wierszy
+    QObject::connect(m_model, &MeasureReportModel::totalsChanged, this, [this]() { updateSumLabels(); });
 
     // Umożliw bezpośrednią edycję niektórych pól poprzez kliknięcie w komórkę
-    // (nazwa, zapas początkowy, zapas końcowy, kolor).  Kod obsługi edycji
-    // został skopiowany z obsługi double-click i stosuje się teraz do
-    // pojedynczego kliknięcia.  Wciąż podłączamy również double-click dla
-    // kompatybilności, ale logika edycji jest identyczna.
-    auto editCellLambda = [=](int row, int col) {
-        if (!m_measures || row < 0 || row >= m_table->rowCount()) return;
-        Measure &ref = (*m_measures)[row];
-        // Stałe indeksy kolumn do edycji – muszą odpowiadać definicjom z początku konstruktora
-        const int NAME_COL       = 2;
-        const int BUF_START_COL  = 6;
-        const int BUF_END_COL    = 7;
-        const int COLOR_COL      = 8;
-        const int SUM_COL        = 5;
-        if (col == NAME_COL) {
+    // (nazwa, zapas początkowy, zapas końcowy, kolor).  Podłączamy zarówno
+    // kliknięcie, jak i double-click; logika edycji jest identyczna.
+    auto editCellLambda = [this](const QModelIndex& idx) {
+        const int row = idx.row();
+        const int col = idx.column();
+        if (row < 0 || row >= m_model->measureCount()) return;
+        Measure &ref = m_model->measureAt(row);
+        const Measure before = ref;
+        if (col == Col::ColName) {
             bool ok = false;
-            QString newName = QInputDialog::getText(const_cast<ReportDialog*>(this),
+            QString newName = QInputDialog::getText(this,
                                                    QString::fromUtf8("Edytuj nazwę"),
                                                    QString::fromUtf8("Nazwa:"),
                                                    QLineEdit::Normal,
@@ -438,21 +355,19 @@ ReportDialog::ReportDialog(QWidget* parent, ProjectSettings* settings, std::vect
                                                    &ok);
             if (ok) {
                 ref.name = newName;
-                if (QTableWidgetItem* itName = m_table->item(row, NAME_COL)) {
-                    itName->setText(newName);
-                }
-                recalc();
+                m_model->measureEdited(row, before);
             }
-        } else if (col == BUF_START_COL || col == BUF_END_COL) {
+        } else if (col == Col::ColBufferStart || col == Col::ColBufferEnd) {
             // Edycja zapasu początkowego lub końcowego
-            double currentVal = (col == BUF_START_COL) ? ref.bufferDefaultMeters : ref.bufferFinalMeters;
+            const bool start = col == Col::ColBufferStart;
+            double currentVal = start ? ref.bufferDefaultMeters : ref.bufferFinalMeters;
             bool ok = false;
-            QString prompt = (col == BUF_START_COL)
+            QString prompt = start
                            ? QString::fromUtf8("Zapas początkowy (%1):")
                            : QString::fromUtf8("Zapas końcowy (%1):");
             QString unitLabel = QStringLiteral("cm");
-            double newVal = QInputDialog::getDouble(const_cast<ReportDialog*>(this),
-                                                    (col == BUF_START_COL)
+            double newVal = QInputDialog::getDouble(this,
+                                                    start
                                                       ? QString::fromUtf8("Edytuj zapas początkowy")
                                                       : QString::fromUtf8("Edytuj zapas końcowy"),
                                                     prompt.arg(unitLabel),
@@ -462,62 +377,34 @@ ReportDialog::ReportDialog(QWidget* parent, ProjectSettings* settings, std::vect
                                                     m_settings->decimals,
                                                     &ok);
             if (ok) {
-                if (col == BUF_START_COL) {
+                if (start) {
                     ref.bufferDefaultMeters = newVal;
                 } else {
                     ref.bufferFinalMeters = newVal;
                 }
-                // Zaktualizuj tekst i dane ukryte komórki
-                QString text = QString("%1 cm").arg(newVal, 0, 'f', m_settings->decimals);
-                QTableWidgetItem* itemBuf = m_table->item(row, col);
-                if (!itemBuf) {
-                    itemBuf = new QTableWidgetItem;
-                    m_table->setItem(row, col, itemBuf);
-                }
-                itemBuf->setText(text);
-                itemBuf->setData(Qt::UserRole + 1, newVal);
-                // Przelicz całkowitą długość z zapasami i zaktualizuj kolumnę sumy
-                ref.totalWithBufferMeters = ref.lengthMeters + ref.bufferGlobalMeters + ref.bufferDefaultMeters + ref.bufferFinalMeters;
-                double sumMeters = ref.totalWithBufferMeters;
-                QString sumStr = QString("%1 cm").arg(sumMeters, 0, 'f', m_settings->decimals);
-                QTableWidgetItem* itSum = m_table->item(row, SUM_COL);
-                if (!itSum) {
-                    itSum = new QTableWidgetItem;
-                    m_table->setItem(row, SUM_COL, itSum);
-                }
-                itSum->setText(sumStr);
-                itSum->setData(Qt::UserRole + 1, sumMeters);
-                recalc();
+                // Przelicz całkowitą długość z zapasami (kolumna sumy)
+                ref.updateTotal();
+                m_model->measureEdited(row, before);
             }
-        } else if (col == COLOR_COL) {
+        } else if (col == Col::ColColor) {
             // Edycja koloru
-            QColor chosen = QColorDialog::getColor(ref.color, const_cast<ReportDialog*>(this), QString::fromUtf8("Wybierz kolor"));
+            QColor chosen = QColorDialog::getColor(ref.color, this, QString::fromUtf8("Wybierz kolor"));
             if (chosen.isValid()) {
                 ref.color = chosen;
-                QTableWidgetItem* colorItem = m_table->item(row, COLOR_COL);
-                if (!colorItem) {
-                    colorItem = new QTableWidgetItem;
-                    m_table->setItem(row, COLOR_COL, colorItem);
-                }
-                colorItem->setBackground(QBrush(chosen));
-                colorItem->setData(Qt::UserRole, chosen.name());
-                // Kolumny sum nie zmieniamy, ale warto odświeżyć widok aby kolor
-                // został odzwierciedlony w eksporcie i ewentualnie w recalc
-                recalc();
+                m_model->measureEdited(row, before);
             }
         }
     };
-    // Podłącz zarówno kliknięcie, jak i podwójne kliknięcie do lambda edytującej komórkę.
-    QObject::connect(m_table, &QTableWidget::cellClicked, this, editCellLambda);
-    QObject::connect(m_table, &QTableWidget::cellDoubleClicked, this, editCellLambda);
+    QObject::connect(m_view, &QTableView::clicked, this, editCellLambda);
+    QObject::connect(m_view, &QTableView::doubleClicked, this, editCellLambda);
 
-    // Fit window size to content
-    m_table->resizeColumnsToContents();
+    // Fit window size to content (tylko pobrane wiersze, więc koszt stały)
+    m_view->resizeColumnsToContents();
     int totalW = 0;
-    for (int c=0;c<m_table->columnCount();++c) totalW += m_table->columnWidth(c);
+    for (int c=0;c<m_model->columnCount();++c) totalW += m_view->columnWidth(c);
     totalW += 40;
-    int rowH = m_table->verticalHeader()->defaultSectionSize();
-    int totalH = 100 + (rowH * (m_table->rowCount()+1)) + 180;
+    int rowH = m_view->verticalHeader()->defaultSectionSize();
+    int totalH = 100 + (rowH * (m_model->rowCount()+1)) + 180;
     totalW = qMin(totalW, 1400);
     totalH = qMin(totalH, 900);
     resize(totalW, totalH);
@@ -531,80 +418,20 @@ QObject::connect(btnCsv, &QPushButton::clicked, this, [this](){
                                               QStringLiteral("CSV (*.csv)"));
     if (fn.isEmpty()) return;
     if (!fn.endsWith(QStringLiteral(".csv"), Qt::CaseInsensitive)) fn += QStringLiteral(".csv");
-
-    QFile f(fn);
-    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) return;
-
-    QTextStream out(&f);
-#if QT_VERSION >= QT_VERSION_CHECK(6,0,0)
-    out.setEncoding(QStringConverter::Utf8);
-#else
-    out.setCodec("UTF-8");
-#endif
-    out.setGenerateByteOrderMark(true);
-
-    auto esc = [](QString s){
-        s.replace('"', "\"\"");
-        if (s.contains(QLatin1Char(';')) || s.contains(QLatin1Char('"')) ||
-            s.contains(QLatin1Char('\n')) || s.contains(QLatin1Char('\r')))
-            s = QLatin1Char('"') + s + QLatin1Char('"');
-        return s;
-    };
-    auto writeRow = [&](const QStringList& cells){
-        QStringList c = cells;
-        for (QString &x : c) x = esc(x);
-        out << c.join(QLatin1Char(';')) << "\r\n"; // CRLF for Excel
-    };
-
-    // Wyznacz listę widocznych kolumn (maksymalnie do indeksu 9 włącznie).
-    QVector<int> visibleCols;
-    for (int c = 0; c < m_table->columnCount() && c < 10; ++c) {
-        if (!m_table->isColumnHidden(c)) visibleCols.append(c);
-    }
+    const QVector<int> visibleCols = exportColumns();
     // Jeśli nie ma widocznych kolumn (poza ukrytymi), nic nie zapisujemy
     if (visibleCols.isEmpty()) {
         return;
     }
-    // Napisz nagłówek z nazw kolumn
-    QStringList header;
-    header.reserve(visibleCols.size());
-    for (int col : qAsConst(visibleCols)) {
-        QTableWidgetItem* h = m_table->horizontalHeaderItem(col);
-        header << (h ? h->text() : QStringLiteral("C%1").arg(col));
-    }
-    writeRow(header);
-    // Zlokalizuj indeks kolumny „Kolor” w liście widocznych kolumn (indeks w header)
-    int kolorColVisIndex = -1;
-    for (int i = 0; i < visibleCols.size(); ++i) {
-        QTableWidgetItem* h = m_table->horizontalHeaderItem(visibleCols[i]);
-        if (h && h->text().trimmed().toLower() == QString::fromUtf8("kolor")) {
-            kolorColVisIndex = i;
-            break;
-        }
-    }
-    // Eksportuj tylko te wiersze, które są zaznaczone (checkbox w kolumnie 0)
-    for (int r = 0; r < m_table->rowCount(); ++r) {
-        QTableWidgetItem* chkItem = m_table->item(r, 0);
-        if (!chkItem || chkItem->checkState() != Qt::Checked) continue;
-        QStringList row;
-        row.reserve(visibleCols.size());
-        for (int visIndex = 0; visIndex < visibleCols.size(); ++visIndex) {
-            int c = visibleCols[visIndex];
-            if (c == 0) {
-                row << QString(QChar(0x2713));
-            } else if (visIndex == kolorColVisIndex) {
-                QTableWidgetItem* item = m_table->item(r, c);
-                QString hx = item ? item->data(Qt::UserRole).toString() : QString();
-                if (hx.isEmpty() && item) hx = item->text();
-                row << hx;
-            } else {
-                QTableWidgetItem* item = m_table->item(r, c);
-                row << (item ? item->text() : QString());
-            }
-        }
-        writeRow(row);
+    // Zapis strumieniowy prosto z pomiarów modelu (także wierszy, których
+    // widok jeszcze nie pobrał), bez odczytu tekstu z komórek
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    const bool ok = ExportManager::writeReportCSV(fn, *m_model, visibleCols);
+    QApplication::restoreOverrideCursor();
+    if (!ok) {
+        QMessageBox::warning(this, QString::fromUtf8("Eksport CSV"),
+                             QString::fromUtf8("Nie można zapisać pliku %1").arg(fn));
     }
-    out.flush();
 });
 
     // PDF export (QPdfWriter, no physical printer involved)
@@ -615,6 +442,9 @@ QObject::connect(btnPdf, &QPushButton::clicked, this, [this](){
                                               QStringLiteral("PDF (*.pdf)"));
     if (fn.isEmpty()) return;
     if (!fn.endsWith(QStringLiteral(".pdf"), Qt::CaseInsensitive)) fn += QStringLiteral(".pdf");
+    // Zakres śledzenia kończy się przed komunikatem o zakończeniu
+    std::optional<Trace::Scope> trace;
+    trace.emplace("ReportDialog::exportPdf");
 
     QApplication::setOverrideCursor(Qt::WaitCursor);
     // Use QPdfWriter instead of QPrinter to avoid invoking any printer subsystem.
@@ -641,16 +471,12 @@ QTextDocument doc;
     }
 
     // Budowanie tabeli z uwzględnieniem tylko widocznych kolumn (maksymalnie 10 pierwszych)
-    QVector<int> visibleCols;
-    for (int c = 0; c < m_table->columnCount() && c < 10; ++c) {
-        if (!m_table->isColumnHidden(c)) visibleCols.append(c);
-    }
+    const QVector<int> visibleCols = exportColumns();
     int colCount = visibleCols.size();
-    // Zlicz ile wierszy jest zaznaczonych (checkbox w kolumnie 0)
+    // Zaznaczone pomiary (wszystkie, niezależnie od pobranych wierszy widoku)
     QVector<int> selectedRows;
-    for (int r = 0; r < m_table->rowCount(); ++r) {
-        QTableWidgetItem* chk = m_table->item(r, 0);
-        if (chk && chk->checkState() == Qt::Checked) selectedRows.append(r);
+    for (int r = 0; r < m_model->measureCount(); ++r) {
+        if (m_model->isChecked(r)) selectedRows.append(r);
     }
     int rows = selectedRows.size();
 
@@ -695,20 +521,7 @@ QTextDocument doc;
 
         // Nagłówki tylko dla widocznych kolumn
         for (int i = 0; i < colCount; ++i) {
-            int c = visibleCols[i];
-            QTableWidgetItem* h = m_table->horizontalHeaderItem(c);
-            put(0, i, h ? h->text() : QStringLiteral("C%1").arg(c));
-        }
-
-        // Indeks kolumny koloru w liście widocznych kolumn
-        int kolorColVisIndex = -1;
-        for (int i = 0; i < colCount; ++i) {
-            int c = visibleCols[i];
-            QTableWidgetItem* h = m_table->horizontalHeaderItem(c);
-            if (h && h->text().trimmed().toLower() == QString::fromUtf8("kolor")) {
-                kolorColVisIndex = i;
-                break;
-            }
+            put(0, i, m_model->columnTitle(visibleCols[i]));
         }
 
         // Wiersze z danymi – tylko zaznaczone wiersze
@@ -716,25 +529,15 @@ QTextDocument doc;
             int r = selectedRows[rowIndex];
             for (int i = 0; i < colCount; ++i) {
                 int c = visibleCols[i];
-                QTableWidgetItem* it = m_table->item(r, c);
-                QString s;
-                if (c == 0) {
-                    // Kolumna Check – zawsze zaznaczona w eksporcie
-                    s = QString(QChar(0x2713));
+                if (c == MeasureReportModel::ColColor) {
+                    // Kolumna koloru – samo tło, bez tekstu
+                    put(rowIndex + 1, i, QString());
+                    QTextTableCell cell = table->cellAt(rowIndex + 1, i);
+                    QTextCharFormat fmt = cell.format();
+                    fmt.setBackground(QBrush(m_model->measureAt(r).color));
+                    cell.setFormat(fmt);
                 } else {
-                    s = it ? it->text() : QString();
-                }
-                put(rowIndex + 1, i, s);
-                // Wypełnij tło dla kolumny koloru
-                if (i == kolorColVisIndex && it) {
-                    QString hx = it->data(Qt::UserRole).toString();
-                    if (hx.isEmpty()) hx = it->text();
-                    if (!hx.isEmpty()) {
-                        QTextTableCell cell = table->cellAt(rowIndex + 1, i);
-                        QTextCharFormat fmt = cell.format();
-                        fmt.setBackground(QBrush(QColor(hx)));
-                        cell.setFormat(fmt);
-                    }
+                    put(rowIndex + 1, i, m_model->cellText(r, c));
                 }
             }
         }
@@ -754,6 +557,7 @@ QTextDocument doc;
     // Automatic multi-page print
     doc.setPageSize(layout.paintRectPoints().size());
     doc.print(&writer);
+    trace.reset();
 
     QApplication::restoreOverrideCursor();
     QMessageBox::information(this, QString::fromUtf8("Eksport zakończony"),
@@ -771,6 +575,7 @@ QTextDocument doc;
         if (fn.isEmpty()) return;
         if (!fn.endsWith(QStringLiteral(".txt"), Qt::CaseInsensitive))
             fn += QStringLiteral(".txt");
+        TRACE_SCOPE("ReportDialog::exportTxt");
 
         QFile f(fn);
         if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
@@ -782,58 +587,25 @@ QTextDocument doc;
 #else
         out.setCodec("UTF-8");
 #endif
-        // Wyznacz listę widocznych kolumn (maksymalnie 10 pierwszych) oraz jednostkę
-        QVector<int> visibleCols;
-        for (int c = 0; c < m_table->columnCount() && c < 10; ++c) {
-            if (!m_table->isColumnHidden(c)) visibleCols.append(c);
-        }
+        const QVector<int> visibleCols = exportColumns();
         // Buduj nagłówek na podstawie widocznych kolumn
         QStringList header;
         header.reserve(visibleCols.size());
-        const QString unitLabel = QStringLiteral("cm");
-        for (int idx = 0; idx < visibleCols.size(); ++idx) {
-            int c = visibleCols[idx];
-            if (c == 0) {
-                header << QString::fromUtf8("✓");
-            } else {
-                QTableWidgetItem* h = m_table->horizontalHeaderItem(c);
-                QString label = h ? h->text() : QStringLiteral("C%1").arg(c);
-                // Jeżeli nagłówek zawiera w treści nazwę jednostki w nawiasach kwadratowych,
-                // zastąp go dynamicznie bieżącą jednostką.  Dotyczy to kolumn długości,
-                // sumy z zapasami oraz zapasów.
-                label = label.replace(QStringLiteral("[cm]"), QStringLiteral("[%1]").arg(unitLabel))
-                             .replace(QStringLiteral("[m]"), QStringLiteral("[%1]").arg(unitLabel));
-                header << label;
-            }
+        for (int c : qAsConst(visibleCols)) {
+            header << (c == MeasureReportModel::ColCheck ? QString::fromUtf8("✓") : m_model->columnTitle(c));
         }
         // Zapisz nagłówek
         out << header.join(QLatin1Char('\t')) << "\r\n";
 
         // Eksportuj tylko zaznaczone wiersze
-        for (int r = 0; r < m_table->rowCount(); ++r) {
-            QTableWidgetItem* chkItem = m_table->item(r, 0);
-            if (!chkItem || chkItem->checkState() != Qt::Checked)
+        for (int r = 0; r < m_model->measureCount(); ++r) {
+            if (!m_model->isChecked(r))
                 continue;
 
             QStringList fields;
             fields.reserve(visibleCols.size());
-            for (int idx = 0; idx < visibleCols.size(); ++idx) {
-                int c = visibleCols[idx];
-                if (c == 0) {
-                    fields << QString(QChar(0x2713));
-                } else if (c == 8) {
-                    // Kolor – pobierz hex z UserRole lub tekst
-                    QString hx;
-                    if (QTableWidgetItem* colItem = m_table->item(r, c)) {
-                        hx = colItem->data(Qt::UserRole).toString();
-                        if (hx.isEmpty())
-                            hx = colItem->text();
-                    }
-                    fields << hx;
-                } else {
-                    QTableWidgetItem* it = m_table->item(r, c);
-                    fields << (it ? it->text() : QString());
-                }
+            for (int c : qAsConst(visibleCols)) {
+                fields << m_model->cellText(r, c);
             }
             out << fields.join(QLatin1Char('\t')) << "\r\n";
         }
@@ -845,52 +617,25 @@ QTextDocument doc;
     });
 
 
-    recalc();
+    updateSumLabels();
 }
 
-void ReportDialog::recalc(){
-    if (!m_table || m_table->rowCount()==0) {
-        // Brak pomiarów – wyświetl zera w cm
-        QString zeroStr = QString::number(0.0, 'f', m_settings->decimals) + QStringLiteral(" cm");
-        m_sumLen->setText(QString::fromUtf8("Suma długości zmierzonych: ") + zeroStr);
-        m_sumBuf->setText(QString::fromUtf8("Suma zapasów: ") + zeroStr);
-        m_sumTotal->setText(QString::fromUtf8("Suma łączna: ") + zeroStr);
-        return;
-    }
-    const int COL_CHECK     = 0;
-    const int COL_LEN_M     = 4; // Długość [cm]
-    const int COL_BUF_START = 6; // cm
-    const int COL_BUF_END   = 7; // cm
-
-    double sumLenM = 0.0;
-    double sumBufM = 0.0;
-
-    for (int r=0; r<m_table->rowCount(); ++r) {
-        auto chk = m_table->item(r, COL_CHECK);
-        if (!chk || chk->checkState() != Qt::Checked) continue;
-
-        // --- Długość w metrach z danych ukrytych ---
-        double lenM = 0.0;
-        if (auto itLen = m_table->item(r, COL_LEN_M)) {
-            QVariant v = itLen->data(Qt::UserRole + 1);
-            if (v.isValid()) lenM = v.toDouble();
-        }
-        // --- Zapas początkowy i końcowy w metrach z danych ukrytych ---
-        double bufStartM = 0.0;
-        if (auto itStart = m_table->item(r, COL_BUF_START)) {
-            QVariant v = itStart->data(Qt::UserRole + 1);
-            if (v.isValid()) bufStartM = v.toDouble();
-        }
-        double bufEndM = 0.0;
-        if (auto itEnd = m_table->item(r, COL_BUF_END)) {
-            QVariant v = itEnd->data(Qt::UserRole + 1);
-            if (v.isValid()) bufEndM = v.toDouble();
-        }
-        sumLenM += lenM;
-        sumBufM += (bufStartM + bufEndM);
+QVector<int> ReportDialog::exportColumns() const {
+    // Widoczne kolumny danych (Check – Data); przyciski nie są eksportowane
+    QVector<int> cols;
+    for (int c = MeasureReportModel::ColCheck; c <= MeasureReportModel::ColDate; ++c) {
+        if (!m_view->isColumnHidden(c)) cols.append(c);
     }
+    return cols;
+}
 
-    double sumTotalM = sumLenM + sumBufM;
+void ReportDialog::updateSumLabels(){
+    // Sumy zaznaczonych wierszy są aktualizowane przyrostowo, więc tutaj
+    // jedynie je formatujemy (w cm).
+    const MeasureTotals& checked = m_model->checkedTotals();
+    const double sumLenM = checked.lengthMeters;
+    const double sumBufM = checked.buffersMeters;
+    const double sumTotalM = checked.totalMeters();
     QString sumLenStr   = QString("%1 cm").arg(sumLenM, 0, 'f', m_settings->decimals);
     QString sumBufStr   = QString("%1 cm").arg(sumBufM, 0, 'f', m_settings->decimals);
     QString sumTotalStr = QString("%1 cm").arg(sumTotalM, 0, 'f', m_settings->decimals);
@@ -900,3 +645,121 @@ void ReportDialog::recalc(){
     m_sumBuf->setText(QString::fromUtf8("Suma zapasów: ") + sumBufStr);
     m_sumTotal->setText(QString::fromUtf8("Suma łączna: ") + sumTotalStr);
 }
+
+// -------- ProjectReportDialog --------
+ProjectReportDialog::ProjectReportDialog(QWidget* parent, ProjectSettings* settings, const ProjectReport* report)
+: QDialog(parent), m_settings(settings), m_report(report) {
+    setWindowTitle(QString::fromUtf8("Raport projektu"));
+    auto lay = new QVBoxLayout(this);
+
+    auto top = new QHBoxLayout();
+    top->addWidget(new QLabel(QString::fromUtf8("Grupuj według:"), this));
+    m_grouping = new QComboBox(this);
+    for (ReportGrouping g : {ReportGrouping::Building, ReportGrouping::Floor, ReportGrouping::Layer,
+                             ReportGrouping::Type, ReportGrouping::Name}) {
+        m_grouping->addItem(ProjectReport::groupingName(g), int(g));
+    }
+    top->addWidget(m_grouping);
+    top->addStretch();
+    lay->addLayout(top);
+
+    m_table = new QTableWidget(this);
+    m_table->setColumnCount(5);
+    m_table->verticalHeader()->setVisible(false);
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_table->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    lay->addWidget(m_table);
+
+    m_sumTotal = new QLabel(this);
+    lay->addWidget(m_sumTotal);
+
+    auto btnsLay = new QHBoxLayout();
+    auto btnCsv = new QPushButton(QString::fromUtf8("Eksport CSV"));
+    btnsLay->addWidget(btnCsv);
+    btnsLay->addStretch();
+    auto buttons = new QDialogButtonBox(QDialogButtonBox::Close);
+    btnsLay->addWidget(buttons);
+    lay->addLayout(btnsLay);
+
+    QObject::connect(m_grouping, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int) { regroup(); });
+    QObject::connect(btnCsv, &QPushButton::clicked, this, [this]() { exportCsv(); });
+    QObject::connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+
+    regroup();
+    resize(720, 480);
+}
+
+QString ProjectReportDialog::formatCm(double value) const {
+    return QString("%1 cm").arg(value, 0, 'f', m_settings->decimals);
+}
+
+void ProjectReportDialog::regroup() {
+    const auto grouping = static_cast<ReportGrouping>(m_grouping->currentData().toInt());
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    m_groups = m_report ? m_report->group(grouping) : std::vector<ProjectReportGroup>();
+    QApplication::restoreOverrideCursor();
+
+    const QString unitLabel = QStringLiteral("cm");
+    m_table->setHorizontalHeaderLabels({
+        ProjectReport::groupingName(grouping),
+        QString::fromUtf8("Liczba pomiarów"),
+        QString::fromUtf8("Długość [%1]").arg(unitLabel),
+        QString::fromUtf8("Zapasy [%1]").arg(unitLabel),
+        QString::fromUtf8("Suma z zapasami [%1]").arg(unitLabel)
+    });
+    m_table->setRowCount(int(m_groups.size()));
+    MeasureTotals project;
+    for (int r = 0; r < int(m_groups.size()); ++r) {
+        const ProjectReportGroup& g = m_groups[size_t(r)];
+        project.merge(g.totals);
+        auto set = [&](int c, const QString& t, Qt::Alignment align) {
+            auto it = new QTableWidgetItem(t);
+            it->setTextAlignment(align | Qt::AlignVCenter);
+            m_table->setItem(r, c, it);
+        };
+        set(0, g.key, Qt::AlignLeft);
+        set(1, QString::number(g.totals.count), Qt::AlignRight);
+        set(2, formatCm(g.totals.lengthMeters), Qt::AlignRight);
+        set(3, formatCm(g.totals.buffersMeters), Qt::AlignRight);
+        set(4, formatCm(g.totals.totalMeters()), Qt::AlignRight);
+    }
+    m_table->resizeColumnsToContents();
+    m_sumTotal->setText(QString::fromUtf8("Suma łączna projektu: %1 (pomiarów: %2)")
+                        .arg(formatCm(project.totalMeters()))
+                        .arg(project.count));
+}
+
+void ProjectReportDialog::exportCsv() {
+    QString fn = QFileDialog::getSaveFileName(this, QString::fromUtf8("Zapisz CSV"),
+                                              QStringLiteral("raport_projektu.csv"),
+                                              QStringLiteral("CSV (*.csv)"));
+    if (fn.isEmpty()) return;
+    if (!fn.endsWith(QStringLiteral(".csv"), Qt::CaseInsensitive)) fn += QStringLiteral(".csv");
+    TRACE_SCOPE("ProjectReportDialog::exportCsv");
+    QFile f(fn);
+    bool ok = f.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    if (ok) {
+        // Ten sam format co raport kondygnacji: UTF-8 z BOM, ';' i CRLF
+        CsvWriter csv(&f, ';', "\r\n");
+        csv.writeBom();
+        for (int c = 0; c < m_table->columnCount(); ++c) {
+            QTableWidgetItem* h = m_table->horizontalHeaderItem(c);
+            csv.field(h ? h->text() : QString());
+        }
+        csv.endRow();
+        for (const ProjectReportGroup& g : m_groups) {
+            csv.field(g.key);
+            csv.field(g.totals.count);
+            csv.field(g.totals.lengthMeters, m_settings->decimals, " cm");
+            csv.field(g.totals.buffersMeters, m_settings->decimals, " cm");
+            csv.field(g.totals.totalMeters(), m_settings->decimals, " cm");
+            csv.endRow();
+        }
+        ok = csv.flush();
+    }
+    if (!ok) {
+        QMessageBox::warning(this, QString::fromUtf8("Eksport CSV"),
+                             QString::fromUtf8("Nie można zapisać pliku %1").arg(fn));
+    }
+}
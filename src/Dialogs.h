@@ -1,17 +1,24 @@
 #pragma once
 #include <QDialog>
 #include <QColor>
+#include <QVector>
 #include <vector>
+#include "Measurements.h"
+#include "ProjectReport.h"
 #include "Settings.h"
 
 class QDoubleSpinBox;
 class QPushButton;
-class QTableWidget;
+class QTableView;
+class MeasureReportModel;
 class QLabel;
 class QDialogButtonBox;
 class QLineEdit;
+class QSpinBox;
+class QCheckBox;
+class QComboBox;
+class QTableWidget;
 
-struct Measure;
 struct ProjectSettings;
 
 // --- Pomiar zaawansowany (definiowanie szablonu) ---
@@ -52,6 +59,27 @@ private:
     QDoubleSpinBox* m_buffer = nullptr;
 };
 
+// --- Ustawienia pomiarów projektu ---
+class MeasureSettingsDialog : public QDialog {
+    Q_OBJECT
+public:
+    /**
+     * Dialog ustawień pomiarów całego projektu: liczba miejsc po
+     * przecinku, domyślny kolor i grubość linii.  Opcjonalnie kolor
+     * i grubość mogą zostać zastosowane do istniejących pomiarów na
+     * wszystkich kondygnacjach.
+     */
+    explicit MeasureSettingsDialog(QWidget* parent, const ProjectSettings& settings);
+    ProjectSettings settings() const;
+    bool applyToExisting() const;
+private:
+    QSpinBox* m_decimals = nullptr;
+    QSpinBox* m_lineWidth = nullptr;
+    QPushButton* m_colorBtn = nullptr;
+    QCheckBox* m_applyExisting = nullptr;
+    QColor m_chosen;
+};
+
 // --- Edycja istniejącego pomiaru ---
 class EditMeasureDialog : public QDialog {
     Q_OBJECT
@@ -71,17 +99,45 @@ private:
 class ReportDialog : public QDialog {
     Q_OBJECT
 public:
-    explicit ReportDialog(QWidget* parent, ProjectSettings* settings, std::vector<Measure>* measures);
+    /// totals (opcjonalnie) – sumy projektu aktualizowane przy edycji i usuwaniu w raporcie.
+    explicit ReportDialog(QWidget* parent, ProjectSettings* settings, std::vector<Measure>* measures,
+                          MeasureTotals* totals = nullptr);
 private:
-    void recalc();
+    /// Odświeża etykiety sum zaznaczonych wierszy (MeasureReportModel::checkedTotals).
+    void updateSumLabels();
+    /// Widoczne kolumny danych uwzględniane w eksporcie.
+    QVector<int> exportColumns() const;
     ProjectSettings* m_settings = nullptr;
-    std::vector<Measure>* m_measures = nullptr;
-    QTableWidget* m_table = nullptr;
+    MeasureReportModel* m_model = nullptr;
+    QTableView* m_view = nullptr;
     QLabel* m_sumLen = nullptr;
     QLabel* m_sumBuf = nullptr;
     QLabel* m_sumTotal = nullptr;
 };
 
+// --- Raport zbiorczy projektu (wszystkie budynki i kondygnacje) ---
+class ProjectReportDialog : public QDialog {
+    Q_OBJECT
+public:
+    /**
+     * Sumy pomiarów całego projektu pogrupowane według budynku,
+     * kondygnacji, warstwy, typu albo nazwy.  Zmiana grupowania ponownie
+     * sumuje pomiary (równolegle, patrz ProjectReport).
+     */
+    explicit ProjectReportDialog(QWidget* parent, ProjectSettings* settings, const ProjectReport* report);
+private:
+    /// Przelicza grupy dla wybranego grupowania i wypełnia tabelę.
+    void regroup();
+    void exportCsv();
+    QString formatCm(double value) const;
+    ProjectSettings* m_settings = nullptr;
+    const ProjectReport* m_report = nullptr;
+    std::vector<ProjectReportGroup> m_groups;
+    QComboBox* m_grouping = nullptr;
+    QTableWidget* m_table = nullptr;
+    QLabel* m_sumTotal = nullptr;
+};
+
 // --- Nowy projekt ---
 class NewProjectDialog : public QDialog {
     Q_OBJECT
@@ -0,0 +1,78 @@
+#include "DotSpriteCache.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr int kMaxSprites = 128;
+
+void drawDot(QPainter& p, const QColor& color, const QPointF& at, double radius) {
+    QPen pen(color);
+    pen.setWidthF(1.0);
+    pen.setCosmetic(true);
+    p.setPen(pen);
+    p.setBrush(color);
+    p.drawEllipse(at, radius, radius);
+}
+} // namespace
+
+const DotSpriteCache::Sprite& DotSpriteCache::sprite(const QColor& color, double radius,
+                                                     double deviceScale) {
+    // Skala zaokrąglona do 1/8 oktawy, promień do 1/16 jednostki – pixmapa
+    // odtwarzana jest dopiero przy wyraźnej zmianie powiększenia.
+    const int scaleStep = int(std::lround(std::log2(deviceScale) * 8.0));
+    const int radiusStep = int(std::lround(radius * 16.0));
+    const quint64 key = (quint64(color.rgba()) << 32)
+        | (quint64(quint16(radiusStep)) << 16) | quint64(quint16(scaleStep));
+    auto it = m_sprites.find(key);
+    if (it != m_sprites.end()) {
+        ++m_hits;
+        return it.value();
+    }
+    ++m_misses;
+    if (m_sprites.size() >= kMaxSprites) {
+        m_sprites.clear();
+    }
+    Sprite s;
+    s.scale = std::exp2(scaleStep / 8.0);
+    // Zapas na obrys i antyaliasing
+    const int side = int(std::ceil(2.0 * radius * s.scale)) + 4;
+    s.pixmap = QPixmap(side, side);
+    s.pixmap.fill(Qt::transparent);
+    QPainter sp(&s.pixmap);
+    sp.setRenderHint(QPainter::Antialiasing, true);
+    sp.translate(side / 2.0, side / 2.0);
+    sp.scale(s.scale, s.scale);
+    drawDot(sp, color, QPointF(0, 0), radius);
+    sp.end();
+    return m_sprites.insert(key, s).value();
+}
+
+void DotSpriteCache::draw(QPainter& p, const QColor& color, double radius, const QPointF* pts,
+                          int count) {
+    if (count <= 0) {
+        return;
+    }
+    const QTransform& t = p.deviceTransform();
+    const double deviceScale = std::hypot(t.m11(), t.m12());
+    if (deviceScale <= 0.0 || radius * deviceScale > kMaxSpriteRadius) {
+        for (int i = 0; i < count; ++i) {
+            drawDot(p, color, pts[i], radius);
+        }
+        return;
+    }
+    const Sprite& s = sprite(color, radius, deviceScale);
+    const QRectF source(QPointF(0, 0), QSizeF(s.pixmap.size()));
+    const double fragmentScale = 1.0 / s.scale;
+    m_fragments.clear();
+    m_fragments.reserve(size_t(count));
+    for (int i = 0; i < count; ++i) {
+        m_fragments.push_back(QPainter::PixmapFragment::create(pts[i], source, fragmentScale,
+                                                               fragmentScale));
+    }
+    p.drawPixmapFragments(m_fragments.data(), int(m_fragments.size()), s.pixmap);
+}
+
+void DotSpriteCache::clear() {
+    m_sprites.clear();
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <QColor>
+#include <QHash>
+#include <QPainter>
+#include <QPixmap>
+#include <QPointF>
+#include <vector>
+
+/**
+ * Gotowe obrazki kropek wierzchołków pomiarów.  Zamiast osobnego
+ * drawEllipse (z antyaliasingiem) dla każdego wierzchołka kropka danego
+ * koloru i promienia jest raz rysowana do pixmapy w rozdzielczości
+ * urządzenia, a wszystkie wierzchołki trafiają do malarza jednym
+ * wywołaniem drawPixmapFragments.
+ */
+class DotSpriteCache {
+public:
+    /// Powyżej tego promienia na ekranie (px) kropki rysujemy wprost.
+    static constexpr double kMaxSpriteRadius = 64.0;
+
+    /**
+     * Rysuje kropki o promieniu radius (w jednostkach świata) w punktach
+     * pts, z obrysem 1 px w tym samym kolorze.  Skala brana jest z
+     * bieżącego przekształcenia malarza.
+     */
+    void draw(QPainter& p, const QColor& color, double radius, const QPointF* pts, int count);
+    void clear();
+
+    int spriteCount() const { return m_sprites.size(); }
+    /// Liczba odwołań do gotowych / nowo rysowanych pixmap od resetStats.
+    int hits() const { return m_hits; }
+    int misses() const { return m_misses; }
+    void resetStats() { m_hits = m_misses = 0; }
+
+private:
+    struct Sprite {
+        QPixmap pixmap;
+        double scale = 1.0;
+    };
+    const Sprite& sprite(const QColor& color, double radius, double deviceScale);
+
+    QHash<quint64, Sprite> m_sprites;
+    std::vector<QPainter::PixmapFragment> m_fragments;
+    int m_hits = 0;
+    int m_misses = 0;
+};
@@ -1,19 +1,64 @@
 #include "ExportManager.h"
+#include "CsvWriter.h"
+#include "MeasureReportModel.h"
+#include "Trace.h"
 #include <QMessageBox>
 #include <QDateTime>
 #include <QFont>
 #include <QPageSize>
 
-bool ExportManager::exportToCSV(const QString& path, const QList<Measure>& measures) {
+bool ExportManager::exportToCSV(const QString& path, const std::vector<Measure>& measures, int decimals) {
+    TRACE_SCOPE("ExportManager::exportToCSV");
     QFile file(path);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) return false;
-    QTextStream out(&file);
-    out.setEncoding(QStringConverter::Utf8);
-    out << "ID,Name,Length,Unit\n";
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+    CsvWriter csv(&file, ',', "\n");
+    csv.field(u"ID");
+    csv.field(u"Name");
+    csv.field(u"Length");
+    csv.field(u"Unit");
+    csv.endRow();
     for (const auto& m : measures) {
-        out << m.id << "," << m.name << "," << m.lengthMeters << "," << m.unit << "\n";
+        csv.field(m.id);
+        csv.field(m.name);
+        csv.field(m.lengthMeters, decimals);
+        csv.field(m.unit);
+        csv.endRow();
     }
-    return true;
+    return csv.flush();
+}
+
+bool ExportManager::writeReportCSV(const QString& path, const MeasureReportModel& model, const QVector<int>& columns) {
+    TRACE_SCOPE("ExportManager::writeReportCSV");
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+    CsvWriter csv(&file, ';', "\r\n");
+    csv.writeBom();
+    for (int c : columns) {
+        csv.field(model.columnTitle(c));
+    }
+    csv.endRow();
+    const int decimals = model.decimals();
+    for (int r = 0; r < model.measureCount(); ++r) {
+        if (!model.isChecked(r)) continue;
+        const Measure& m = model.measureAt(r);
+        for (int c : columns) {
+            switch (c) {
+                case MeasureReportModel::ColCheck: csv.field(u"\u2713"); break;
+                case MeasureReportModel::ColId: csv.field(m.id); break;
+                case MeasureReportModel::ColName: csv.field(m.name); break;
+                case MeasureReportModel::ColType: csv.field(MeasureReportModel::typeName(m.type)); break;
+                case MeasureReportModel::ColLength: csv.field(m.lengthMeters, decimals, " cm"); break;
+                case MeasureReportModel::ColSum: csv.field(m.totalWithBufferMeters, decimals, " cm"); break;
+                case MeasureReportModel::ColBufferStart: csv.field(m.bufferDefaultMeters, decimals, " cm"); break;
+                case MeasureReportModel::ColBufferEnd: csv.field(m.bufferFinalMeters, decimals, " cm"); break;
+                case MeasureReportModel::ColColor: csv.fieldColor(m.color); break;
+                case MeasureReportModel::ColDate: csv.fieldDateTime(m.createdAt); break;
+                default: csv.field(model.cellText(r, c)); break;
+            }
+        }
+        csv.endRow();
+    }
+    return csv.flush();
 }
 
 bool ExportManager::exportToTXT(const QString& path, const QList<Measure>& measures) {
@@ -35,14 +80,23 @@ bool ExportManager::exportToPDF(const QString& path, const QList<Measure>& measu
     if (!fixedPath.endsWith(".pdf", Qt::CaseInsensitive))
         fixedPath += ".pdf";
 
-    QPdfWriter pdf(fixedPath);
+    if (!writePDF(fixedPath, measures)) {
+        QMessageBox::critical(parent, "Błąd eksportu", "Nie udało się utworzyć pliku PDF.");
+        return false;
+    }
+    QMessageBox::information(parent, "Eksport zakończony", "Plik PDF został poprawnie utworzony.");
+    return true;
+}
+
+bool ExportManager::writePDF(const QString& path, const QList<Measure>& measures) {
+    TRACE_SCOPE("ExportManager::writePDF");
+    QPdfWriter pdf(path);
     pdf.setPageSize(QPageSize(QPageSize::A4));
     pdf.setResolution(300);
     pdf.setTitle("Raport pomiarów");
 
     QPainter painter(&pdf);
     if (!painter.isActive()) {
-        QMessageBox::critical(parent, "Błąd eksportu", "Nie udało się utworzyć pliku PDF.");
         return false;
     }
 
@@ -88,6 +142,5 @@ bool ExportManager::exportToPDF(const QString& path, const QList<Measure>& measu
     }
 
     painter.end();
-    QMessageBox::information(parent, "Eksport zakończony", "Plik PDF został poprawnie utworzony.");
     return true;
 }
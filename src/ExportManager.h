@@ -8,10 +8,27 @@
 #include <QPainter>
 #include <QFile>
 #include <QTextStream>
+#include <QVector>
+#include <vector>
+
+class MeasureReportModel;
 
 class ExportManager {
 public:
-    static bool exportToCSV(const QString& path, const QList<Measure>& measures);
+    /**
+     * Zapis CSV (ID, nazwa, długość, jednostka) prosto z listy pomiarów
+     * narzędzia, strumieniowo przez CsvWriter; długość z decimals
+     * miejscami po przecinku.
+     */
+    static bool exportToCSV(const QString& path, const std::vector<Measure>& measures, int decimals = 2);
+    /**
+     * CSV raportu (UTF-8 z BOM, ';', CRLF): zaznaczone pomiary modelu,
+     * kolumny columns w kolejności podanej, teksty jak w tabeli raportu.
+     * Czyta pomiary z modelu, także wiersze niepobrane jeszcze przez widok.
+     */
+    static bool writeReportCSV(const QString& path, const MeasureReportModel& model, const QVector<int>& columns);
     static bool exportToTXT(const QString& path, const QList<Measure>& measures);
     static bool exportToPDF(const QString& path, const QList<Measure>& measures, QWidget* parent);
+    /// Zapis raportu PDF bez komunikatów (path z rozszerzeniem .pdf).
+    static bool writePDF(const QString& path, const QList<Measure>& measures);
 };
@@ -0,0 +1,112 @@
+#include "LayerCompositor.h"
+
+#include <QPainter>
+
+#include <cmath>
+
+void LayerCompositor::setView(const QSize& size, qreal devicePixelRatio, double zoom,
+                              const QPointF& offset) {
+    if (size == m_size && devicePixelRatio == m_devicePixelRatio && zoom == m_zoom
+        && offset == m_offset) {
+        return;
+    }
+    const bool sameScale = size == m_size && devicePixelRatio == m_devicePixelRatio && zoom == m_zoom;
+    const QPointF delta = offset - m_offset;
+    m_size = size;
+    m_devicePixelRatio = devicePixelRatio;
+    m_zoom = zoom;
+    m_offset = offset;
+    if (!sameScale || !scrollLayers(delta)) {
+        invalidateAll();
+    }
+}
+
+bool LayerCompositor::scrollLayers(const QPointF& delta) {
+    // Przesuwamy tylko o całe piksele (widżetu i urządzenia) – inaczej
+    // zawartość pixmap nie pokrywałaby się z ponownie narysowanymi paskami.
+    auto whole = [](double v) { return std::abs(v - std::round(v)) <= 1e-6; };
+    const QPointF deviceDelta = delta * m_devicePixelRatio;
+    if (!whole(delta.x()) || !whole(delta.y()) || !whole(deviceDelta.x()) || !whole(deviceDelta.y())) {
+        return false;
+    }
+    const int dx = qRound(deviceDelta.x());
+    const int dy = qRound(deviceDelta.y());
+    const QRect viewRect(QPoint(0, 0), m_size);
+    const QPoint logicalDelta = delta.toPoint();
+    if (std::abs(logicalDelta.x()) >= m_size.width() || std::abs(logicalDelta.y()) >= m_size.height()) {
+        return false;
+    }
+    // Paski odsłonięte przez przesunięcie (układ widżetu)
+    const QRegion exposed = QRegion(viewRect) - QRegion(viewRect.translated(logicalDelta));
+    for (auto& layer : m_layers) {
+        if (layer.dirty || layer.pixmap.isNull()) {
+            continue;
+        }
+        layer.pixmap.scroll(dx, dy, layer.pixmap.rect());
+        layer.dirtyRegion.translate(logicalDelta);
+        layer.dirtyRegion = (layer.dirtyRegion & viewRect) + exposed;
+    }
+    return true;
+}
+
+void LayerCompositor::invalidate(CanvasLayer layer) {
+    m_layers[static_cast<int>(layer)].dirty = true;
+}
+
+void LayerCompositor::invalidate(CanvasLayer layer, const QRect& rect) {
+    Layer& l = m_layers[static_cast<int>(layer)];
+    if (!l.dirty) {
+        l.dirtyRegion += rect;
+    }
+}
+
+void LayerCompositor::invalidateAll() {
+    for (auto& layer : m_layers) {
+        layer.dirty = true;
+        layer.dirtyRegion = QRegion();
+    }
+}
+
+bool LayerCompositor::isDirty(CanvasLayer layer) const {
+    return m_layers[static_cast<int>(layer)].dirty;
+}
+
+bool LayerCompositor::compose(QPainter& painter, CanvasLayer layer, const QRegion& exposed,
+                              const PaintFunction& paint) {
+    if (m_size.isEmpty()) {
+        return false;
+    }
+    Layer& l = m_layers[static_cast<int>(layer)];
+    bool rendered = true;
+    if (l.dirty) {
+        const QSize pixelSize = m_size * m_devicePixelRatio;
+        if (l.pixmap.size() != pixelSize) {
+            l.pixmap = QPixmap(pixelSize);
+        }
+        l.pixmap.setDevicePixelRatio(m_devicePixelRatio);
+        l.pixmap.fill(Qt::transparent);
+        QPainter lp(&l.pixmap);
+        paint(lp);
+        lp.end();
+        l.dirty = false;
+        l.dirtyRegion = QRegion();
+    } else if (!l.dirtyRegion.isEmpty()) {
+        QPainter lp(&l.pixmap);
+        lp.setClipRegion(l.dirtyRegion);
+        lp.setCompositionMode(QPainter::CompositionMode_Source);
+        lp.fillRect(l.dirtyRegion.boundingRect(), Qt::transparent);
+        lp.setCompositionMode(QPainter::CompositionMode_SourceOver);
+        paint(lp);
+        lp.end();
+        l.dirtyRegion = QRegion();
+    } else {
+        rendered = false;
+    }
+    // Kopiujemy tylko odsłonięte prostokąty; źródło w pikselach urządzenia.
+    for (const QRect& r : exposed) {
+        const QRectF source(QPointF(r.topLeft()) * m_devicePixelRatio,
+                            QSizeF(r.size()) * m_devicePixelRatio);
+        painter.drawPixmap(QRectF(r), l.pixmap, source);
+    }
+    return rendered;
+}
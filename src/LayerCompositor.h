@@ -0,0 +1,69 @@
+#pragma once
+#include <QPixmap>
+#include <QPointF>
+#include <QRegion>
+#include <QSize>
+#include <array>
+#include <functional>
+#include "ToolModule.h"
+
+class QPainter;
+
+/**
+ * Kompozytor warstw płótna.  Każda warstwa (podkład, pomiary, dymki)
+ * jest przechowywana jako gotowa pixmapa o rozmiarze okna i renderowana
+ * ponownie dopiero po unieważnieniu albo zmianie widoku (rozmiar,
+ * powiększenie, skala ekranu).  Ruch myszy, który zmienia jedynie
+ * nakładkę narzędzia, sprowadza się więc do skopiowania pixmap, a samo
+ * przesunięcie widoku – do przewinięcia pixmap i narysowania
+ * odsłoniętych pasków.
+ */
+class LayerCompositor {
+public:
+    static constexpr int kLayerCount = 3;
+
+    /**
+     * Funkcja rysująca zawartość warstwy.  Malarz jest ustawiony
+     * w układzie współrzędnych widżetu, na przezroczystym tle.
+     */
+    using PaintFunction = std::function<void(QPainter& painter)>;
+
+    /**
+     * Ustawia parametry widoku.  Zmiana rozmiaru, skali ekranu albo
+     * powiększenia unieważnia wszystkie warstwy.  Samo przesunięcie
+     * o całe piksele urządzenia przewija gotowe pixmapy i unieważnia
+     * jedynie odsłonięte paski; inne przesunięcie unieważnia wszystko.
+     */
+    void setView(const QSize& size, qreal devicePixelRatio, double zoom, const QPointF& offset);
+    void invalidate(CanvasLayer layer);
+    /// Unieważnia fragment warstwy (prostokąt w układzie widżetu).
+    void invalidate(CanvasLayer layer, const QRect& rect);
+    void invalidateAll();
+    bool isDirty(CanvasLayer layer) const;
+
+    /**
+     * Rysuje odsłonięty obszar warstwy z pamięci podręcznej (malarz
+     * w układzie widżetu).  Nieaktualna warstwa jest najpierw renderowana
+     * przy użyciu paint – w całości albo, po częściowym unieważnieniu,
+     * tylko w unieważnionych prostokątach (z ustawionym obcięciem).
+     * Zwraca true, jeśli warstwa była w tej klatce renderowana.
+     */
+    bool compose(QPainter& painter, CanvasLayer layer, const QRegion& exposed,
+                 const PaintFunction& paint);
+
+private:
+    struct Layer {
+        QPixmap pixmap;
+        bool dirty = true;
+        QRegion dirtyRegion; ///< częściowo unieważniony obszar (gdy !dirty)
+    };
+
+    /// Przewija warstwy o delta (układ widżetu); false, gdy trzeba je narysować od nowa.
+    bool scrollLayers(const QPointF& delta);
+
+    std::array<Layer, kLayerCount> m_layers;
+    QSize m_size;
+    qreal m_devicePixelRatio = 1.0;
+    double m_zoom = 0.0;
+    QPointF m_offset;
+};
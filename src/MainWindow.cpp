@@ -2,6 +2,10 @@
 #include "CanvasWidget.h"
 #include "ToolSettingsWidget.h"
 #include "Dialogs.h"
+#include "Trace.h"
+#include "ProjectGenerator.h"
+#include "ProjectBatch.h"
+#include "ProjectReport.h"
 
 #include <QMenuBar>
 #include <QStatusBar>
@@ -29,6 +33,14 @@
 #include <QMessageBox>
 #include <QRegularExpression>
 #include <QInputDialog>
+#include <QProgressBar>
+#include <QFileInfo>
+#include <QCheckBox>
+#include <QFormLayout>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtPdf/QPdfDocument>
+#include <memory>
+#include <mutex>
 MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
     m_canvasStack = new QStackedWidget(this);
     setCentralWidget(m_canvasStack);
@@ -53,6 +65,23 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
     m_settingsDock->setFeatures(QDockWidget::NoDockWidgetFeatures);
     addDockWidget(Qt::BottomDockWidgetArea, m_settingsDock);
 
+    // Wskaźnik wczytywania tła w pasku stanu (ukryty, gdy nic się nie wczytuje)
+    m_backgroundLoadProgress = new QProgressBar(this);
+    m_backgroundLoadProgress->setRange(0, 100);
+    m_backgroundLoadProgress->setMaximumWidth(160);
+    m_backgroundLoadCancelBtn = new QToolButton(this);
+    m_backgroundLoadCancelBtn->setText(QString::fromUtf8("Anuluj"));
+    connect(m_backgroundLoadCancelBtn, &QToolButton::clicked, this, [this]() {
+        if (m_pdfImportWatcher) {
+            m_pdfImportWatcher->cancel();
+        } else if (m_loadingCanvas) {
+            m_loadingCanvas->cancelBackgroundLoad();
+        }
+    });
+    statusBar()->addPermanentWidget(m_backgroundLoadProgress);
+    statusBar()->addPermanentWidget(m_backgroundLoadCancelBtn);
+    setBackgroundLoadIndicatorVisible(false);
+
     buildProjectPanel();
     createMenus();
     setProjectActive(false);
@@ -62,11 +91,22 @@ void MainWindow::createMenus() {
     auto fileMenu = menuBar()->addMenu("Plik");
     m_newProjectAction = fileMenu->addAction("Nowy projekt...");
     connect(m_newProjectAction, &QAction::triggered, this, &MainWindow::onNewProject);
+    m_measureSettingsAction = fileMenu->addAction("Ustawienia pomiarów...");
+    connect(m_measureSettingsAction, &QAction::triggered, this, &MainWindow::onMeasureSettings);
+    m_projectReportAction = fileMenu->addAction("Raport projektu...");
+    connect(m_projectReportAction, &QAction::triggered, this, &MainWindow::onProjectReport);
     auto viewMenu = menuBar()->addMenu("Widok");
     m_toggleMeasuresLayerAction = viewMenu->addAction("Warstwy → Pomiary");
     m_toggleMeasuresLayerAction->setCheckable(true);
     m_toggleMeasuresLayerAction->setChecked(true);
     connect(m_toggleMeasuresLayerAction, &QAction::toggled, this, &MainWindow::onToggleMeasuresLayer);
+    viewMenu->addSeparator();
+    m_paintProfilerAction = viewMenu->addAction("Profiler rysowania");
+    m_paintProfilerAction->setCheckable(true);
+    m_paintProfilerAction->setShortcut(QKeySequence(Qt::Key_F12));
+    connect(m_paintProfilerAction, &QAction::toggled, this, &MainWindow::onTogglePaintProfiler);
+    m_exportPaintProfileAction = viewMenu->addAction("Eksportuj statystyki rysowania...");
+    connect(m_exportPaintProfileAction, &QAction::triggered, this, &MainWindow::onExportPaintProfile);
 }
 void MainWindow::onOpenBackground() {
     if (!m_canvas) {
@@ -76,13 +116,23 @@ void MainWindow::onOpenBackground() {
     if (fn.isEmpty()) {
         return;
     }
-    if (!m_canvas->loadBackgroundFile(fn)) {
-        QMessageBox::warning(this,
-                             QString::fromUtf8("Błąd wczytania tła"),
-                             QString::fromUtf8("Nie udało się wczytać wybranego pliku tła."));
-        return;
-    }
-    updateBackgroundControls();
+    // Dekodowanie odbywa się w tle; wynik obsługują połączenia z
+    // ensureFloorCanvas().
+    m_canvas->loadBackgroundFileAsync(fn);
+    m_loadingCanvas = m_canvas;
+    // Podczas importu PDF pasek pokazuje import; to wczytywanie przejmie
+    // go po jego zakończeniu.
+    if (!m_pdfImportWatcher) {
+        m_backgroundLoadProgress->setRange(0, 100);
+        m_backgroundLoadProgress->setValue(0);
+    }
+    setBackgroundLoadIndicatorVisible(true);
+    statusBar()->showMessage(QString::fromUtf8("Wczytywanie tła: %1").arg(QFileInfo(fn).fileName()));
+}
+
+void MainWindow::setBackgroundLoadIndicatorVisible(bool visible) {
+    m_backgroundLoadProgress->setVisible(visible);
+    m_backgroundLoadCancelBtn->setVisible(visible);
 }
 void MainWindow::onToggleBackground() {
     if (!m_canvas || !m_canvas->hasBackground()) {
@@ -107,7 +157,53 @@ void MainWindow::onAdjustBackground() {
     showBackgroundAdjustControls();
 }
 void MainWindow::onToggleMeasuresLayer() { m_canvas->toggleMeasuresVisibility(); }
+void MainWindow::onTogglePaintProfiler(bool visible) {
+    if (m_canvas) {
+        m_canvas->setPaintProfilerVisible(visible);
+    }
+}
+void MainWindow::onExportPaintProfile() {
+    if (!m_canvas) {
+        return;
+    }
+    if (m_canvas->paintProfileFrameCount() == 0) {
+        QMessageBox::information(this, QString::fromUtf8("Profiler rysowania"),
+                                 QString::fromUtf8("Brak zebranych klatek. Włącz profiler (F12) i przesuń lub powiększ widok."));
+        return;
+    }
+    QString fn = QFileDialog::getSaveFileName(this, QString::fromUtf8("Zapisz statystyki rysowania"),
+                                              QStringLiteral("profil_rysowania.csv"),
+                                              QStringLiteral("CSV (*.csv)"));
+    if (fn.isEmpty()) {
+        return;
+    }
+    if (!fn.endsWith(QStringLiteral(".csv"), Qt::CaseInsensitive)) fn += QStringLiteral(".csv");
+    if (!m_canvas->exportPaintProfile(fn)) {
+        QMessageBox::warning(this, QString::fromUtf8("Profiler rysowania"),
+                             QString::fromUtf8("Nie udało się zapisać pliku:\n%1").arg(fn));
+        return;
+    }
+    statusBar()->showMessage(QString::fromUtf8("Zapisano statystyki rysowania: %1").arg(QFileInfo(fn).fileName()));
+}
 void MainWindow::onReport() { m_canvas->openReportDialog(this); }
+
+void MainWindow::onProjectReport() {
+    // Raport czyta listy pomiarów kondygnacji w miejscu, bez kopiowania
+    std::vector<ProjectReportSource> sources;
+    for (int b = 0; b < m_buildings.size(); ++b) {
+        const Building& building = m_buildings[b];
+        for (int f = 0; f < building.floors.size(); ++f) {
+            const FloorData& floor = building.floors[f];
+            if (floor.canvas) {
+                sources.push_back(ProjectReportSource{b, f, building.name, floor.name,
+                                                      &floor.canvas->measurementsTool().measures()});
+            }
+        }
+    }
+    const ProjectReport report(std::move(sources));
+    ProjectReportDialog dlg(this, &m_settings, &report);
+    dlg.exec();
+}
 void MainWindow::onMeasureLinear() {
     m_canvas->startMeasureLinear();
 }
@@ -142,6 +238,43 @@ void MainWindow::onNewProject() {
     statusBar()->showMessage(QString::fromUtf8("Utworzono projekt: %1").arg(m_projectName));
 }
 
+void MainWindow::loadGeneratedProject(const GeneratedProject& project) {
+    for (auto& building : m_buildings) {
+        for (auto& floor : building.floors) {
+            removeFloorCanvas(floor);
+        }
+    }
+    m_buildings.clear();
+    for (const auto& generated : project.buildings) {
+        Building building;
+        building.name = generated.name;
+        for (const auto& floor : generated.floors) {
+            building.floors.append(FloorData{floor.name, nullptr});
+        }
+        m_buildings.push_back(building);
+    }
+
+    // Rzut jest jeden dla całego projektu – magazyn trzyma go raz
+    const BackgroundHandle plan =
+        m_backgroundStore->insert(ProjectGenerator::makeFloorPlan(project.floorSize, project.seed));
+    for (int b = 0; b < m_buildings.size(); ++b) {
+        for (int f = 0; f < m_buildings[b].floors.size(); ++f) {
+            FloorData& floor = m_buildings[b].floors[f];
+            ensureFloorCanvas(floor);
+            if (!floor.canvas) {
+                continue;
+            }
+            floor.canvas->setBackgroundAsset(plan);
+            ProjectGenerator::populate(*floor.canvas, project.buildings[size_t(b)].floors[size_t(f)]);
+        }
+    }
+
+    m_projectFilePath = createProjectTempFile(project.name, project.address, project.investor);
+    setProjectActive(true);
+    refreshProjectPanel();
+    statusBar()->showMessage(QString::fromUtf8("Wygenerowano projekt: %1").arg(m_projectName));
+}
+
 void MainWindow::onAddBuilding() {
     Building building;
     building.name = nextBuildingName();
@@ -289,6 +422,12 @@ void MainWindow::setProjectActive(bool active) {
     if (m_reportAction) {
         m_reportAction->setEnabled(enabled);
     }
+    if (m_measureSettingsAction) {
+        m_measureSettingsAction->setEnabled(enabled);
+    }
+    if (m_projectReportAction) {
+        m_projectReportAction->setEnabled(enabled);
+    }
     if (m_measureLinearAction) {
         m_measureLinearAction->setEnabled(enabled);
     }
@@ -301,6 +440,12 @@ void MainWindow::setProjectActive(bool active) {
     if (m_toggleMeasuresLayerAction) {
         m_toggleMeasuresLayerAction->setEnabled(enabled);
     }
+    if (m_paintProfilerAction) {
+        m_paintProfilerAction->setEnabled(enabled);
+    }
+    if (m_exportPaintProfileAction) {
+        m_exportPaintProfileAction->setEnabled(enabled);
+    }
     if (m_leftDock) {
         m_leftDock->setEnabled(enabled);
     }
@@ -396,12 +541,15 @@ void MainWindow::buildProjectPanel() {
     m_scaleBackgroundBtn = new QPushButton(QString::fromUtf8("Wyskaluj tło"), m_backgroundPanel);
     m_adjustBackgroundBtn = new QPushButton(QString::fromUtf8("Dopasuj tło"), m_backgroundPanel);
     m_applyBackgroundBtn = new QPushButton(QString::fromUtf8("Zastosuj do..."), m_backgroundPanel);
+    m_importBuildingPdfBtn = new QPushButton(QString::fromUtf8("Importuj PDF budynku..."), m_backgroundPanel);
+    m_importBuildingPdfBtn->setToolTip(QString::fromUtf8("Wczytuje kolejne strony PDF jako tła pięter budynku"));
     m_clearBackgroundBtn = new QPushButton(QString::fromUtf8("Usuń tło"), m_backgroundPanel);
     m_backgroundOpacitySlider = new QSlider(Qt::Horizontal, m_backgroundPanel);
     m_backgroundOpacitySlider->setRange(0, 100);
     m_backgroundOpacitySlider->setValue(100);
     m_backgroundOpacitySlider->setToolTip(QString::fromUtf8("Przezroczystość tła"));
     backgroundLayout->addWidget(m_insertBackgroundBtn);
+    backgroundLayout->addWidget(m_importBuildingPdfBtn);
     backgroundLayout->addWidget(m_toggleBackgroundBtn);
     backgroundLayout->addWidget(m_scaleBackgroundBtn);
     backgroundLayout->addWidget(m_adjustBackgroundBtn);
@@ -425,10 +573,12 @@ void MainWindow::buildProjectPanel() {
     measurementsLayout->setContentsMargins(20, 0, 0, 0);
     measurementsLayout->setSpacing(6);
     m_reportBtn = new QPushButton(QString::fromUtf8("Raport..."), m_measurementsPanel);
+    m_projectReportBtn = new QPushButton(QString::fromUtf8("Raport projektu..."), m_measurementsPanel);
     m_measureLinearBtn = new QPushButton(QString::fromUtf8("Pomiar liniowy"), m_measurementsPanel);
     m_measurePolylineBtn = new QPushButton(QString::fromUtf8("Pomiar wieloliniowy (polilinia)"), m_measurementsPanel);
     m_measureAdvancedBtn = new QPushButton(QString::fromUtf8("Pomiar zaawansowany..."), m_measurementsPanel);
     measurementsLayout->addWidget(m_reportBtn);
+    measurementsLayout->addWidget(m_projectReportBtn);
     measurementsLayout->addWidget(m_measureLinearBtn);
     measurementsLayout->addWidget(m_measurePolylineBtn);
     measurementsLayout->addWidget(m_measureAdvancedBtn);
@@ -468,8 +618,10 @@ void MainWindow::buildProjectPanel() {
     connect(m_scaleBackgroundBtn, &QPushButton::clicked, this, &MainWindow::onSetScale);
     connect(m_adjustBackgroundBtn, &QPushButton::clicked, this, &MainWindow::onAdjustBackground);
     connect(m_applyBackgroundBtn, &QPushButton::clicked, this, &MainWindow::onApplyBackgroundTo);
+    connect(m_importBuildingPdfBtn, &QPushButton::clicked, this, &MainWindow::onImportBuildingPdf);
     connect(m_clearBackgroundBtn, &QPushButton::clicked, this, &MainWindow::onClearBackground);
     connect(m_reportBtn, &QPushButton::clicked, this, &MainWindow::onReport);
+    connect(m_projectReportBtn, &QPushButton::clicked, this, &MainWindow::onProjectReport);
     connect(m_measureLinearBtn, &QPushButton::clicked, this, &MainWindow::onMeasureLinear);
     connect(m_measurePolylineBtn, &QPushButton::clicked, this, &MainWindow::onMeasurePolyline);
     connect(m_measureAdvancedBtn, &QPushButton::clicked, this, &MainWindow::onMeasureAdvanced);
@@ -558,6 +710,7 @@ QString MainWindow::createProjectTempFile(const QString& projectName,
 }
 
 void MainWindow::writeProjectTempFile() {
+    TRACE_SCOPE("MainWindow::writeProjectTempFile");
     if (m_projectFilePath.isEmpty()) {
         return;
     }
@@ -633,7 +786,13 @@ void MainWindow::applyCanvasForSelection() {
     if (m_canvasStack && floor->canvas) {
         m_canvasStack->setCurrentWidget(floor->canvas);
     }
+    if (m_canvas && m_canvas != floor->canvas) {
+        m_canvas->setPaintProfilerVisible(false);
+    }
     m_canvas = floor->canvas;
+    if (m_canvas && m_paintProfilerAction) {
+        m_canvas->setPaintProfilerVisible(m_paintProfilerAction->isChecked());
+    }
     updateBackgroundControls();
 }
 
@@ -669,7 +828,37 @@ void MainWindow::ensureFloorCanvas(FloorData& floor) {
         return;
     }
     floor.canvas = new CanvasWidget(m_canvasStack, &m_settings);
+    floor.canvas->setBackgroundStore(m_backgroundStore);
     m_canvasStack->addWidget(floor.canvas);
+
+    CanvasWidget* canvas = floor.canvas;
+    connect(canvas, &CanvasWidget::backgroundLoadProgress, this, [this, canvas](int percent) {
+        if (canvas == m_loadingCanvas && !m_pdfImportWatcher) {
+            m_backgroundLoadProgress->setValue(percent);
+        }
+    });
+    connect(canvas, &CanvasWidget::backgroundLoadFinished, this, [this, canvas](bool success) {
+        if (canvas == m_loadingCanvas) {
+            m_loadingCanvas = nullptr;
+            setBackgroundLoadIndicatorVisible(m_pdfImportWatcher != nullptr);
+        }
+        updateBackgroundControls();
+        if (!success) {
+            statusBar()->clearMessage();
+            QMessageBox::warning(this,
+                                 QString::fromUtf8("Błąd wczytania tła"),
+                                 QString::fromUtf8("Nie udało się wczytać wybranego pliku tła."));
+            return;
+        }
+        statusBar()->showMessage(QString::fromUtf8("Wczytano tło"), 3000);
+    });
+    connect(canvas, &CanvasWidget::backgroundLoadCanceled, this, [this, canvas]() {
+        if (canvas == m_loadingCanvas) {
+            m_loadingCanvas = nullptr;
+            setBackgroundLoadIndicatorVisible(m_pdfImportWatcher != nullptr);
+            statusBar()->showMessage(QString::fromUtf8("Anulowano wczytywanie tła"), 3000);
+        }
+    });
 }
 
 void MainWindow::removeFloorCanvas(FloorData& floor) {
@@ -695,6 +884,38 @@ bool MainWindow::hasOtherFloors() const {
     return false;
 }
 
+std::vector<CanvasWidget*> MainWindow::allCanvases() const {
+    std::vector<CanvasWidget*> canvases;
+    for (const auto& building : m_buildings) {
+        for (const auto& floor : building.floors) {
+            if (floor.canvas) {
+                canvases.push_back(floor.canvas);
+            }
+        }
+    }
+    return canvases;
+}
+
+void MainWindow::onMeasureSettings() {
+    MeasureSettingsDialog dlg(this, m_settings);
+    if (dlg.exec() != QDialog::Accepted) {
+        return;
+    }
+    m_settings = dlg.settings();
+    // Płótna wskazują na m_settings, więc nowe wartości (np. miejsca po
+    // przecinku) widzą od razu; skala się nie zmienia, więc długości
+    // zostają.  Kolor i grubość istniejących pomiarów wszystkich
+    // kondygnacji zmieniamy równolegle, a run() odświeża każde płótno raz.
+    ProjectBatch batch(allCanvases());
+    if (dlg.applyToExisting()) {
+        batch.setMeasureColor(m_settings.defaultMeasureColor);
+        batch.setMeasureLineWidth(m_settings.lineWidthPx);
+    }
+    const int floors = batch.run();
+    statusBar()->showMessage(QString::fromUtf8("Zaktualizowano ustawienia pomiarów (kondygnacje: %1)").arg(floors),
+                             3000);
+}
+
 void MainWindow::onApplyBackgroundTo() {
     if (!m_canvas || !m_canvas->hasBackground()) {
         return;
@@ -739,8 +960,9 @@ void MainWindow::onApplyBackgroundTo() {
         return;
     }
 
-    const QImage background = m_canvas->backgroundImage();
-    if (background.isNull()) {
+    // Piętra otrzymują uchwyt do tego samego podkładu – obraz nie jest kopiowany.
+    const BackgroundHandle background = m_canvas->backgroundAsset();
+    if (!background) {
         return;
     }
 
@@ -763,7 +985,7 @@ void MainWindow::onApplyBackgroundTo() {
             auto& floor = building.floors[floorIndex];
             ensureFloorCanvas(floor);
             if (floor.canvas) {
-                floor.canvas->setBackgroundImage(background);
+                floor.canvas->setBackgroundAsset(background);
                 floor.canvas->setBackgroundVisible(true);
             }
         }
@@ -771,6 +993,148 @@ void MainWindow::onApplyBackgroundTo() {
     updateBackgroundControls();
 }
 
+void MainWindow::onImportBuildingPdf() {
+    int buildingIndex = m_buildingCombo ? m_buildingCombo->currentIndex() : -1;
+    if (buildingIndex < 0 || buildingIndex >= m_buildings.size() || m_pdfImportWatcher) {
+        return;
+    }
+    QString fn = QFileDialog::getOpenFileName(this, QString::fromUtf8("Wybierz PDF budynku"),
+                                              QString(), "PDF (*.pdf)");
+    if (fn.isEmpty()) {
+        return;
+    }
+
+    // Dokument otwieramy tylko raz; wszystkie strony renderowane są z tej
+    // samej instancji.  Podkłady stron trzymają do niego odniesienia,
+    // a ostatnie z nich może zniknąć w wątku puli (np. wynik porzucony po
+    // anulowaniu), więc obiekt usuwa pętla zdarzeń wątku GUI.
+    std::shared_ptr<QPdfDocument> pdf(new QPdfDocument, [](QPdfDocument* doc) { doc->deleteLater(); });
+    if (pdf->load(fn) != QPdfDocument::Error::None || pdf->pageCount() < 1) {
+        QMessageBox::warning(this,
+                             QString::fromUtf8("Błąd wczytania tła"),
+                             QString::fromUtf8("Nie udało się otworzyć wybranego pliku PDF."));
+        return;
+    }
+    const int pageCount = pdf->pageCount();
+    auto& building = m_buildings[buildingIndex];
+
+    // Dialog przypisania stron do pięter: domyślnie piętro i → strona i.
+    QDialog dialog(this);
+    dialog.setWindowTitle(QString::fromUtf8("Import PDF – %1").arg(building.name));
+    auto* layout = new QVBoxLayout(&dialog);
+    auto* info = new QLabel(QString::fromUtf8("Dokument zawiera %1 stron. Wybierz stronę dla każdego piętra.\n"
+                                              "Uwaga: Po imporcie konieczne jest wyskalowanie tła każdego piętra.")
+                                .arg(pageCount), &dialog);
+    info->setWordWrap(true);
+    layout->addWidget(info);
+    auto* form = new QFormLayout();
+    QVector<QComboBox*> pageCombos;
+    for (int f = 0; f < building.floors.size(); ++f) {
+        auto* combo = new QComboBox(&dialog);
+        combo->addItem(QString::fromUtf8("— bez zmian —"), -1);
+        for (int page = 0; page < pageCount; ++page) {
+            combo->addItem(QString::fromUtf8("Strona %1").arg(page + 1), page);
+        }
+        combo->setCurrentIndex(f < pageCount ? f + 1 : 0);
+        form->addRow(building.floors[f].name, combo);
+        pageCombos.append(combo);
+    }
+    layout->addLayout(form);
+    QCheckBox* addFloorsCheck = nullptr;
+    if (pageCount > building.floors.size()) {
+        addFloorsCheck = new QCheckBox(QString::fromUtf8("Dodaj piętra dla pozostałych stron (%1)")
+                                           .arg(pageCount - building.floors.size()), &dialog);
+        addFloorsCheck->setChecked(true);
+        layout->addWidget(addFloorsCheck);
+    }
+    auto* buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    layout->addWidget(buttons);
+    connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    if (dialog.exec() != QDialog::Accepted) {
+        return;
+    }
+
+    QVector<int> pages;
+    m_pdfImportTargets.clear();
+    for (int f = 0; f < pageCombos.size(); ++f) {
+        const int page = pageCombos[f]->currentData().toInt();
+        if (page < 0) {
+            continue;
+        }
+        ensureFloorCanvas(building.floors[f]);
+        pages.append(page);
+        m_pdfImportTargets.append(building.floors[f].canvas);
+    }
+    if (addFloorsCheck && addFloorsCheck->isChecked()) {
+        for (int page = building.floors.size(); page < pageCount; ++page) {
+            building.floors.append(FloorData{nextFloorName(building), nullptr});
+            ensureFloorCanvas(building.floors.last());
+            pages.append(page);
+            m_pdfImportTargets.append(building.floors.last().canvas);
+        }
+        refreshProjectPanel(buildingIndex, m_floorCombo ? m_floorCombo->currentIndex() : 0);
+        writeProjectTempFile();
+    }
+    if (pages.isEmpty()) {
+        return;
+    }
+
+    // Strony przetwarzane są w puli wątków; każdy gotowy wynik trafia od
+    // razu na płótno swojego piętra.  Samą rasteryzację QtPdf szereguje
+    // globalną blokadą pdfium – równolegle przebiega budowa piramid
+    // kafelków i rejestracja w magazynie.
+    m_pdfImportDocument = pdf;
+    m_pdfImportWatcher = new QFutureWatcher<BackgroundLoadResult>(this);
+    connect(m_pdfImportWatcher, &QFutureWatcher<BackgroundLoadResult>::progressValueChanged,
+            m_backgroundLoadProgress, &QProgressBar::setValue);
+    connect(m_pdfImportWatcher, &QFutureWatcher<BackgroundLoadResult>::resultReadyAt, this, [this](int index) {
+        if (!m_pdfImportWatcher || index < 0 || index >= m_pdfImportTargets.size()) {
+            return;
+        }
+        CanvasWidget* canvas = m_pdfImportTargets[index];
+        if (canvas) {
+            canvas->setLoadedBackground(m_pdfImportWatcher->resultAt(index));
+            canvas->setBackgroundVisible(true);
+        }
+        updateBackgroundControls();
+    });
+    connect(m_pdfImportWatcher, &QFutureWatcher<BackgroundLoadResult>::finished, this, [this]() {
+        const bool canceled = m_pdfImportWatcher->isCanceled();
+        m_pdfImportWatcher->deleteLater();
+        m_pdfImportWatcher = nullptr;
+        m_pdfImportTargets.clear();
+        // Wszystkie zadania już się zakończyły – dokument zwalniamy w wątku GUI
+        m_pdfImportDocument.reset();
+        // Trwające wczytywanie pojedynczego tła odzyskuje pasek postępu
+        if (m_loadingCanvas) {
+            m_backgroundLoadProgress->setRange(0, 100);
+        }
+        setBackgroundLoadIndicatorVisible(m_loadingCanvas != nullptr);
+        updateBackgroundControls();
+        statusBar()->showMessage(canceled ? QString::fromUtf8("Anulowano import PDF")
+                                          : QString::fromUtf8("Zaimportowano strony PDF"), 3000);
+    });
+    m_backgroundLoadProgress->setRange(0, pages.size());
+    m_backgroundLoadProgress->setValue(0);
+    setBackgroundLoadIndicatorVisible(true);
+    statusBar()->showMessage(QString::fromUtf8("Import PDF: %1").arg(QFileInfo(fn).fileName()));
+    // Skrót pliku liczy pierwsze zadanie (raz, poza wątkiem GUI); pozostałe
+    // czekają na niego w call_once.
+    struct ImportFileKey {
+        std::once_flag once;
+        QByteArray key;
+    };
+    auto fileKey = std::make_shared<ImportFileKey>();
+    std::weak_ptr<QPdfDocument> document = pdf;
+    pdf.reset();
+    m_pdfImportWatcher->setFuture(QtConcurrent::mapped(pages, [document, fileKey, fn, store = m_backgroundStore](int page) {
+        std::call_once(fileKey->once, [&]() { fileKey->key = BackgroundStore::fileKey(fn); });
+        return BackgroundLoader::renderPdfPage(document.lock(), page, store,
+                                               BackgroundStore::sourceKey(fileKey->key, page));
+    }));
+}
+
 void MainWindow::onClearBackground() {
     if (!m_canvas || !m_canvas->hasBackground()) {
         return;
@@ -1,8 +1,13 @@
 #pragma once
 #include <QMainWindow>
 #include <QVector>
+#include <QPointer>
+#include <QFutureWatcher>
+#include <vector>
 #include "Settings.h"
+#include "BackgroundLoader.h"
 class CanvasWidget;
+struct GeneratedProject;
 class QDockWidget;
 class QAction;
 class QLabel;
@@ -11,21 +16,32 @@ class QPushButton;
 class QToolButton;
 class QStackedWidget;
 class QSlider;
+class QProgressBar;
 class MainWindow : public QMainWindow {
     Q_OBJECT
 public:
     explicit MainWindow(QWidget* parent = nullptr);
     ProjectSettings& settings() { return m_settings; }
+    /**
+     * Zastępuje bieżący projekt projektem wygenerowanym (testy
+     * obciążeniowe).  Wszystkie kondygnacje współdzielą jeden podkład
+     * z rzutem.
+     */
+    void loadGeneratedProject(const GeneratedProject& project);
 private slots:
     void onOpenBackground();
     void onToggleBackground();
     void onSetScale();
     void onToggleMeasuresLayer();
+    void onTogglePaintProfiler(bool visible);
+    void onExportPaintProfile();
     void onReport();
+    void onProjectReport();
     void onMeasureLinear();
     void onMeasurePolyline();
     void onMeasureAdvanced();
     void onNewProject();
+    void onMeasureSettings();
     void onAddBuilding();
     void onRemoveBuilding();
     void onRenameBuilding();
@@ -35,6 +51,7 @@ private slots:
     void onBuildingChanged(int index);
     void onFloorChanged(int index);
     void onApplyBackgroundTo();
+    void onImportBuildingPdf();
     void onClearBackground();
     void onAdjustBackground();
 private:
@@ -49,6 +66,8 @@ private:
 
     CanvasWidget* m_canvas = nullptr;
     ProjectSettings m_settings;
+    // Wspólny magazyn podkładów wszystkich pięter projektu
+    std::shared_ptr<BackgroundStore> m_backgroundStore = std::make_shared<BackgroundStore>();
     void createMenus();
     void setProjectActive(bool active);
     void buildProjectPanel();
@@ -66,8 +85,11 @@ private:
     void ensureFloorCanvas(FloorData& floor);
     void removeFloorCanvas(FloorData& floor);
     bool hasOtherFloors() const;
+    /// Płótna wszystkich kondygnacji, które już je mają.
+    std::vector<CanvasWidget*> allCanvases() const;
     void showScaleControls();
     void showBackgroundAdjustControls();
+    void setBackgroundLoadIndicatorVisible(bool visible);
     // Puste panele boczne (lewy/prawy)
     class QDockWidget* m_leftDock = nullptr;
     class QDockWidget* m_rightDock = nullptr;
@@ -75,11 +97,15 @@ private:
     class ToolSettingsWidget* m_settingsDock = nullptr;
     QStackedWidget* m_canvasStack = nullptr;
     QAction* m_newProjectAction = nullptr;
+    QAction* m_measureSettingsAction = nullptr;
     QAction* m_reportAction = nullptr;
+    QAction* m_projectReportAction = nullptr;
     QAction* m_measureLinearAction = nullptr;
     QAction* m_measurePolylineAction = nullptr;
     QAction* m_measureAdvancedAction = nullptr;
     QAction* m_toggleMeasuresLayerAction = nullptr;
+    QAction* m_paintProfilerAction = nullptr;
+    QAction* m_exportPaintProfileAction = nullptr;
 
     QLabel* m_projectNameLabel = nullptr;
     QWidget* m_projectControls = nullptr;
@@ -92,11 +118,24 @@ private:
     QPushButton* m_toggleBackgroundBtn = nullptr;
     QPushButton* m_scaleBackgroundBtn = nullptr;
     QPushButton* m_applyBackgroundBtn = nullptr;
+    QPushButton* m_importBuildingPdfBtn = nullptr;
     QPushButton* m_clearBackgroundBtn = nullptr;
     QPushButton* m_adjustBackgroundBtn = nullptr;
     QSlider* m_backgroundOpacitySlider = nullptr;
+    // Pasek postępu i przycisk anulowania wczytywania tła (pasek stanu)
+    QProgressBar* m_backgroundLoadProgress = nullptr;
+    QToolButton* m_backgroundLoadCancelBtn = nullptr;
+    QPointer<CanvasWidget> m_loadingCanvas;
+    // Import wielostronicowego PDF: zadanie renderujące strony, płótna
+    // pięter docelowych (indeksy zgodne z wynikami zadania) oraz dokument.
+    // Dokument należy do wątku GUI i jest zwalniany dopiero po zakończeniu
+    // zadania; zadania trzymają tylko słabe odniesienie.
+    QFutureWatcher<BackgroundLoadResult>* m_pdfImportWatcher = nullptr;
+    QVector<QPointer<CanvasWidget>> m_pdfImportTargets;
+    std::shared_ptr<QPdfDocument> m_pdfImportDocument;
     QWidget* m_measurementsPanel = nullptr;
     QPushButton* m_reportBtn = nullptr;
+    QPushButton* m_projectReportBtn = nullptr;
     QPushButton* m_measureLinearBtn = nullptr;
     QPushButton* m_measurePolylineBtn = nullptr;
     QPushButton* m_measureAdvancedBtn = nullptr;
@@ -0,0 +1,63 @@
+#include "MeasureGeometry.h"
+
+#include "Measurements.h"
+#include "PointKernels.h"
+
+#include <algorithm>
+
+QRectF PointsView::boundingRect() const {
+    if (empty()) {
+        return QRectF();
+    }
+    double minX = m_data[0].x(), maxX = minX;
+    double minY = m_data[0].y(), maxY = minY;
+    for (const QPointF& pt : *this) {
+        minX = std::min(minX, pt.x());
+        maxX = std::max(maxX, pt.x());
+        minY = std::min(minY, pt.y());
+        maxY = std::max(maxY, pt.y());
+    }
+    return QRectF(QPointF(minX, minY), QPointF(maxX, maxY));
+}
+
+PointSpan MeasureGeometry::append(PointsView pts) {
+    PointSpan span;
+    span.offset = quint32(m_points.size());
+    span.count = quint32(pts.size());
+    m_points.insert(m_points.end(), pts.begin(), pts.end());
+    return span;
+}
+
+void MeasureGeometry::release(const PointSpan& span) {
+    m_unused += span.count;
+}
+
+bool MeasureGeometry::wantsCompaction() const {
+    return m_unused > 1024 && m_unused * 2 > m_points.size();
+}
+
+void MeasureGeometry::compact(std::vector<Measure>& measures) {
+    std::vector<QPointF> packed;
+    size_t used = 0;
+    for (const Measure& m : measures) {
+        used += m.points.count;
+    }
+    packed.reserve(used);
+    for (Measure& m : measures) {
+        const quint32 offset = quint32(packed.size());
+        const auto first = m_points.begin() + m.points.offset;
+        packed.insert(packed.end(), first, first + m.points.count);
+        m.points.offset = offset;
+    }
+    m_points.swap(packed);
+    m_unused = 0;
+}
+
+void MeasureGeometry::scale(double factor) {
+    PointKernels::scale(m_points.data(), m_points.size(), factor);
+}
+
+void MeasureGeometry::clear() {
+    m_points.clear();
+    m_unused = 0;
+}
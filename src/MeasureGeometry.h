@@ -0,0 +1,85 @@
+#pragma once
+#include <QPointF>
+#include <QRectF>
+#include <QtGlobal>
+#include <cstddef>
+#include <vector>
+
+struct Measure;
+
+/// Widok (bez własności) ciągłego fragmentu punktów.
+class PointsView {
+public:
+    PointsView() = default;
+    PointsView(const QPointF* data, size_t size) : m_data(data), m_size(size) {}
+    PointsView(const std::vector<QPointF>& pts) : m_data(pts.data()), m_size(pts.size()) {}
+
+    const QPointF* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    const QPointF* begin() const { return m_data; }
+    const QPointF* end() const { return m_data + m_size; }
+    const QPointF& operator[](size_t i) const { return m_data[i]; }
+    const QPointF& front() const { return m_data[0]; }
+    const QPointF& back() const { return m_data[m_size - 1]; }
+
+    /// Prostokąt ograniczający punkty (pusty dla pustego widoku).
+    QRectF boundingRect() const;
+
+private:
+    const QPointF* m_data = nullptr;
+    size_t m_size = 0;
+};
+
+/// Położenie punktów jednego pomiaru we wspólnym buforze.
+struct PointSpan {
+    quint32 offset = 0;
+    quint32 count = 0;
+};
+
+/**
+ * Wspólny bufor współrzędnych wszystkich pomiarów płótna.  Punkty
+ * kolejnych pomiarów leżą w nim jeden za drugim, a pomiar pamięta tylko
+ * swój fragment (Measure::points), więc rysowanie, liczenie długości
+ * i skalowanie przechodzą po pamięci liniowo zamiast skakać po osobnych
+ * alokacjach każdego pomiaru.
+ *
+ * Bufor należy do kondygnacji (MeasurementsTool płótna), a nie do całego
+ * projektu: każda kondygnacja ma własną skalę i jest rysowana, trafiana
+ * i skalowana osobno, więc te przebiegi i tak obejmują punkty jednego
+ * piętra.  Operacje całego projektu (ProjectBatch) dzielą pracę na
+ * kondygnacje i bez wspólnego bufora nie potrzebują blokad między
+ * wątkami.
+ *
+ * Usunięcie pomiaru zostawia w buforze nieużywany fragment; compact
+ * przepisuje bufor w kolejności pomiarów, gdy takich fragmentów jest
+ * dużo albo kolejność pomiarów się zmieniła.
+ */
+class MeasureGeometry {
+public:
+    /// Dopisuje punkty na końcu bufora i zwraca ich fragment.
+    PointSpan append(PointsView pts);
+    PointsView points(const PointSpan& span) const {
+        return PointsView(m_points.data() + span.offset, span.count);
+    }
+    /// Oznacza fragment usuniętego pomiaru jako nieużywany.
+    void release(const PointSpan& span);
+    /**
+     * Przepisuje bufor w kolejności measures, pomijając nieużywane
+     * fragmenty; aktualizuje Measure::points.
+     */
+    void compact(std::vector<Measure>& measures);
+    /// Czy nieużywane fragmenty zajmują większość bufora.
+    bool wantsCompaction() const;
+    /// Jednorodne skalowanie wszystkich punktów względem początku układu.
+    void scale(double factor);
+    void clear();
+
+    size_t pointCount() const { return m_points.size(); }
+    size_t unusedPointCount() const { return m_unused; }
+    const std::vector<QPointF>& buffer() const { return m_points; }
+
+private:
+    std::vector<QPointF> m_points;
+    size_t m_unused = 0;
+};
@@ -0,0 +1,297 @@
+#include "MeasureReportModel.h"
+
+#include "Settings.h"
+
+#include <QApplication>
+#include <QBrush>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QStyle>
+#include <QStyleOptionButton>
+
+#include <algorithm>
+
+MeasureReportModel::MeasureReportModel(std::vector<Measure>* measures, ProjectSettings* settings,
+                                       MeasureTotals* projectTotals, QObject* parent)
+    : QAbstractTableModel(parent), m_measures(measures), m_settings(settings),
+      m_projectTotals(projectTotals) {
+    const int count = measureCount();
+    // Na starcie wszystkie wiersze są zaznaczone – sumy zaznaczonych to
+    // sumy projektu, o ile narzędzie je prowadzi.
+    m_checked.assign(size_t(count), 1);
+    if (m_projectTotals && m_projectTotals->count == count) {
+        m_checkedTotals = *m_projectTotals;
+    } else {
+        for (int r = 0; r < count; ++r) {
+            m_checkedTotals.add((*m_measures)[size_t(r)]);
+        }
+    }
+    m_fetchedRows = std::min(count, kFetchChunk);
+}
+
+int MeasureReportModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : m_fetchedRows;
+}
+
+int MeasureReportModel::columnCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+int MeasureReportModel::measureCount() const {
+    return m_measures ? int(m_measures->size()) : 0;
+}
+
+const Measure& MeasureReportModel::measureAt(int row) const {
+    return (*m_measures)[size_t(row)];
+}
+
+Measure& MeasureReportModel::measureAt(int row) {
+    return (*m_measures)[size_t(row)];
+}
+
+bool MeasureReportModel::isChecked(int row) const {
+    return row >= 0 && row < int(m_checked.size()) && m_checked[size_t(row)];
+}
+
+int MeasureReportModel::decimals() const {
+    return m_settings ? m_settings->decimals : 1;
+}
+
+QString MeasureReportModel::formatCm(double value) const {
+    return QString("%1 cm").arg(value, 0, 'f', decimals());
+}
+
+QString MeasureReportModel::typeName(MeasureType type) {
+    switch (type) {
+        case MeasureType::Linear: return QStringLiteral("Liniowy");
+        case MeasureType::Polyline: return QStringLiteral("Polilinia");
+        case MeasureType::Advanced: default: return QStringLiteral("Zaawansowany");
+    }
+}
+
+QString MeasureReportModel::columnTitle(int column) const {
+    // Jednostką projektu są centymetry
+    const QString unitLabel = QStringLiteral("cm");
+    switch (column) {
+        case ColCheck: return QStringLiteral("Check");
+        case ColId: return QStringLiteral("ID");
+        case ColName: return QString::fromUtf8("Nazwa");
+        case ColType: return QString::fromUtf8("Typ");
+        case ColLength: return QString::fromUtf8("Długość [%1]").arg(unitLabel);
+        case ColSum: return QString::fromUtf8("Suma z zapasami [%1]").arg(unitLabel);
+        case ColBufferStart: return QString::fromUtf8("Zapas początkowy [%1]").arg(unitLabel);
+        case ColBufferEnd: return QString::fromUtf8("Zapas końcowy [%1]").arg(unitLabel);
+        case ColColor: return QString::fromUtf8("Kolor");
+        case ColDate: return QString::fromUtf8("Data");
+        case ColEdit: return QString::fromUtf8("Edytuj");
+        case ColDelete: return QString::fromUtf8("Usuń");
+        default: return QStringLiteral("C%1").arg(column);
+    }
+}
+
+QString MeasureReportModel::cellText(int row, int column) const {
+    const Measure& m = measureAt(row);
+    switch (column) {
+        case ColCheck: return isChecked(row) ? QString(QChar(0x2713)) : QString();
+        case ColId: return QString::number(m.id);
+        case ColName: return m.name;
+        case ColType: return typeName(m.type);
+        case ColLength: return formatCm(m.lengthMeters);
+        case ColSum: return formatCm(m.totalWithBufferMeters);
+        case ColBufferStart: return formatCm(m.bufferDefaultMeters);
+        case ColBufferEnd: return formatCm(m.bufferFinalMeters);
+        // W eksporcie kolor zapisywany jest jako #rrggbb
+        case ColColor: return m.color.name();
+        case ColDate: return m.createdAt.toString("yyyy-MM-dd hh:mm");
+        default: return QString();
+    }
+}
+
+QVariant MeasureReportModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= m_fetchedRows) {
+        return QVariant();
+    }
+    const int row = index.row();
+    const int col = index.column();
+    const Measure& m = measureAt(row);
+    switch (role) {
+        case Qt::DisplayRole:
+            // Kolumna koloru pokazuje tylko tło, a przyciski rysuje delegat
+            if (col == ColCheck || col == ColColor || col == ColEdit || col == ColDelete) {
+                return QVariant();
+            }
+            return cellText(row, col);
+        case Qt::CheckStateRole:
+            if (col == ColCheck) {
+                return isChecked(row) ? Qt::Checked : Qt::Unchecked;
+            }
+            return QVariant();
+        case Qt::BackgroundRole:
+            if (col == ColColor) {
+                return QBrush(m.color);
+            }
+            return QVariant();
+        case Qt::UserRole:
+            if (col == ColColor) {
+                return m.color.name();
+            }
+            return QVariant();
+        case Qt::UserRole + 1:
+            // Wartości liczbowe (cm) kolumn długości i zapasów
+            switch (col) {
+                case ColLength: return m.lengthMeters;
+                case ColSum: return m.totalWithBufferMeters;
+                case ColBufferStart: return m.bufferDefaultMeters;
+                case ColBufferEnd: return m.bufferFinalMeters;
+                default: return QVariant();
+            }
+        default:
+            return QVariant();
+    }
+}
+
+bool MeasureReportModel::setData(const QModelIndex& index, const QVariant& value, int role) {
+    if (!index.isValid() || index.column() != ColCheck || role != Qt::CheckStateRole
+        || index.row() >= m_fetchedRows) {
+        return false;
+    }
+    const int row = index.row();
+    const bool checked = static_cast<Qt::CheckState>(value.toInt()) == Qt::Checked;
+    if (checked == isChecked(row)) {
+        return false;
+    }
+    m_checked[size_t(row)] = checked ? 1 : 0;
+    if (checked) {
+        m_checkedTotals.add(measureAt(row));
+    } else {
+        m_checkedTotals.remove(measureAt(row));
+    }
+    emit dataChanged(index, index, {Qt::CheckStateRole});
+    emit totalsChanged();
+    return true;
+}
+
+QVariant MeasureReportModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+    return columnTitle(section);
+}
+
+Qt::ItemFlags MeasureReportModel::flags(const QModelIndex& index) const {
+    if (!index.isValid()) {
+        return Qt::NoItemFlags;
+    }
+    Qt::ItemFlags f = Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+    if (index.column() == ColCheck) {
+        f |= Qt::ItemIsUserCheckable;
+    }
+    return f;
+}
+
+bool MeasureReportModel::canFetchMore(const QModelIndex& parent) const {
+    return !parent.isValid() && m_fetchedRows < measureCount();
+}
+
+void MeasureReportModel::fetchMore(const QModelIndex& parent) {
+    if (parent.isValid()) {
+        return;
+    }
+    const int n = std::min(kFetchChunk, measureCount() - m_fetchedRows);
+    if (n <= 0) {
+        return;
+    }
+    beginInsertRows(QModelIndex(), m_fetchedRows, m_fetchedRows + n - 1);
+    m_fetchedRows += n;
+    endInsertRows();
+}
+
+void MeasureReportModel::measureEdited(int row, const Measure& before) {
+    if (row < 0 || row >= measureCount()) {
+        return;
+    }
+    const Measure& after = measureAt(row);
+    if (isChecked(row)) {
+        m_checkedTotals.replace(before, after);
+    }
+    if (m_projectTotals) {
+        m_projectTotals->replace(before, after);
+    }
+    if (row < m_fetchedRows) {
+        emit dataChanged(index(row, 0), index(row, ColumnCount - 1));
+    }
+    emit totalsChanged();
+}
+
+void MeasureReportModel::removeMeasure(int row) {
+    if (row < 0 || row >= measureCount()) {
+        return;
+    }
+    const bool fetched = row < m_fetchedRows;
+    if (fetched) {
+        beginRemoveRows(QModelIndex(), row, row);
+    }
+    const Measure& removed = measureAt(row);
+    if (isChecked(row)) {
+        m_checkedTotals.remove(removed);
+    }
+    if (m_projectTotals) {
+        m_projectTotals->remove(removed);
+    }
+    m_measures->erase(m_measures->begin() + row);
+    m_checked.erase(m_checked.begin() + row);
+    if (fetched) {
+        --m_fetchedRows;
+        endRemoveRows();
+    }
+    emit totalsChanged();
+}
+
+// -------- ReportButtonDelegate --------
+ReportButtonDelegate::ReportButtonDelegate(const QString& text, QObject* parent)
+    : QStyledItemDelegate(parent), m_text(text) {}
+
+void ReportButtonDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option,
+                                 const QModelIndex& index) const {
+    QStyleOptionButton button;
+    button.rect = option.rect.adjusted(2, 2, -2, -2);
+    button.text = m_text;
+    button.fontMetrics = option.fontMetrics;
+    button.state = QStyle::State_Enabled
+        | (m_pressed.isValid() && m_pressed == index ? QStyle::State_Sunken : QStyle::State_Raised);
+    const QWidget* widget = option.widget;
+    QStyle* style = widget ? widget->style() : QApplication::style();
+    style->drawControl(QStyle::CE_PushButton, &button, painter, widget);
+}
+
+QSize ReportButtonDelegate::sizeHint(const QStyleOptionViewItem& option, const QModelIndex&) const {
+    return QSize(option.fontMetrics.horizontalAdvance(m_text) + 24, option.fontMetrics.height() + 10);
+}
+
+bool ReportButtonDelegate::editorEvent(QEvent* event, QAbstractItemModel*, const QStyleOptionViewItem& option,
+                                       const QModelIndex& index) {
+    if (event->type() != QEvent::MouseButtonPress && event->type() != QEvent::MouseButtonRelease) {
+        return false;
+    }
+    const auto* me = static_cast<QMouseEvent*>(event);
+    if (me->button() != Qt::LeftButton) {
+        return false;
+    }
+    const bool inside = option.rect.contains(me->position().toPoint());
+    if (event->type() == QEvent::MouseButtonPress) {
+        m_pressed = inside ? QPersistentModelIndex(index) : QPersistentModelIndex();
+        return inside;
+    }
+    const bool hit = inside && m_pressed.isValid() && m_pressed == index;
+    m_pressed = QPersistentModelIndex();
+    if (hit) {
+        // Obsługa (dialog, usunięcie wiersza) po powrocie z obsługi zdarzenia widoku
+        const QPersistentModelIndex target(index);
+        QMetaObject::invokeMethod(this, [this, target]() {
+            if (target.isValid()) {
+                emit clicked(target);
+            }
+        }, Qt::QueuedConnection);
+    }
+    return hit;
+}
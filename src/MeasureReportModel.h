@@ -0,0 +1,106 @@
+#pragma once
+#include <QAbstractTableModel>
+#include <QStyledItemDelegate>
+#include <vector>
+#include "Measurements.h"
+
+struct ProjectSettings;
+
+/**
+ * Model tabeli raportu czytający pomiary bezpośrednio z listy narzędzia
+ * (std::vector<Measure>) – bez kopii w komórkach QTableWidgetItem.
+ * Wiersze są udostępniane widokowi porcjami (canFetchMore/fetchMore),
+ * więc otwarcie raportu nie zależy od liczby pomiarów; eksport przechodzi
+ * po wszystkich pomiarach niezależnie od tego, ile wierszy pobrał widok.
+ *
+ * Model prowadzi też sumy zaznaczonych wierszy (MeasureTotals), zmieniane
+ * przyrostowo przy zaznaczaniu, edycji i usuwaniu.
+ */
+class MeasureReportModel : public QAbstractTableModel {
+    Q_OBJECT
+public:
+    enum Column {
+        ColCheck = 0,
+        ColId,
+        ColName,
+        ColType,
+        ColLength,
+        ColSum,
+        ColBufferStart,
+        ColBufferEnd,
+        ColColor,
+        ColDate,
+        ColEdit,
+        ColDelete,
+        ColumnCount
+    };
+    /// Liczba wierszy pobieranych przez widok naraz.
+    static constexpr int kFetchChunk = 256;
+
+    MeasureReportModel(std::vector<Measure>* measures, ProjectSettings* settings,
+                       MeasureTotals* projectTotals, QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    bool setData(const QModelIndex& index, const QVariant& value, int role = Qt::EditRole) override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex& index) const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+
+    /// Liczba wszystkich pomiarów (także jeszcze niepobranych przez widok).
+    int measureCount() const;
+    const Measure& measureAt(int row) const;
+    Measure& measureAt(int row);
+    bool isChecked(int row) const;
+    /// Tekst komórki tak, jak w tabeli (również dla wierszy niepobranych).
+    QString cellText(int row, int column) const;
+    QString columnTitle(int column) const;
+    /// Liczba miejsc po przecinku z ustawień projektu.
+    int decimals() const;
+    /// Nazwa typu pomiaru jak w kolumnie „Typ”.
+    static QString typeName(MeasureType type);
+
+    /// Po zmianie pomiaru w wierszu row; before – stan sprzed edycji.
+    void measureEdited(int row, const Measure& before);
+    void removeMeasure(int row);
+
+    const MeasureTotals& checkedTotals() const { return m_checkedTotals; }
+
+signals:
+    /// Zmieniły się sumy zaznaczonych wierszy.
+    void totalsChanged();
+
+private:
+    QString formatCm(double value) const;
+
+    std::vector<Measure>* m_measures = nullptr;
+    ProjectSettings* m_settings = nullptr;
+    MeasureTotals* m_projectTotals = nullptr;
+    std::vector<char> m_checked;  ///< zaznaczenie według wiersza (wszystkich pomiarów)
+    MeasureTotals m_checkedTotals;
+    int m_fetchedRows = 0;
+};
+
+/**
+ * Przyciski „Edytuj” / „Usuń” rysowane w komórce przez delegata zamiast
+ * osobnych QPushButton w każdym wierszu.  Kliknięcie zgłasza clicked.
+ */
+class ReportButtonDelegate : public QStyledItemDelegate {
+    Q_OBJECT
+public:
+    ReportButtonDelegate(const QString& text, QObject* parent = nullptr);
+
+    void paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+    QSize sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+    bool editorEvent(QEvent* event, QAbstractItemModel* model, const QStyleOptionViewItem& option,
+                     const QModelIndex& index) override;
+
+signals:
+    void clicked(const QModelIndex& index);
+
+private:
+    QString m_text;
+    QPersistentModelIndex m_pressed;
+};
@@ -3,8 +3,10 @@
 #include <QColor>
 #include <QDateTime>
 #include <QPointF>
+#include <QRectF>
 #include <QString>
-#include <vector>
+
+#include "MeasureGeometry.h"
 
 enum class MeasureType { Linear, Polyline, Advanced };
 
@@ -26,8 +28,18 @@ struct Measure {
     // Końcowy zapas ("zapas końcowy"), ustawiany w drugim etapie
     // pomiaru zaawansowanego. Dla pozostałych pomiarów jest równy zero.
     double bufferFinalMeters   = 0.0;
-    std::vector<QPointF> pts;
+    // Fragment wspólnego bufora punktów płótna (MeasureGeometry
+    // w MeasurementsTool) z wierzchołkami pomiaru.  Sam pomiar przechowuje
+    // tylko metadane, więc jego kopie (raport, eksport) nie kopiują geometrii.
+    PointSpan points;
+    // Prostokąt ograniczający punkty pomiaru w układzie świata.  Służy do
+    // pomijania pomiarów spoza widoku; po każdej zmianie punktów należy
+    // wywołać updateBounds().
+    QRectF bounds;
     QDateTime createdAt;
+    // Długość łamanej w pikselach podkładu.  Zmiana skali (pikseli na
+    // metr) przelicza lengthMeters bez ponownego przechodzenia po punktach.
+    double lengthPx = 0.0;
     double lengthMeters = 0.0;
     double totalWithBufferMeters = 0.0;
     bool visible = true;
@@ -42,4 +54,52 @@ struct Measure {
     // kategorii projektu.  Domyślnie wszystkie pomiary należą do warstwy
     // "Pomiary", ale w przyszłości można ją zmieniać zgodnie z kategorią.
     QString layer = QStringLiteral("Pomiary");
+
+    void updateBounds(PointsView pts) {
+        bounds = pts.boundingRect();
+    }
+    // Długość z zapasami: długość, globalny zapas, zapas początkowy i końcowy.
+    void updateTotal() {
+        totalWithBufferMeters = lengthMeters + bufferGlobalMeters + bufferDefaultMeters + bufferFinalMeters;
+    }
+};
+
+/**
+ * Sumy bieżące zbioru pomiarów w układzie raportu: długość zmierzona,
+ * zapasy (początkowy i końcowy) i suma łączna.  Aktualizowane przyrostowo
+ * przy dodaniu, edycji i usunięciu pomiaru zamiast sumowania całej listy.
+ */
+struct MeasureTotals {
+    int count = 0;
+    double lengthMeters = 0.0;
+    double buffersMeters = 0.0;
+
+    double totalMeters() const { return lengthMeters + buffersMeters; }
+
+    void add(const Measure& m) {
+        ++count;
+        lengthMeters += m.lengthMeters;
+        buffersMeters += m.bufferDefaultMeters + m.bufferFinalMeters;
+    }
+    void remove(const Measure& m) {
+        if (--count <= 0) {
+            // Bez resztek zaokrągleń po odjęciu ostatniego pomiaru
+            *this = MeasureTotals();
+            return;
+        }
+        lengthMeters -= m.lengthMeters;
+        buffersMeters -= m.bufferDefaultMeters + m.bufferFinalMeters;
+    }
+    /// Dołącza sumy innego zbioru (np. wynik częściowy innej kondygnacji).
+    void merge(const MeasureTotals& other) {
+        count += other.count;
+        lengthMeters += other.lengthMeters;
+        buffersMeters += other.buffersMeters;
+    }
+    /// Edycja pomiaru: before – stan sprzed zmiany.
+    void replace(const Measure& before, const Measure& after) {
+        lengthMeters += after.lengthMeters - before.lengthMeters;
+        buffersMeters += (after.bufferDefaultMeters + after.bufferFinalMeters)
+            - (before.bufferDefaultMeters + before.bufferFinalMeters);
+    }
 };
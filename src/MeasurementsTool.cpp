@@ -1,9 +1,13 @@
 #include "MeasurementsTool.h"
 
 #include "Dialogs.h"
+#include "PointKernels.h"
 #include "Settings.h"
+#include "Trace.h"
 
+#include <QHash>
 #include <QKeyEvent>
+#include <QLineF>
 #include <QMouseEvent>
 #include <QPainter>
 #include <QFontMetrics>
@@ -21,20 +25,119 @@ double safePixelsPerMeter(double pixelsPerMeter, double zoom) {
     return value;
 }
 
-void drawMeasureDots(QPainter& p, const QColor& color, int lineWidthPx, const std::vector<QPointF>& pts) {
-    if (pts.empty()) {
-        return;
+// Poziom szczegółowości: odcinki krótsze niż ułamek piksela są
+// upraszczane, a kropki i etykiety, które byłyby nieczytelne, pomijane.
+constexpr double kSimplifyTolerancePx = 0.5;
+constexpr double kMinDotScreenRadius = 1.5;
+constexpr double kMinLabelScreenHeight = 6.0;
+
+double measureDotRadius(int lineWidthPx) {
+    return std::max(3.0, 1.5 * static_cast<double>(lineWidthPx));
+}
+
+// Upraszczanie łamanej algorytmem Douglasa–Peuckera (bez rekurencji).
+std::vector<QPointF> simplifyPolyline(PointsView pts, double tolerance) {
+    if (pts.size() < 3) {
+        return std::vector<QPointF>(pts.begin(), pts.end());
+    }
+    std::vector<char> keep(pts.size(), 0);
+    keep.front() = keep.back() = 1;
+    std::vector<std::pair<size_t, size_t>> stack;
+    stack.emplace_back(0, pts.size() - 1);
+    const double tol2 = tolerance * tolerance;
+    while (!stack.empty()) {
+        const auto [first, last] = stack.back();
+        stack.pop_back();
+        const QPointF a = pts[first];
+        const QPointF ab = pts[last] - a;
+        const double len2 = ab.x() * ab.x() + ab.y() * ab.y();
+        double maxDist2 = 0.0;
+        size_t maxIdx = first;
+        for (size_t i = first + 1; i < last; ++i) {
+            const QPointF ap = pts[i] - a;
+            double d2;
+            if (len2 == 0.0) {
+                d2 = ap.x() * ap.x() + ap.y() * ap.y();
+            } else {
+                const double cross = ab.x() * ap.y() - ab.y() * ap.x();
+                d2 = cross * cross / len2;
+            }
+            if (d2 > maxDist2) {
+                maxDist2 = d2;
+                maxIdx = i;
+            }
+        }
+        if (maxDist2 > tol2) {
+            keep[maxIdx] = 1;
+            stack.emplace_back(first, maxIdx);
+            stack.emplace_back(maxIdx, last);
+        }
     }
-    const double radius = std::max(3.0, 1.5 * static_cast<double>(lineWidthPx));
-    QPen pen(color);
-    pen.setWidthF(1.0);
-    pen.setCosmetic(true);
-    p.setPen(pen);
-    p.setBrush(color);
-    for (const auto& pt : pts) {
-        p.drawEllipse(pt, radius, radius);
+    std::vector<QPointF> out;
+    for (size_t i = 0; i < pts.size(); ++i) {
+        if (keep[i]) {
+            out.push_back(pts[i]);
+        }
+    }
+    return out;
+}
+
+// Zachłanne rozmieszczanie etykiet: etykieta nachodząca na już
+// umieszczoną jest pomijana.  Zajęte prostokąty trzymamy w siatce.
+class LabelDeclutter {
+public:
+    explicit LabelDeclutter(double cellSize) : m_cell(std::max(cellSize, 1e-9)) {}
+
+    bool tryPlace(const QRectF& box) {
+        const int c0 = int(std::floor(box.left() / m_cell));
+        const int c1 = int(std::floor(box.right() / m_cell));
+        const int r0 = int(std::floor(box.top() / m_cell));
+        const int r1 = int(std::floor(box.bottom() / m_cell));
+        for (int r = r0; r <= r1; ++r) {
+            for (int c = c0; c <= c1; ++c) {
+                auto it = m_cells.constFind(key(c, r));
+                if (it == m_cells.constEnd()) continue;
+                for (const QRectF& placed : it.value()) {
+                    if (placed.intersects(box)) {
+                        return false;
+                    }
+                }
+            }
+        }
+        for (int r = r0; r <= r1; ++r) {
+            for (int c = c0; c <= c1; ++c) {
+                m_cells[key(c, r)].push_back(box);
+            }
+        }
+        return true;
+    }
+
+private:
+    static quint64 key(int c, int r) { return (quint64(quint32(c)) << 32) | quint64(quint32(r)); }
+    double m_cell;
+    QHash<quint64, std::vector<QRectF>> m_cells;
+};
+
+// Odcinki i wierzchołki pomiarów o tym samym piórze, zbierane do
+// jednego wywołania drawLines / drawPixmapFragments.
+struct PenBatch {
+    QColor color;
+    int lineWidthPx = 1;
+    std::vector<QLineF> lines;
+    std::vector<QPointF> dots;
+};
+
+void appendSegments(std::vector<QLineF>& lines, PointsView pts) {
+    for (size_t i = 1; i < pts.size(); ++i) {
+        lines.emplace_back(pts[i - 1], pts[i]);
     }
 }
+// Ramka etykiety z długością, umieszczona obok punktu at.
+QRectF labelBox(const QFontMetrics& fm, const QPointF& at, const QString& text) {
+    const int textW = fm.horizontalAdvance(text) + 10;
+    const int textH = fm.height() + 4;
+    return QRectF(at + QPointF(8, -textH - 4), QSizeF(textW, textH));
+}
 } // namespace
 
 MeasurementsTool::MeasurementsTool(ToolHost* host, std::function<void()> onFinished)
@@ -59,46 +162,149 @@ void MeasurementsTool::deactivate() {
 }
 
 void MeasurementsTool::draw(QPainter& p) {
+    m_drawStats = DrawStats();
     if (!m_visible || !m_host) return;
     if (!m_host->isLayerVisible(layerName())) return;
     p.setRenderHint(QPainter::Antialiasing, true);
+    m_dotSprites.resetStats();
+    // Rysujemy tylko pomiary, których prostokąt ograniczający (powiększony
+    // o kropki i etykietę) przecina widok lub odświeżany fragment warstwy.
+    const QRectF view = m_host->visibleWorldRect();
+    QRectF visible = view;
+    if (p.hasClipping()) {
+        visible = visible.intersected(p.clipBoundingRect());
+    }
+    const QFontMetrics labelFm(p.font());
+    const QRectF labelExtent = labelBox(labelFm, QPointF(0, 0), fmtLenInProjectUnit(99999.0));
+    const auto isOnScreen = [&](const Measure& m) {
+        const double r = measureDotRadius(m.lineWidthPx);
+        return m.bounds.adjusted(-r, labelExtent.top() - r, labelExtent.right() + r, r)
+            .intersects(visible);
+    };
+    // Kropki i etykiety są rysowane w jednostkach świata, więc przy małym
+    // powiększeniu stają się nieczytelne – wtedy je pomijamy.
+    const double zoom = m_host->zoom() > 0.0 ? m_host->zoom() : 1.0;
+    const bool drawLabels = labelExtent.height() * zoom >= kMinLabelScreenHeight;
+    if (drawLabels) {
+        updateLabelLayout(p.font());
+    }
+    // Najpierw zbieramy geometrię według pióra, potem rysujemy ją
+    // kilkoma wywołaniami; etykiety trafiają na wierzch.
+    std::vector<PenBatch> batches;
+    QHash<quint64, int> batchByPen;
+    std::vector<std::pair<QRectF, QString>> labels;
     for (size_t idx = 0; idx < m_measures.size(); ++idx) {
         const auto &m = m_measures[idx];
         if (!m.visible || !m_host->isLayerVisible(m.layer)) continue;
-        if (m.pts.size() < 2) continue;
-        QPen pen(m.color);
-        pen.setWidth(m.lineWidthPx);
-        pen.setCosmetic(true);
-        p.setPen(pen);
-        for (size_t i = 1; i < m.pts.size(); ++i) {
-            p.drawLine(m.pts[i - 1], m.pts[i]);
+        if (m.points.count < 2) continue;
+        const PointsView pts = m_geometry.points(m.points);
+        if (!isOnScreen(m)) {
+            ++m_drawStats.culled;
+            continue;
         }
-        drawMeasureDots(p, m.color, m.lineWidthPx, m.pts);
-        QPointF labelPos = m.pts.back();
+        const quint64 penKey = (quint64(m.color.rgba()) << 32) | quint64(quint32(m.lineWidthPx));
+        auto found = batchByPen.constFind(penKey);
+        int batchIdx;
+        if (found == batchByPen.constEnd()) {
+            batchIdx = int(batches.size());
+            batchByPen.insert(penKey, batchIdx);
+            batches.push_back(PenBatch{m.color, m.lineWidthPx, {}, {}});
+        } else {
+            batchIdx = found.value();
+        }
+        PenBatch& batch = batches[size_t(batchIdx)];
+        ++m_drawStats.drawn;
+        appendSegments(batch.lines, simplifiedPoints(m, zoom));
+        if (measureDotRadius(m.lineWidthPx) * zoom >= kMinDotScreenRadius) {
+            batch.dots.insert(batch.dots.end(), pts.begin(), pts.end());
+        }
+        if (!drawLabels || !m_labelLayout.shown[idx]) continue;
         QString text = fmtLenInProjectUnit(m.totalWithBufferMeters);
-        QFontMetrics fm(p.font());
-        int textW = fm.horizontalAdvance(text) + 10;
-        int textH = fm.height() + 4;
-        QRectF box(labelPos + QPointF(8, -textH - 4), QSizeF(textW, textH));
-        p.setPen(QPen(Qt::black));
+        labels.emplace_back(labelBox(labelFm, pts.back(), text), std::move(text));
+    }
+    for (const PenBatch& batch : batches) {
+        QPen pen(batch.color);
+        pen.setWidth(batch.lineWidthPx);
+        pen.setCosmetic(true);
+        p.setPen(pen);
+        p.drawLines(batch.lines.data(), int(batch.lines.size()));
+    }
+    for (const PenBatch& batch : batches) {
+        drawMeasureDots(p, batch.color, batch.lineWidthPx, batch.dots);
+    }
+    m_drawStats.spriteHits = m_dotSprites.hits();
+    m_drawStats.spriteMisses = m_dotSprites.misses();
+    p.setPen(QPen(Qt::black));
+    for (const auto& [box, text] : labels) {
         p.fillRect(box, QColor(255,255,255,200));
         p.drawText(box, Qt::AlignLeft | Qt::AlignVCenter, text);
     }
     if (m_selectedMeasureIndex >= 0 && m_selectedMeasureIndex < (int)m_measures.size()) {
         const auto &mSel = m_measures[m_selectedMeasureIndex];
-        if (mSel.visible && m_host->isLayerVisible(mSel.layer) && mSel.pts.size() >= 2) {
+        if (mSel.visible && m_host->isLayerVisible(mSel.layer) && mSel.points.count >= 2
+            && isOnScreen(mSel)) {
+            const PointsView pts = simplifiedPoints(mSel, zoom);
             QPen pen(Qt::black);
             pen.setWidth(mSel.lineWidthPx + 2);
             pen.setStyle(Qt::DashLine);
             pen.setCosmetic(true);
             p.setPen(pen);
-            for (size_t i = 1; i < mSel.pts.size(); ++i) {
-                p.drawLine(mSel.pts[i - 1], mSel.pts[i]);
-            }
+            p.setBrush(Qt::NoBrush);
+            p.drawPolyline(pts.data(), int(pts.size()));
         }
     }
 }
 
+void MeasurementsTool::invalidateLabelLayout() {
+    m_labelLayout.valid = false;
+}
+
+void MeasurementsTool::updateLabelLayout(const QFont& font) {
+    if (m_labelLayout.valid && m_labelLayout.font == font && m_labelLayout.shown.size() == m_measures.size()) {
+        return;
+    }
+    // Etykiety mają wymiary w jednostkach świata, więc wynik nie zależy
+    // od widoku ani powiększenia – liczymy go dla wszystkich pomiarów.
+    const QFontMetrics fm(font);
+    const QRectF labelExtent = labelBox(fm, QPointF(0, 0), fmtLenInProjectUnit(99999.0));
+    LabelDeclutter declutter(labelExtent.height() * 4.0);
+    m_labelLayout.shown.assign(m_measures.size(), 0);
+    for (size_t idx = 0; idx < m_measures.size(); ++idx) {
+        const Measure& m = m_measures[idx];
+        if (!m.visible || !m_host->isLayerVisible(m.layer) || m.points.count < 2) continue;
+        const QRectF box = labelBox(fm, m_geometry.points(m.points).back(),
+                                    fmtLenInProjectUnit(m.totalWithBufferMeters));
+        m_labelLayout.shown[idx] = declutter.tryPlace(box) ? 1 : 0;
+    }
+    m_labelLayout.font = font;
+    m_labelLayout.valid = true;
+}
+
+void MeasurementsTool::drawMeasureDots(QPainter& p, const QColor& color, int lineWidthPx,
+                                       PointsView pts) {
+    m_dotSprites.draw(p, color, measureDotRadius(lineWidthPx), pts.data(), int(pts.size()));
+}
+
+PointsView MeasurementsTool::simplifiedPoints(const Measure& m, double zoom) {
+    const PointsView pts = m_geometry.points(m.points);
+    if (pts.size() < 3) {
+        return pts;
+    }
+    // Tolerancja zaokrąglona w dół do potęgi dwójki – kopia uproszczona
+    // jest liczona ponownie dopiero po wyraźnej zmianie powiększenia.
+    const int bucket = int(std::floor(std::log2(kSimplifyTolerancePx / zoom)));
+    auto& entry = m_simplified[m.id];
+    if (entry.valid && entry.bucket == bucket) {
+        ++m_drawStats.lodHits;
+    } else {
+        ++m_drawStats.lodMisses;
+        entry.pts = simplifyPolyline(pts, std::ldexp(1.0, bucket));
+        entry.bucket = bucket;
+        entry.valid = true;
+    }
+    return entry.pts;
+}
+
 void MeasurementsTool::drawOverlay(QPainter& p, bool hasMouseWorld, const QPointF& mouseWorld) {
     if (!isActive()) return;
     if (!m_visible || !m_host) return;
@@ -108,25 +314,20 @@ void MeasurementsTool::drawOverlay(QPainter& p, bool hasMouseWorld, const QPoint
     pen.setWidth(m_currentLineWidth);
     pen.setCosmetic(true);
     p.setPen(pen);
-    for (size_t i = 1; i < m_currentPts.size(); ++i) {
-        p.drawLine(m_currentPts[i - 1], m_currentPts[i]);
-    }
+    p.drawPolyline(m_currentPts.data(), int(m_currentPts.size()));
     drawMeasureDots(p, m_currentColor, m_currentLineWidth, m_currentPts);
-    double L = polyLengthCm(m_currentPts);
+    const double L = hasMouseWorld ? overlayLength(mouseWorld) : polyLengthCm(m_currentPts);
     if (hasMouseWorld) {
+        QPen rubberPen(m_currentColor);
+        rubberPen.setWidthF(1.0);
+        rubberPen.setCosmetic(true);
+        p.setPen(rubberPen);
         p.drawLine(m_currentPts.back(), mouseWorld);
-        double dx = mouseWorld.x() - m_currentPts.back().x();
-        double dy = mouseWorld.y() - m_currentPts.back().y();
-        L += std::hypot(dx, dy) / safePixelsPerMeter(m_host->pixelsPerMeter(), 1.0);
-        std::vector<QPointF> previewPts = {mouseWorld};
-        drawMeasureDots(p, m_currentColor, m_currentLineWidth, previewPts);
+        drawMeasureDots(p, m_currentColor, m_currentLineWidth, {mouseWorld});
     }
     QPointF at = hasMouseWorld ? mouseWorld : m_currentPts.back();
     QString text = fmtLenInProjectUnit(L);
-    QFontMetrics fm(p.font());
-    int textW = fm.horizontalAdvance(text) + 10;
-    int textH = fm.height() + 4;
-    QRectF box(at + QPointF(8, -textH - 4), QSizeF(textW, textH));
+    QRectF box = labelBox(QFontMetrics(p.font()), at, text);
     p.setPen(QPen(Qt::black));
     p.fillRect(box, QColor(255,255,255,200));
     p.drawText(box, Qt::AlignLeft | Qt::AlignVCenter, text);
@@ -157,9 +358,20 @@ bool MeasurementsTool::mousePress(QMouseEvent* event) {
 
 bool MeasurementsTool::mouseMove(QMouseEvent* event, const QPointF& worldPos) {
     Q_UNUSED(event);
-    Q_UNUSED(worldPos);
     if (!isActive() || !m_host) return false;
-    m_host->requestUpdate();
+    if (m_currentPts.empty()) {
+        m_hasLastMouseWorld = false;
+        return false;
+    }
+    // Odświeżamy tylko odcinek od ostatniego punktu do kursora wraz
+    // z etykietą – w poprzednim i nowym położeniu.
+    QRectF dirty = overlayRect(worldPos);
+    if (m_hasLastMouseWorld) {
+        dirty = dirty.united(overlayRect(m_lastMouseWorld));
+    }
+    m_lastMouseWorld = worldPos;
+    m_hasLastMouseWorld = true;
+    m_host->requestUpdateRect(dirty);
     return false;
 }
 
@@ -202,7 +414,7 @@ bool MeasurementsTool::keyPress(QKeyEvent* event, QWidget* parentForDialogs) {
 void MeasurementsTool::setVisible(bool visible) {
     m_visible = visible;
     if (m_host) {
-        m_host->requestUpdate();
+        m_host->invalidateLayer(CanvasLayer::Measures);
     }
 }
 
@@ -217,6 +429,9 @@ void MeasurementsTool::startLinear() {
         m_currentColor = m_host->settings()->defaultMeasureColor;
         m_currentLineWidth = m_host->settings()->lineWidthPx;
     }
+    if (m_host) {
+        m_host->invalidateLayer(CanvasLayer::Measures);
+    }
 }
 
 void MeasurementsTool::startPolyline() {
@@ -228,6 +443,9 @@ void MeasurementsTool::startPolyline() {
         m_currentColor = m_host->settings()->defaultMeasureColor;
         m_currentLineWidth = m_host->settings()->lineWidthPx;
     }
+    if (m_host) {
+        m_host->invalidateLayer(CanvasLayer::Measures);
+    }
 }
 
 void MeasurementsTool::startAdvanced(QWidget* parent) {
@@ -248,6 +466,7 @@ void MeasurementsTool::startAdvanced(QWidget* parent) {
     m_mode = Mode::Advanced;
     m_currentPts.clear();
     m_selectedMeasureIndex = -1;
+    m_host->invalidateLayer(CanvasLayer::Measures);
 }
 
 void MeasurementsTool::cancelCurrentMeasure() {
@@ -256,7 +475,7 @@ void MeasurementsTool::cancelCurrentMeasure() {
     m_mode = Mode::None;
     m_selectedMeasureIndex = -1;
     if (m_host) {
-        m_host->requestUpdate();
+        m_host->invalidateLayer(CanvasLayer::Measures);
     }
 }
 
@@ -286,9 +505,13 @@ void MeasurementsTool::confirmCurrentMeasure(QWidget* parentForAdvanced) {
 
 void MeasurementsTool::openReportDialog(QWidget* parent) {
     if (!m_host) return;
-    ReportDialog dlg(parent, m_host->settings(), &m_measures);
+    ReportDialog dlg(parent, m_host->settings(), &m_measures, &m_totals);
     dlg.exec();
-    m_host->requestUpdate();
+    // Raport może usuwać pomiary
+    m_geometry.compact(m_measures);
+    rebuildSegmentIndex();
+    m_simplified.clear();
+    m_host->invalidateLayer(CanvasLayer::Measures);
 }
 
 QColor MeasurementsTool::currentColor() const { return m_currentColor; }
@@ -318,32 +541,49 @@ void MeasurementsTool::setCurrentLineWidth(int w) {
 bool MeasurementsTool::hasAnyMeasure() const { return !m_measures.empty(); }
 
 void MeasurementsTool::updateAllMeasureColors(const QColor& color) {
-    for (auto &m : m_measures) {
-        m.color = color;
-    }
+    assignMeasureColors(color);
     if (m_host) {
-        m_host->requestUpdate();
+        m_host->invalidateLayer(CanvasLayer::Measures);
     }
 }
 
 void MeasurementsTool::updateAllMeasureLineWidths(int width) {
-    int bounded = qBound(1, width, 8);
-    for (auto &m : m_measures) {
-        m.lineWidthPx = bounded;
-    }
+    assignMeasureLineWidths(width);
     if (m_host) {
-        m_host->requestUpdate();
+        m_host->invalidateLayer(CanvasLayer::Measures);
     }
 }
 
 void MeasurementsTool::recalculateLengths() {
+    TRACE_SCOPE("MeasurementsTool::recalculateLengths");
+    recomputeLengths(m_host ? m_host->pixelsPerMeter() : 1.0);
+    if (m_host) {
+        m_host->invalidateLayer(CanvasLayer::Measures);
+    }
+}
+
+void MeasurementsTool::assignMeasureColors(const QColor& color) {
     for (auto &m : m_measures) {
-        m.lengthMeters = polyLengthCm(m.pts);
-        m.totalWithBufferMeters = m.lengthMeters + m.bufferGlobalMeters
-            + m.bufferDefaultMeters + m.bufferFinalMeters;
+        m.color = color;
     }
-    if (m_host) {
-        m_host->requestUpdate();
+}
+
+void MeasurementsTool::assignMeasureLineWidths(int width) {
+    const int bounded = qBound(1, width, 8);
+    for (auto &m : m_measures) {
+        m.lineWidthPx = bounded;
+    }
+}
+
+void MeasurementsTool::recomputeLengths(double pixelsPerMeter) {
+    // Długości w pikselach są zapamiętane w pomiarach – nowa skala to
+    // jedno dzielenie na pomiar, bez przechodzenia po punktach.
+    const double ppm = safePixelsPerMeter(pixelsPerMeter, 1.0);
+    m_totals = MeasureTotals();
+    for (auto &m : m_measures) {
+        m.lengthMeters = m.lengthPx / ppm;
+        m.updateTotal();
+        m_totals.add(m);
     }
 }
 
@@ -351,24 +591,18 @@ void MeasurementsTool::scaleAllPoints(double factor) {
     if (factor == 1.0) {
         return;
     }
+    m_geometry.scale(factor);
     for (auto &m : m_measures) {
-        for (auto &pt : m.pts) {
-            pt.setX(pt.x() * factor);
-            pt.setY(pt.y() * factor);
-        }
-    }
-    for (auto &pt : m_currentPts) {
-        pt.setX(pt.x() * factor);
-        pt.setY(pt.y() * factor);
+        m.bounds = QRectF(m.bounds.topLeft() * factor, m.bounds.bottomRight() * factor).normalized();
+        m.lengthPx *= std::abs(factor);
     }
-    for (auto &pt : m_redoPts) {
-        pt.setX(pt.x() * factor);
-        pt.setY(pt.y() * factor);
-    }
-    for (auto &pt : m_advTemplate.pts) {
-        pt.setX(pt.x() * factor);
-        pt.setY(pt.y() * factor);
+    // Siatka skaluje się razem z punktami – bez ponownego wpisywania odcinków
+    if (!m_segmentIndex.scale(factor)) {
+        rebuildSegmentIndex();
     }
+    m_simplified.clear();
+    PointKernels::scale(m_currentPts.data(), m_currentPts.size(), factor);
+    PointKernels::scale(m_redoPts.data(), m_redoPts.size(), factor);
     recalculateLengths();
 }
 
@@ -394,7 +628,7 @@ void MeasurementsTool::setSelectedMeasureColor(const QColor& c) {
     if (m_selectedMeasureIndex >= 0 && m_selectedMeasureIndex < (int)m_measures.size()) {
         m_measures[m_selectedMeasureIndex].color = c;
         if (m_host) {
-            m_host->requestUpdate();
+            m_host->invalidateLayer(CanvasLayer::Measures);
         }
     }
 }
@@ -404,17 +638,25 @@ void MeasurementsTool::setSelectedMeasureLineWidth(int w) {
         int bounded = qBound(1, w, 8);
         m_measures[m_selectedMeasureIndex].lineWidthPx = bounded;
         if (m_host) {
-            m_host->requestUpdate();
+            m_host->invalidateLayer(CanvasLayer::Measures);
         }
     }
 }
 
 void MeasurementsTool::deleteSelectedMeasure() {
     if (m_selectedMeasureIndex >= 0 && m_selectedMeasureIndex < (int)m_measures.size()) {
+        const Measure& removed = m_measures[m_selectedMeasureIndex];
+        m_segmentIndex.remove(removed.id);
+        m_totals.remove(removed);
+        m_simplified.erase(removed.id);
+        m_geometry.release(removed.points);
         m_measures.erase(m_measures.begin() + m_selectedMeasureIndex);
+        if (m_geometry.wantsCompaction()) {
+            m_geometry.compact(m_measures);
+        }
         m_selectedMeasureIndex = -1;
         if (m_host) {
-            m_host->requestUpdate();
+            m_host->invalidateLayer(CanvasLayer::Measures);
         }
     }
 }
@@ -422,37 +664,44 @@ void MeasurementsTool::deleteSelectedMeasure() {
 void MeasurementsTool::clearSelection() {
     m_selectedMeasureIndex = -1;
     if (m_host) {
-        m_host->requestUpdate();
+        m_host->invalidateLayer(CanvasLayer::Measures);
     }
 }
 
 bool MeasurementsTool::selectMeasureAt(const QPointF& worldPos, double thresholdWorld) {
+    TRACE_SCOPE("MeasurementsTool::selectMeasureAt");
     int idx = -1;
     double bestDist = thresholdWorld;
-    for (size_t i = 0; i < m_measures.size(); ++i) {
+    // Sprawdzamy tylko odcinki z komórek siatki wokół punktu.  Kandydaci
+    // są uporządkowani jak pomiary, więc przy równych odległościach
+    // wygrywa – jak dotąd – ostatni pomiar.
+    const QRectF area(worldPos.x() - thresholdWorld, worldPos.y() - thresholdWorld,
+                      2.0 * thresholdWorld, 2.0 * thresholdWorld);
+    for (const auto& candidate : m_segmentIndex.candidates(area)) {
+        const int i = indexOfMeasureId(candidate.measureId);
+        if (i < 0) continue;
         const auto &m = m_measures[i];
-        if (!m.visible || m.pts.size() < 2) continue;
-        for (size_t j = 1; j < m.pts.size(); ++j) {
-            QPointF a = m.pts[j - 1];
-            QPointF b = m.pts[j];
-            QPointF ab = b - a;
-            double ab2 = ab.x()*ab.x() + ab.y()*ab.y();
-            if (ab2 == 0.0) continue;
-            double t = ((worldPos - a).x()*ab.x() + (worldPos - a).y()*ab.y()) / ab2;
-            t = std::max(0.0, std::min(1.0, t));
-            QPointF proj = a + t * ab;
-            double dx = proj.x() - worldPos.x();
-            double dy = proj.y() - worldPos.y();
-            double dist = std::sqrt(dx*dx + dy*dy);
-            if (dist <= bestDist) {
-                bestDist = dist;
-                idx = (int)i;
-            }
+        if (!m.visible || candidate.segment + 1 >= (int)m.points.count) continue;
+        const PointsView pts = m_geometry.points(m.points);
+        QPointF a = pts[candidate.segment];
+        QPointF b = pts[candidate.segment + 1];
+        QPointF ab = b - a;
+        double ab2 = ab.x()*ab.x() + ab.y()*ab.y();
+        if (ab2 == 0.0) continue;
+        double t = ((worldPos - a).x()*ab.x() + (worldPos - a).y()*ab.y()) / ab2;
+        t = std::max(0.0, std::min(1.0, t));
+        QPointF proj = a + t * ab;
+        double dx = proj.x() - worldPos.x();
+        double dy = proj.y() - worldPos.y();
+        double dist = std::sqrt(dx*dx + dy*dy);
+        if (dist <= bestDist) {
+            bestDist = dist;
+            idx = i;
         }
     }
     m_selectedMeasureIndex = idx;
     if (m_host) {
-        m_host->requestUpdate();
+        m_host->invalidateLayer(CanvasLayer::Measures);
     }
     return idx >= 0;
 }
@@ -461,17 +710,76 @@ int MeasurementsTool::selectedMeasureIndex() const { return m_selectedMeasureInd
 
 const std::vector<Measure>& MeasurementsTool::measures() const { return m_measures; }
 
-double MeasurementsTool::polyLengthCm(const std::vector<QPointF>& pts) const {
-    if (pts.size() < 2) return 0.0;
-    double px = 0.0;
-    for (size_t i = 1; i < pts.size(); ++i) {
-        const double dx = pts[i].x() - pts[i-1].x();
-        const double dy = pts[i].y() - pts[i-1].y();
-        px += std::hypot(dx, dy);
+const MeasureTotals& MeasurementsTool::totals() const { return m_totals; }
+
+PointsView MeasurementsTool::points(const Measure& m) const { return m_geometry.points(m.points); }
+
+double MeasurementsTool::overlayLength(const QPointF& mouseWorld) const {
+    double L = polyLengthCm(m_currentPts);
+    if (!m_currentPts.empty()) {
+        const double dx = mouseWorld.x() - m_currentPts.back().x();
+        const double dy = mouseWorld.y() - m_currentPts.back().y();
+        L += std::hypot(dx, dy) / safePixelsPerMeter(m_host ? m_host->pixelsPerMeter() : 1.0, 1.0);
+    }
+    return L;
+}
+
+QRectF MeasurementsTool::overlayRect(const QPointF& mouseWorld) const {
+    if (m_currentPts.empty()) {
+        return QRectF();
     }
+    const QPointF& last = m_currentPts.back();
+    // Kropki mają promień w jednostkach świata, a pióro kosmetyczne
+    // szerokość w pikselach ekranu.
+    const double zoom = m_host && m_host->zoom() > 0.0 ? m_host->zoom() : 1.0;
+    const double r = measureDotRadius(m_currentLineWidth) + m_currentLineWidth / zoom;
+    QRectF rect = QRectF(last, mouseWorld).normalized().adjusted(-r, -r, r, r);
+    // Etykieta rysowana jest czcionką płótna (drawOverlay używa p.font())
+    const QFontMetrics fm(m_host ? m_host->overlayFont() : QFont());
+    const QString text = fmtLenInProjectUnit(overlayLength(mouseWorld));
+    return rect.united(labelBox(fm, mouseWorld, text));
+}
+
+double MeasurementsTool::polyLengthCm(PointsView pts) const {
+    if (pts.size() < 2) return 0.0;
+    const double px = PointKernels::polylineLength(pts.data(), pts.size());
     return px / safePixelsPerMeter(m_host ? m_host->pixelsPerMeter() : 1.0, 1.0);
 }
 
+int MeasurementsTool::addMeasure(Measure mm, PointsView pts) {
+    mm.id = m_nextId++;
+    if (mm.name.isEmpty()) mm.name = QString("Pomiar %1").arg(mm.id);
+    mm.points = m_geometry.append(pts);
+    const PointsView stored = m_geometry.points(mm.points);
+    mm.lengthPx = PointKernels::polylineLength(stored.data(), stored.size());
+    mm.lengthMeters = mm.lengthPx / safePixelsPerMeter(m_host ? m_host->pixelsPerMeter() : 1.0, 1.0);
+    mm.updateTotal();
+    m_totals.add(mm);
+    mm.updateBounds(stored);
+    m_segmentIndex.insert(mm.id, stored);
+    m_measures.push_back(std::move(mm));
+    if (m_host) {
+        m_host->invalidateLayer(CanvasLayer::Measures);
+    }
+    return m_measures.back().id;
+}
+
+void MeasurementsTool::rebuildSegmentIndex() {
+    m_segmentIndex.clear();
+    for (const auto& m : m_measures) {
+        m_segmentIndex.insert(m.id, m_geometry.points(m.points));
+    }
+}
+
+int MeasurementsTool::indexOfMeasureId(int id) const {
+    auto it = std::lower_bound(m_measures.begin(), m_measures.end(), id,
+                               [](const Measure& m, int value) { return m.id < value; });
+    if (it == m_measures.end() || it->id != id) {
+        return -1;
+    }
+    return int(it - m_measures.begin());
+}
+
 QString MeasurementsTool::fmtLenInProjectUnit(double m) const {
     if (!m_host || !m_host->settings()) {
         return QString("%1 cm").arg(m, 0, 'f', 2);
@@ -489,7 +797,6 @@ void MeasurementsTool::finishCurrentMeasure(QWidget* parentForAdvanced) {
     }
     Measure mm;
     mm.createdAt = QDateTime::currentDateTime();
-    mm.pts = m_currentPts;
     if (m_mode == Mode::Linear) {
         mm.type = MeasureType::Linear;
         mm.unit = QStringLiteral("cm");
@@ -509,7 +816,6 @@ void MeasurementsTool::finishCurrentMeasure(QWidget* parentForAdvanced) {
     } else {
         mm = m_advTemplate;
         mm.createdAt = QDateTime::currentDateTime();
-        mm.pts = m_currentPts;
         mm.bufferGlobalMeters = 0.0;
         FinalBufferDialog fd(parentForAdvanced, m_host->settings());
         if (fd.exec() == QDialog::Accepted) {
@@ -519,14 +825,9 @@ void MeasurementsTool::finishCurrentMeasure(QWidget* parentForAdvanced) {
             mm.bufferFinalMeters = 0.0;
         }
     }
-    mm.id = m_nextId++;
-    if (mm.name.isEmpty()) mm.name = QString("Pomiar %1").arg(mm.id);
-    mm.lengthMeters = polyLengthCm(mm.pts);
-    mm.totalWithBufferMeters = mm.lengthMeters + mm.bufferGlobalMeters + mm.bufferDefaultMeters + mm.bufferFinalMeters;
-    m_measures.push_back(mm);
+    addMeasure(std::move(mm), m_currentPts);
     m_currentPts.clear();
     m_mode = Mode::None;
-    m_host->requestUpdate();
     if (m_onFinished) {
         m_onFinished();
     }
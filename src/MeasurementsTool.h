@@ -1,10 +1,14 @@
 #pragma once
 
+#include "DotSpriteCache.h"
 #include "Measurements.h"
+#include "SegmentIndex.h"
 #include "ToolModule.h"
 
 #include <QColor>
+#include <QFont>
 #include <functional>
+#include <unordered_map>
 #include <vector>
 
 class MeasurementsTool : public ToolModule {
@@ -20,6 +24,23 @@ public:
     void deactivate() override;
 
     void draw(QPainter& painter) override;
+    /// Statystyki ostatniego wywołania draw (dla profilera rysowania).
+    struct DrawStats {
+        int drawn = 0;
+        int culled = 0;
+        int lodHits = 0;
+        int lodMisses = 0;
+        int spriteHits = 0;
+        int spriteMisses = 0;
+    };
+    const DrawStats& lastDrawStats() const { return m_drawStats; }
+    /**
+     * Etykiety widoczne po usunięciu nakładających się są wyznaczane raz
+     * dla wszystkich pomiarów i pamiętane, aby odświeżenie fragmentu
+     * warstwy dawało ten sam wynik co pełne.  Wywoływane przy każdym
+     * pełnym unieważnieniu warstwy pomiarów.
+     */
+    void invalidateLabelLayout();
     void drawOverlay(QPainter& painter, bool hasMouseWorld, const QPointF& mouseWorld) override;
 
     bool mousePress(QMouseEvent* event) override;
@@ -46,9 +67,29 @@ public:
     void setCurrentLineWidth(int w);
 
     bool hasAnyMeasure() const;
+    /**
+     * Dodaje gotowy pomiar (np. wczytany z projektu) z nowym
+     * identyfikatorem; punkty pts są kopiowane do wspólnego bufora
+     * geometrii (nie mogą wskazywać na bufor tego narzędzia), a długości
+     * i prostokąt ograniczający są liczone od nowa.  Zwraca nadany
+     * identyfikator.
+     */
+    int addMeasure(Measure measure, PointsView pts);
     void updateAllMeasureColors(const QColor& color);
     void updateAllMeasureLineWidths(int width);
     void recalculateLengths();
+
+    /**
+     * Wersje powyższych operacji bez odświeżania płótna, dla ProjectBatch.
+     * Zmieniają wyłącznie listę pomiarów tego narzędzia i jej sumy – nie
+     * wywołują ToolHost ani niczego z QWidget – więc narzędzia różnych
+     * kondygnacji można przetwarzać równolegle w wątkach roboczych, o ile
+     * wątek GUI w tym czasie nie używa żadnego z nich.  Odświeżenie
+     * (invalidateLayer) należy wykonać potem w wątku GUI.
+     */
+    void assignMeasureColors(const QColor& color);
+    void assignMeasureLineWidths(int width);
+    void recomputeLengths(double pixelsPerMeter);
     void scaleAllPoints(double factor);
 
     QColor selectedMeasureColor() const;
@@ -64,11 +105,27 @@ public:
     int selectedMeasureIndex() const;
 
     const std::vector<Measure>& measures() const;
+    /// Sumy wszystkich pomiarów, aktualizowane przy dodaniu, edycji i usunięciu.
+    const MeasureTotals& totals() const;
+    /// Punkty pomiaru; widok jest ważny do najbliższej zmiany listy pomiarów.
+    PointsView points(const Measure& m) const;
+    const SegmentIndex& segmentIndex() const { return m_segmentIndex; }
 
 private:
-    double polyLengthCm(const std::vector<QPointF>& pts) const;
+    double polyLengthCm(PointsView pts) const;
+    /// Długość rysowanego pomiaru wraz z odcinkiem do kursora.
+    double overlayLength(const QPointF& mouseWorld) const;
+    /// Obszar świata zajmowany przez nakładkę dla danej pozycji kursora.
+    QRectF overlayRect(const QPointF& mouseWorld) const;
     QString fmtLenInProjectUnit(double m) const;
     void finishCurrentMeasure(QWidget* parentForAdvanced = nullptr);
+    void rebuildSegmentIndex();
+    /// Punkty pomiaru uproszczone do rozdzielczości bieżącego powiększenia.
+    PointsView simplifiedPoints(const Measure& m, double zoom);
+    void updateLabelLayout(const QFont& font);
+    void drawMeasureDots(QPainter& p, const QColor& color, int lineWidthPx, PointsView pts);
+    /// Indeks pomiaru o danym id (pomiary są uporządkowane według id).
+    int indexOfMeasureId(int id) const;
 
     ToolHost* m_host = nullptr;
     std::function<void()> m_onFinished;
@@ -77,9 +134,33 @@ private:
     Mode m_mode = Mode::None;
     int m_nextId = 1;
     std::vector<Measure> m_measures;
+    // Punkty wszystkich pomiarów w jednym buforze (Measure::points)
+    MeasureGeometry m_geometry;
+    MeasureTotals m_totals;
+    // Siatka odcinków m_measures do wyboru pomiaru w punkcie
+    SegmentIndex m_segmentIndex;
+    // Uproszczone kopie punktów (Douglas–Peucker) według id pomiaru
+    struct SimplifiedPts {
+        bool valid = false;
+        int bucket = 0;
+        std::vector<QPointF> pts;
+    };
+    std::unordered_map<int, SimplifiedPts> m_simplified;
+    // Etykiety pozostawione przez LabelDeclutter (indeksy jak w m_measures)
+    struct LabelLayout {
+        bool valid = false;
+        QFont font;
+        std::vector<char> shown;
+    };
+    LabelLayout m_labelLayout;
+    DotSpriteCache m_dotSprites;
+    DrawStats m_drawStats;
     std::vector<QPointF> m_currentPts;
     Measure m_advTemplate;
     std::vector<QPointF> m_redoPts;
+    // Poprzednia pozycja kursora – jej nakładkę trzeba zamazać przy ruchu
+    QPointF m_lastMouseWorld;
+    bool m_hasLastMouseWorld = false;
 
     int m_selectedMeasureIndex = -1;
     QColor m_currentColor;
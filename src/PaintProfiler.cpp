@@ -0,0 +1,239 @@
+#include "PaintProfiler.h"
+
+#include <QFile>
+#include <QFontMetrics>
+#include <QPainter>
+#include <QStringList>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+const char* const kPhaseNames[PaintProfiler::kPhaseCount] = {
+    "Podkład", "Pomiary", "Dymki", "Nakładka"};
+const char* const kCounterNames[PaintProfiler::kCounterCount] = {
+    "Pomiary narysowane", "Pomiary pominięte", "Dymki narysowane", "Dymki pominięte"};
+const char* const kCacheNames[PaintProfiler::kCacheCount] = {
+    "Warstwy", "Kafelki podkładu", "Uproszczone łamane", "Kropki", "Układ dymków"};
+
+double percentileOf(std::vector<double> values, double q) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    const double clamped = std::clamp(q, 0.0, 1.0);
+    const size_t k = size_t(std::lround(clamped * double(values.size() - 1)));
+    std::nth_element(values.begin(), values.begin() + std::ptrdiff_t(k), values.end());
+    return values[k];
+}
+
+double meanOf(const std::vector<double>& values) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    double sum = 0.0;
+    for (double v : values) {
+        sum += v;
+    }
+    return sum / double(values.size());
+}
+} // namespace
+
+PaintProfiler::PhaseScope::PhaseScope(PaintProfiler& profiler, Phase phase)
+    : m_profiler(profiler), m_phase(phase),
+      m_startNs(profiler.m_inFrame ? profiler.m_clock.nsecsElapsed() : 0) {}
+
+PaintProfiler::PhaseScope::~PhaseScope() {
+    if (m_profiler.m_inFrame) {
+        m_profiler.addPhaseTime(m_phase, m_profiler.m_clock.nsecsElapsed() - m_startNs);
+    }
+}
+
+void PaintProfiler::setEnabled(bool enabled) {
+    if (m_enabled == enabled) {
+        return;
+    }
+    m_enabled = enabled;
+    m_inFrame = false;
+    if (enabled && !m_clock.isValid()) {
+        m_clock.start();
+    }
+}
+
+void PaintProfiler::reset() {
+    m_frames.clear();
+    m_nextFrame = 0;
+    m_lastCounts = {};
+    m_inFrame = false;
+}
+
+void PaintProfiler::beginFrame() {
+    if (!m_enabled) {
+        return;
+    }
+    m_current = Frame();
+    m_current.counts.fill(-1);
+    m_frameStartNs = m_clock.nsecsElapsed();
+    m_inFrame = true;
+}
+
+void PaintProfiler::endFrame() {
+    if (!m_inFrame) {
+        return;
+    }
+    m_inFrame = false;
+    m_current.frameMs = double(m_clock.nsecsElapsed() - m_frameStartNs) / 1e6;
+    for (int i = 0; i < kCounterCount; ++i) {
+        if (m_current.counts[i] >= 0) {
+            m_lastCounts[i] = m_current.counts[i];
+        }
+    }
+    if (int(m_frames.size()) < kWindowFrames) {
+        m_frames.push_back(m_current);
+    } else {
+        m_frames[size_t(m_nextFrame)] = m_current;
+    }
+    m_nextFrame = (m_nextFrame + 1) % kWindowFrames;
+}
+
+void PaintProfiler::addPhaseTime(Phase phase, qint64 ns) {
+    m_current.phaseMs[int(phase)] += double(ns) / 1e6;
+}
+
+void PaintProfiler::addCount(Counter counter, int value) {
+    if (!m_inFrame) {
+        return;
+    }
+    int& slot = m_current.counts[int(counter)];
+    slot = std::max(slot, 0) + value;
+}
+
+void PaintProfiler::addCacheStats(Cache cache, int hits, int misses) {
+    if (!m_inFrame) {
+        return;
+    }
+    m_current.hits[int(cache)] += hits;
+    m_current.misses[int(cache)] += misses;
+}
+
+template <typename Value>
+std::vector<double> PaintProfiler::collect(Value value) const {
+    std::vector<double> values;
+    values.reserve(m_frames.size());
+    for (const Frame& f : m_frames) {
+        const double v = value(f);
+        if (v >= 0.0) {
+            values.push_back(v);
+        }
+    }
+    return values;
+}
+
+double PaintProfiler::frameTimePercentile(double q) const {
+    return percentileOf(collect([](const Frame& f) { return f.frameMs; }), q);
+}
+
+double PaintProfiler::phaseTimePercentile(Phase phase, double q) const {
+    return percentileOf(collect([phase](const Frame& f) { return f.phaseMs[int(phase)]; }), q);
+}
+
+double PaintProfiler::cacheHitRate(Cache cache) const {
+    qint64 hits = 0;
+    qint64 total = 0;
+    for (const Frame& f : m_frames) {
+        hits += f.hits[int(cache)];
+        total += f.hits[int(cache)] + f.misses[int(cache)];
+    }
+    return total > 0 ? double(hits) / double(total) : -1.0;
+}
+
+QRect PaintProfiler::drawHud(QPainter& painter, const QPoint& topLeft) const {
+    QStringList lines;
+    lines << QString::fromUtf8("Klatka: %1 ms  (p50 %2 / p90 %3 / p99 %4, %5 kl.)")
+                 .arg(m_frames.empty()
+                          ? 0.0
+                          : m_frames[size_t((m_nextFrame + kWindowFrames - 1) % kWindowFrames)].frameMs,
+                      0, 'f', 2)
+                 .arg(frameTimePercentile(0.5), 0, 'f', 2)
+                 .arg(frameTimePercentile(0.9), 0, 'f', 2)
+                 .arg(frameTimePercentile(0.99), 0, 'f', 2)
+                 .arg(m_frames.size());
+    for (int i = 0; i < kPhaseCount; ++i) {
+        lines << QString::fromUtf8("  %1: p50 %2 / p90 %3 ms")
+                     .arg(QString::fromUtf8(kPhaseNames[i]))
+                     .arg(phaseTimePercentile(Phase(i), 0.5), 0, 'f', 2)
+                     .arg(phaseTimePercentile(Phase(i), 0.9), 0, 'f', 2);
+    }
+    lines << QString::fromUtf8("Pomiary: %1 narysowanych, %2 pominiętych")
+                 .arg(m_lastCounts[int(Counter::MeasuresDrawn)])
+                 .arg(m_lastCounts[int(Counter::MeasuresCulled)]);
+    lines << QString::fromUtf8("Dymki: %1 narysowanych, %2 pominiętych")
+                 .arg(m_lastCounts[int(Counter::CalloutsDrawn)])
+                 .arg(m_lastCounts[int(Counter::CalloutsCulled)]);
+    for (int i = 0; i < kCacheCount; ++i) {
+        const double rate = cacheHitRate(Cache(i));
+        lines << QString::fromUtf8("  %1: %2")
+                     .arg(QString::fromUtf8(kCacheNames[i]))
+                     .arg(rate < 0.0 ? QStringLiteral("–")
+                                     : QStringLiteral("%1%").arg(rate * 100.0, 0, 'f', 1));
+    }
+
+    const QFontMetrics fm(painter.font());
+    int width = 0;
+    for (const QString& line : lines) {
+        width = std::max(width, fm.horizontalAdvance(line));
+    }
+    const int pad = 6;
+    const QRect box(topLeft, QSize(width + 2 * pad, int(lines.size()) * fm.height() + 2 * pad));
+    painter.save();
+    painter.fillRect(box, QColor(0, 0, 0, 170));
+    painter.setPen(Qt::white);
+    int y = box.top() + pad + fm.ascent();
+    for (const QString& line : lines) {
+        painter.drawText(box.left() + pad, y, line);
+        y += fm.height();
+    }
+    painter.restore();
+    return box;
+}
+
+bool PaintProfiler::exportStats(const QString& path) const {
+    QFile f(path);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        return false;
+    }
+    QTextStream out(&f);
+    out.setEncoding(QStringConverter::Utf8);
+    out << QString::fromUtf8("Metryka;Jednostka;Próbki;Średnia;p50;p90;p99;Maks.\n");
+    const auto writeRow = [&out](const QString& name, const QString& unit,
+                                 const std::vector<double>& values) {
+        const double maxValue = values.empty() ? 0.0
+                                               : *std::max_element(values.begin(), values.end());
+        out << name << ';' << unit << ';' << values.size() << ';'
+            << QString::number(meanOf(values), 'f', 3) << ';'
+            << QString::number(percentileOf(values, 0.5), 'f', 3) << ';'
+            << QString::number(percentileOf(values, 0.9), 'f', 3) << ';'
+            << QString::number(percentileOf(values, 0.99), 'f', 3) << ';'
+            << QString::number(maxValue, 'f', 3) << '\n';
+    };
+    writeRow(QString::fromUtf8("Klatka"), QStringLiteral("ms"),
+             collect([](const Frame& fr) { return fr.frameMs; }));
+    for (int i = 0; i < kPhaseCount; ++i) {
+        writeRow(QString::fromUtf8(kPhaseNames[i]), QStringLiteral("ms"),
+                 collect([i](const Frame& fr) { return fr.phaseMs[i]; }));
+    }
+    for (int i = 0; i < kCounterCount; ++i) {
+        writeRow(QString::fromUtf8(kCounterNames[i]), QStringLiteral("szt."),
+                 collect([i](const Frame& fr) { return double(fr.counts[i]); }));
+    }
+    // Skuteczność pamięci podręcznych: percentyle po klatkach z odwołaniami
+    for (int i = 0; i < kCacheCount; ++i) {
+        writeRow(QString::fromUtf8("Trafienia: %1").arg(QString::fromUtf8(kCacheNames[i])),
+                 QStringLiteral("%"), collect([i](const Frame& fr) {
+                     const int total = fr.hits[i] + fr.misses[i];
+                     return total > 0 ? 100.0 * fr.hits[i] / total : -1.0;
+                 }));
+    }
+    out.flush();
+    return out.status() == QTextStream::Ok && f.error() == QFileDevice::NoError;
+}
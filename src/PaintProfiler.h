@@ -0,0 +1,91 @@
+#pragma once
+#include <QElapsedTimer>
+#include <QPoint>
+#include <QRect>
+#include <QString>
+#include <array>
+#include <vector>
+
+class QPainter;
+
+/**
+ * Pomiar czasu rysowania płótna.  CanvasWidget::paintEvent otacza każdą
+ * klatkę parą beginFrame/endFrame, a jej fazy (podkład, pomiary, dymki,
+ * nakładka) obiektami PhaseScope.  Ostatnie kWindowFrames klatek jest
+ * przechowywane w buforze cyklicznym, z którego liczone są percentyle
+ * pokazywane na nakładce (drawHud) i zapisywane do pliku (exportStats).
+ *
+ * Wyłączony profiler nie mierzy niczego – wszystkie metody wracają
+ * od razu.
+ */
+class PaintProfiler {
+public:
+    enum class Phase { Background, Measures, Callouts, Overlay };
+    static constexpr int kPhaseCount = 4;
+    /// Liczniki obiektów z ostatniego renderowania danej warstwy.
+    enum class Counter { MeasuresDrawn, MeasuresCulled, CalloutsDrawn, CalloutsCulled };
+    static constexpr int kCounterCount = 4;
+    enum class Cache { Layers, BackgroundTiles, MeasureLod, DotSprites, CalloutLayout };
+    static constexpr int kCacheCount = 5;
+    /// Liczba klatek, z których liczone są percentyle.
+    static constexpr int kWindowFrames = 600;
+
+    /// Mierzy czas fazy od konstrukcji do destrukcji obiektu.
+    class PhaseScope {
+    public:
+        PhaseScope(PaintProfiler& profiler, Phase phase);
+        ~PhaseScope();
+        PhaseScope(const PhaseScope&) = delete;
+        PhaseScope& operator=(const PhaseScope&) = delete;
+
+    private:
+        PaintProfiler& m_profiler;
+        Phase m_phase;
+        qint64 m_startNs;
+    };
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return m_enabled; }
+    void reset();
+
+    void beginFrame();
+    void endFrame();
+    void addCount(Counter counter, int value);
+    void addCacheStats(Cache cache, int hits, int misses);
+
+    int frameCount() const { return int(m_frames.size()); }
+    /// Percentyl q (0..1) czasu klatki w milisekundach.
+    double frameTimePercentile(double q) const;
+    double phaseTimePercentile(Phase phase, double q) const;
+    /// Odsetek trafień w oknie klatek albo -1, gdy nie było odwołań.
+    double cacheHitRate(Cache cache) const;
+
+    /// Rysuje panel statystyk w układzie widżetu, od punktu topLeft; zwraca jego prostokąt.
+    QRect drawHud(QPainter& painter, const QPoint& topLeft) const;
+    /**
+     * Zapisuje percentyle z bieżącego okna do pliku CSV (UTF-8, separator
+     * ';').  Zwraca false, gdy pliku nie udało się zapisać.
+     */
+    bool exportStats(const QString& path) const;
+
+private:
+    struct Frame {
+        double frameMs = 0.0;
+        std::array<double, kPhaseCount> phaseMs{};
+        std::array<int, kCounterCount> counts{}; ///< -1 – brak pomiaru w tej klatce
+        std::array<int, kCacheCount> hits{};
+        std::array<int, kCacheCount> misses{};
+    };
+    template <typename Value>
+    std::vector<double> collect(Value value) const;
+    void addPhaseTime(Phase phase, qint64 ns);
+
+    bool m_enabled = false;
+    bool m_inFrame = false;
+    QElapsedTimer m_clock;
+    qint64 m_frameStartNs = 0;
+    Frame m_current;
+    std::vector<Frame> m_frames; ///< bufor cykliczny, najwyżej kWindowFrames
+    int m_nextFrame = 0;
+    std::array<int, kCounterCount> m_lastCounts{};
+};
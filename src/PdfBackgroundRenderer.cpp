@@ -0,0 +1,152 @@
+#include "PdfBackgroundRenderer.h"
+
+#include <QtPdf/QPdfDocument>
+#include <QtPdf/QPdfDocumentRenderOptions>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Rozmiar rastra strony o zadanej szerokości, z zachowaniem proporcji.
+QSize rasterSizeForWidth(const QSizeF& pointSize, double targetWidth) {
+    const double scale = targetWidth / pointSize.width();
+    return QSize(std::max(1, int(pointSize.width() * scale)),
+                 std::max(1, int(pointSize.height() * scale)));
+}
+
+// Margines (względem widocznego obszaru) renderowany na zapas, aby
+// niewielkie przesunięcia widoku nie wymagały nowego kafelka.
+constexpr double kRegionMargin = 0.125;
+} // namespace
+
+PdfBackgroundRenderer::PdfBackgroundRenderer(std::shared_ptr<QPdfDocument> document,
+                                             int pageIndex, QObject* parent)
+    : QObject(parent)
+    , m_document(std::move(document))
+    , m_pageIndex(pageIndex) {
+    if (m_document) {
+        const QSizeF pt = m_document->pagePointSize(m_pageIndex);
+        if (!pt.isEmpty()) {
+            m_baseSize = rasterSizeForWidth(pt, kBaseWidth);
+        }
+    }
+    connect(&m_watcher, &QFutureWatcher<QImage>::finished,
+            this, &PdfBackgroundRenderer::onRenderFinished);
+}
+
+PdfBackgroundRenderer::~PdfBackgroundRenderer() {
+    // Zadanie w tle korzysta z dokumentu; czekamy, aby nie zwalniać go
+    // poza wątkiem GUI.
+    m_watcher.waitForFinished();
+}
+
+QSize PdfBackgroundRenderer::pageRasterSize(QPdfDocument& document, int pageIndex, double targetWidth) {
+    if (pageIndex < 0 || pageIndex >= document.pageCount()) {
+        return QSize();
+    }
+    const QSizeF pt = document.pagePointSize(pageIndex);
+    if (pt.isEmpty()) {
+        return QSize();
+    }
+    return rasterSizeForWidth(pt, targetWidth);
+}
+
+QImage PdfBackgroundRenderer::renderPage(QPdfDocument& document, int pageIndex, double targetWidth) {
+    const QSize size = pageRasterSize(document, pageIndex, targetWidth);
+    if (size.isEmpty()) {
+        return QImage();
+    }
+    QImage rendered = document.render(pageIndex, size);
+    if (rendered.isNull()) {
+        return QImage();
+    }
+    return rendered.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+}
+
+bool PdfBackgroundRenderer::covers(const QRectF& rect, double zoom) const {
+    return !m_tile.isNull() && qFuzzyCompare(m_tileZoom, zoom) && m_tileRect.contains(rect);
+}
+
+void PdfBackgroundRenderer::requestRegion(const QRectF& visibleRect, double deviceZoom) {
+    if (!m_document || m_baseSize.isEmpty()) {
+        return;
+    }
+    if (deviceZoom <= 1.0) {
+        // Raster bazowy wystarcza – ostry kafelek byłby zbędny.
+        m_tile = QImage();
+        m_tileRect = QRectF();
+        m_tileZoom = 0.0;
+        m_hasPending = false;
+        return;
+    }
+
+    // Powiększenie zaokrąglamy w górę do potęgi pierwiastka z dwóch, aby
+    // każdy krok kółkiem myszy nie wymuszał nowego renderowania.
+    const double zoom = std::pow(2.0, std::ceil(std::log2(deviceZoom) * 2.0) / 2.0);
+    const QRectF baseBounds(QPointF(0, 0), QSizeF(m_baseSize));
+    const QRectF wanted = visibleRect.intersected(baseBounds);
+    if (wanted.isEmpty() || covers(wanted, zoom)) {
+        return;
+    }
+    if (m_watcher.isRunning() && qFuzzyCompare(m_running.zoom, zoom)
+        && QRectF(QPointF(m_running.clip.topLeft()) / zoom,
+                  QSizeF(m_running.clip.size()) / zoom).contains(wanted)) {
+        m_hasPending = false;
+        return;
+    }
+
+    const double mx = wanted.width() * kRegionMargin;
+    const double my = wanted.height() * kRegionMargin;
+    const QRectF region = wanted.adjusted(-mx, -my, mx, my).intersected(baseBounds);
+
+    Request request;
+    request.zoom = zoom;
+    request.scaledSize = QSize(int(std::ceil(m_baseSize.width() * zoom)),
+                               int(std::ceil(m_baseSize.height() * zoom)));
+    request.clip = QRectF(region.topLeft() * zoom, region.size() * zoom)
+                       .toAlignedRect()
+                       .intersected(QRect(QPoint(0, 0), request.scaledSize));
+    if (request.clip.isEmpty()) {
+        return;
+    }
+
+    if (m_watcher.isRunning()) {
+        // Zachowujemy tylko najnowsze żądanie; pośrednie są nieistotne.
+        m_pending = request;
+        m_hasPending = true;
+        return;
+    }
+    startRender(request);
+}
+
+void PdfBackgroundRenderer::startRender(const Request& request) {
+    m_running = request;
+    std::shared_ptr<QPdfDocument> document = m_document;
+    const int pageIndex = m_pageIndex;
+    m_watcher.setFuture(QtConcurrent::run([document, pageIndex, request]() {
+        QPdfDocumentRenderOptions options;
+        options.setScaledSize(request.scaledSize);
+        options.setScaledClipRect(request.clip);
+        QImage image = document->render(pageIndex, request.clip.size(), options);
+        if (!image.isNull()) {
+            image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        }
+        return image;
+    }));
+}
+
+void PdfBackgroundRenderer::onRenderFinished() {
+    const QImage image = m_watcher.result();
+    if (!image.isNull()) {
+        m_tile = image;
+        m_tileZoom = m_running.zoom;
+        m_tileRect = QRectF(QPointF(m_running.clip.topLeft()) / m_running.zoom,
+                            QSizeF(m_running.clip.size()) / m_running.zoom);
+        emit tileReady();
+    }
+    if (m_hasPending) {
+        m_hasPending = false;
+        startRender(m_pending);
+    }
+}
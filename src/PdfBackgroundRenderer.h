@@ -0,0 +1,93 @@
+#pragma once
+#include <QObject>
+#include <QImage>
+#include <QRect>
+#include <QRectF>
+#include <QSize>
+#include <QSizeF>
+#include <QFutureWatcher>
+#include <memory>
+
+class QPdfDocument;
+
+/**
+ * Renderer podkładu PDF zależny od powiększenia.  Dokument pozostaje
+ * otwarty przez cały czas życia obiektu.  Przy powiększeniu większym niż
+ * rozdzielczość rastra bazowego (kBaseWidth) renderer w wątku roboczym
+ * rasteryzuje wektorowo tylko widoczny fragment strony.  Do czasu
+ * otrzymania ostrego kafelka płótno rysuje raster bazowy.
+ *
+ * Wszystkie współrzędne przyjmowane i zwracane przez klasę są wyrażone
+ * w pikselach rastra bazowego (czyli w układzie obrazu podkładu).
+ */
+class PdfBackgroundRenderer : public QObject {
+    Q_OBJECT
+public:
+    /// Szerokość rastra bazowego w pikselach (dotychczasowa stała 2000 px).
+    static constexpr double kBaseWidth = 2000.0;
+
+    PdfBackgroundRenderer(std::shared_ptr<QPdfDocument> document, int pageIndex,
+                          QObject* parent = nullptr);
+    ~PdfBackgroundRenderer() override;
+
+    /**
+     * Rozmiar rastra strony o szerokości targetWidth (z zachowaniem
+     * proporcji).  Zwraca pusty rozmiar dla niepoprawnej strony.
+     */
+    static QSize pageRasterSize(QPdfDocument& document, int pageIndex,
+                                double targetWidth = kBaseWidth);
+    /**
+     * Renderuje całą stronę tak, aby miała szerokość targetWidth pikseli.
+     * Zwraca pusty obraz w razie błędu.
+     */
+    static QImage renderPage(QPdfDocument& document, int pageIndex,
+                             double targetWidth = kBaseWidth);
+
+    std::shared_ptr<QPdfDocument> document() const { return m_document; }
+    int pageIndex() const { return m_pageIndex; }
+    /// Rozmiar rastra bazowego odpowiadającego całej stronie.
+    QSize baseSize() const { return m_baseSize; }
+
+    /**
+     * Zgłasza widoczny obszar (w pikselach rastra bazowego) oraz liczbę
+     * pikseli urządzenia na piksel rastra.  Jeśli bieżący kafelek nie
+     * pokrywa obszaru w wystarczającej rozdzielczości, zlecane jest nowe
+     * renderowanie.  Przy powiększeniu nieprzekraczającym rastra bazowego
+     * kafelek jest porzucany.
+     */
+    void requestRegion(const QRectF& visibleRect, double deviceZoom);
+
+    /// Czy dostępny jest ostry kafelek.
+    bool hasTile() const { return !m_tile.isNull(); }
+    /// Ostry kafelek oraz jego położenie w pikselach rastra bazowego.
+    const QImage& tile() const { return m_tile; }
+    QRectF tileRect() const { return m_tileRect; }
+
+signals:
+    /// Emitowany w wątku GUI, gdy gotowy jest nowy ostry kafelek.
+    void tileReady();
+
+private:
+    struct Request {
+        QSize scaledSize;  ///< rozmiar całej strony przy danym powiększeniu
+        QRect clip;        ///< renderowany fragment w układzie scaledSize
+        double zoom = 0.0; ///< piksele kafelka na piksel rastra bazowego
+    };
+
+    bool covers(const QRectF& rect, double zoom) const;
+    void startRender(const Request& request);
+    void onRenderFinished();
+
+    std::shared_ptr<QPdfDocument> m_document;
+    int m_pageIndex = 0;
+    QSize m_baseSize;
+
+    QImage m_tile;
+    QRectF m_tileRect;
+    double m_tileZoom = 0.0;
+
+    QFutureWatcher<QImage> m_watcher;
+    Request m_running;
+    Request m_pending;
+    bool m_hasPending = false;
+};
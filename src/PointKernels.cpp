@@ -0,0 +1,211 @@
+#include "PointKernels.h"
+
+#include <cmath>
+
+// QPointF to dwie liczby double (x, y) – wersje wektorowe traktują tablicę
+// punktów jak tablicę double.  Przy innym typie qreal zostaje wersja skalarna.
+#if (defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))) \
+    && !defined(QT_COORD_TYPE)
+#define POINT_KERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define POINT_KERNELS_TARGET_AVX2
+#else
+#define POINT_KERNELS_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+static_assert(sizeof(QPointF) == 2 * sizeof(double), "QPointF musi składać się z dwóch double");
+#endif
+
+namespace PointKernels {
+namespace {
+
+double lengthScalar(const QPointF* pts, size_t count) {
+    double sum = 0.0;
+    for (size_t i = 1; i < count; ++i) {
+        const double dx = pts[i].x() - pts[i - 1].x();
+        const double dy = pts[i].y() - pts[i - 1].y();
+        sum += std::sqrt(dx * dx + dy * dy);
+    }
+    return sum;
+}
+
+void scaleScalar(QPointF* pts, size_t count, double factor) {
+    for (size_t i = 0; i < count; ++i) {
+        pts[i] = QPointF(pts[i].x() * factor, pts[i].y() * factor);
+    }
+}
+
+void transformScalar(QPointF* pts, size_t count, const QTransform& t) {
+    for (size_t i = 0; i < count; ++i) {
+        const double x = pts[i].x();
+        const double y = pts[i].y();
+        pts[i] = QPointF(t.m11() * x + t.m21() * y + t.dx(), t.m12() * x + t.m22() * y + t.dy());
+    }
+}
+
+#ifdef POINT_KERNELS_X86
+
+double lengthSse2(const QPointF* pts, size_t count) {
+    if (count < 2) {
+        return 0.0;
+    }
+    const double* d = reinterpret_cast<const double*>(pts);
+    __m128d acc = _mm_setzero_pd();
+    size_t i = 1;
+    // Dwa odcinki naraz: (dx0, dy0), (dx1, dy1) -> (dx0² + dy0², dx1² + dy1²)
+    for (; i + 1 < count; i += 2) {
+        const __m128d p0 = _mm_loadu_pd(d + 2 * (i - 1));
+        const __m128d p1 = _mm_loadu_pd(d + 2 * i);
+        const __m128d p2 = _mm_loadu_pd(d + 2 * (i + 1));
+        const __m128d a = _mm_sub_pd(p1, p0);
+        const __m128d b = _mm_sub_pd(p2, p1);
+        const __m128d a2 = _mm_mul_pd(a, a);
+        const __m128d b2 = _mm_mul_pd(b, b);
+        const __m128d sq = _mm_add_pd(_mm_unpacklo_pd(a2, b2), _mm_unpackhi_pd(a2, b2));
+        acc = _mm_add_pd(acc, _mm_sqrt_pd(sq));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, acc);
+    return lanes[0] + lanes[1] + lengthScalar(pts + i - 1, count - (i - 1));
+}
+
+void scaleSse2(QPointF* pts, size_t count, double factor) {
+    double* d = reinterpret_cast<double*>(pts);
+    const __m128d f = _mm_set1_pd(factor);
+    for (size_t i = 0; i < count; ++i) {
+        _mm_storeu_pd(d + 2 * i, _mm_mul_pd(_mm_loadu_pd(d + 2 * i), f));
+    }
+}
+
+void transformSse2(QPointF* pts, size_t count, const QTransform& t) {
+    double* d = reinterpret_cast<double*>(pts);
+    // (x', y') = x · (m11, m12) + y · (m21, m22) + (dx, dy)
+    const __m128d cx = _mm_setr_pd(t.m11(), t.m12());
+    const __m128d cy = _mm_setr_pd(t.m21(), t.m22());
+    const __m128d off = _mm_setr_pd(t.dx(), t.dy());
+    for (size_t i = 0; i < count; ++i) {
+        const __m128d p = _mm_loadu_pd(d + 2 * i);
+        const __m128d xx = _mm_unpacklo_pd(p, p);
+        const __m128d yy = _mm_unpackhi_pd(p, p);
+        _mm_storeu_pd(d + 2 * i, _mm_add_pd(_mm_add_pd(_mm_mul_pd(xx, cx), _mm_mul_pd(yy, cy)), off));
+    }
+}
+
+POINT_KERNELS_TARGET_AVX2
+double lengthAvx2(const QPointF* pts, size_t count) {
+    if (count < 2) {
+        return 0.0;
+    }
+    const double* d = reinterpret_cast<const double*>(pts);
+    __m256d acc = _mm256_setzero_pd();
+    size_t i = 1;
+    // Cztery odcinki naraz; hadd daje kwadraty długości w kolejności 0, 2, 1, 3
+    for (; i + 3 < count; i += 4) {
+        const __m256d a = _mm256_sub_pd(_mm256_loadu_pd(d + 2 * i), _mm256_loadu_pd(d + 2 * (i - 1)));
+        const __m256d b = _mm256_sub_pd(_mm256_loadu_pd(d + 2 * (i + 2)), _mm256_loadu_pd(d + 2 * (i + 1)));
+        const __m256d sq = _mm256_hadd_pd(_mm256_mul_pd(a, a), _mm256_mul_pd(b, b));
+        acc = _mm256_add_pd(acc, _mm256_sqrt_pd(sq));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, acc);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + lengthScalar(pts + i - 1, count - (i - 1));
+}
+
+POINT_KERNELS_TARGET_AVX2
+void scaleAvx2(QPointF* pts, size_t count, double factor) {
+    double* d = reinterpret_cast<double*>(pts);
+    const __m256d f = _mm256_set1_pd(factor);
+    size_t i = 0;
+    for (; i + 1 < count; i += 2) {
+        _mm256_storeu_pd(d + 2 * i, _mm256_mul_pd(_mm256_loadu_pd(d + 2 * i), f));
+    }
+    scaleScalar(pts + i, count - i, factor);
+}
+
+POINT_KERNELS_TARGET_AVX2
+void transformAvx2(QPointF* pts, size_t count, const QTransform& t) {
+    double* d = reinterpret_cast<double*>(pts);
+    const __m256d cx = _mm256_setr_pd(t.m11(), t.m12(), t.m11(), t.m12());
+    const __m256d cy = _mm256_setr_pd(t.m21(), t.m22(), t.m21(), t.m22());
+    const __m256d off = _mm256_setr_pd(t.dx(), t.dy(), t.dx(), t.dy());
+    size_t i = 0;
+    for (; i + 1 < count; i += 2) {
+        const __m256d p = _mm256_loadu_pd(d + 2 * i);
+        const __m256d xx = _mm256_unpacklo_pd(p, p);
+        const __m256d yy = _mm256_unpackhi_pd(p, p);
+        _mm256_storeu_pd(d + 2 * i,
+                         _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(xx, cx), _mm256_mul_pd(yy, cy)), off));
+    }
+    transformScalar(pts + i, count - i, t);
+}
+
+bool cpuHasAvx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4] = {};
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    // System musi zachowywać rejestry YMM (OSXSAVE + XCR0)
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!osxsave || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // POINT_KERNELS_X86
+
+const Variant kScalar{"scalar", lengthScalar, scaleScalar, transformScalar};
+#ifdef POINT_KERNELS_X86
+const Variant kSse2{"sse2", lengthSse2, scaleSse2, transformSse2};
+const Variant kAvx2{"avx2", lengthAvx2, scaleAvx2, transformAvx2};
+#endif
+
+const Variant& variant() {
+    static const Variant& selected = []() -> const Variant& {
+#ifdef POINT_KERNELS_X86
+        return cpuHasAvx2() ? kAvx2 : kSse2;
+#else
+        return kScalar;
+#endif
+    }();
+    return selected;
+}
+
+} // namespace
+
+double polylineLength(const QPointF* pts, size_t count) {
+    return variant().length(pts, count);
+}
+
+void scale(QPointF* pts, size_t count, double factor) {
+    variant().scale(pts, count, factor);
+}
+
+void transform(QPointF* pts, size_t count, const QTransform& t) {
+    variant().transform(pts, count, t);
+}
+
+const char* activeVariant() {
+    return variant().name;
+}
+
+std::vector<Variant> availableVariants() {
+    std::vector<Variant> variants{kScalar};
+#ifdef POINT_KERNELS_X86
+    variants.push_back(kSse2);
+    if (cpuHasAvx2()) {
+        variants.push_back(kAvx2);
+    }
+#endif
+    return variants;
+}
+
+} // namespace PointKernels
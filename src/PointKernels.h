@@ -0,0 +1,41 @@
+#pragma once
+#include <QPointF>
+#include <QTransform>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Operacje na ciągłych tablicach punktów (np. bufor MeasureGeometry)
+ * w wersjach SSE2 i AVX2 z wersją skalarną dla pozostałych procesorów.
+ * Wariant jest wybierany raz, przy pierwszym wywołaniu, na podstawie
+ * możliwości procesora.
+ *
+ * Wyniki wersji wektorowych mogą różnić się od skalarnych jedynie
+ * kolejnością sumowania (długość łamanej), czyli na ostatnich bitach.
+ */
+namespace PointKernels {
+
+/// Suma długości odcinków łamanej pts[0] – pts[count - 1].
+double polylineLength(const QPointF* pts, size_t count);
+
+/// Mnoży obie współrzędne wszystkich punktów przez factor.
+void scale(QPointF* pts, size_t count, double factor);
+
+/// Przekształca punkty macierzą afiniczną t (składowe perspektywy są pomijane).
+void transform(QPointF* pts, size_t count, const QTransform& t);
+
+/// Nazwa używanego wariantu: "avx2", "sse2" albo "scalar".
+const char* activeVariant();
+
+/// Implementacja operacji w jednym wariancie.
+struct Variant {
+    const char* name;
+    double (*length)(const QPointF*, size_t);
+    void (*scale)(QPointF*, size_t, double);
+    void (*transform)(QPointF*, size_t, const QTransform&);
+};
+
+/// Warianty obsługiwane przez ten procesor, skalarny pierwszy (do testów).
+std::vector<Variant> availableVariants();
+
+} // namespace PointKernels
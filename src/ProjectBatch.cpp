@@ -0,0 +1,64 @@
+#include "ProjectBatch.h"
+
+#include "CanvasWidget.h"
+#include "Trace.h"
+
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <algorithm>
+
+namespace {
+// Zadanie jednej kondygnacji: narzędzie i dane odczytane w wątku GUI.
+struct FloorJob {
+    MeasurementsTool* tool = nullptr;
+    double pixelsPerMeter = 1.0;
+};
+} // namespace
+
+ProjectBatch::ProjectBatch(std::vector<CanvasWidget*> canvases)
+    : m_canvases(std::move(canvases)) {
+    m_canvases.erase(std::remove(m_canvases.begin(), m_canvases.end(), nullptr), m_canvases.end());
+}
+
+void ProjectBatch::setMeasureColor(const QColor& color) {
+    m_color = color;
+}
+
+void ProjectBatch::setMeasureLineWidth(int width) {
+    m_lineWidth = width;
+}
+
+void ProjectBatch::recalculateLengths() {
+    m_lengths = true;
+}
+
+int ProjectBatch::run() {
+    TRACE_SCOPE("ProjectBatch::run");
+    if (m_color || m_lineWidth || m_lengths) {
+        // Narzędzia i skale pobierane w wątku GUI; zadania nie czytają płótna.
+        std::vector<FloorJob> jobs;
+        jobs.reserve(m_canvases.size());
+        for (CanvasWidget* canvas : m_canvases) {
+            jobs.push_back(FloorJob{&canvas->measurementsTool(), canvas->pixelsPerMeter()});
+        }
+        const std::optional<QColor> color = m_color;
+        const std::optional<int> lineWidth = m_lineWidth;
+        const bool lengths = m_lengths;
+        QtConcurrent::blockingMap(jobs, [color, lineWidth, lengths](FloorJob& job) {
+            TRACE_SCOPE("ProjectBatch::floor");
+            if (color) {
+                job.tool->assignMeasureColors(*color);
+            }
+            if (lineWidth) {
+                job.tool->assignMeasureLineWidths(*lineWidth);
+            }
+            if (lengths) {
+                job.tool->recomputeLengths(job.pixelsPerMeter);
+            }
+        });
+    }
+    for (CanvasWidget* canvas : m_canvases) {
+        canvas->invalidateLayer(CanvasLayer::Measures);
+    }
+    return int(m_canvases.size());
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <QColor>
+#include <optional>
+#include <vector>
+
+class CanvasWidget;
+
+/**
+ * Operacje obejmujące cały projekt (wszystkie kondygnacje wszystkich
+ * budynków), rozdzielane na pulę wątków – po jednym zadaniu na
+ * kondygnację.  Operacje są najpierw zbierane, a run() wykonuje je
+ * razem i odświeża każde płótno tylko raz, na końcu.
+ *
+ * Model danych wątków:
+ *  - zadanie kondygnacji zmienia wyłącznie pomiary jej MeasurementsTool
+ *    (metody assign… i recomputeLengths), które nie dotykają QWidget
+ *    ani ToolHost;
+ *  - wszystko, czego zadanie potrzebuje z płótna (skala), jest
+ *    odczytywane wcześniej w wątku GUI;
+ *  - run() czeka na zakończenie zadań (QtConcurrent::blockingMap),
+ *    więc wątek GUI nie obsługuje w tym czasie zdarzeń i nie może
+ *    równolegle zmieniać tych samych danych;
+ *  - odświeżenie warstw odbywa się po powrocie, w wątku GUI.
+ */
+class ProjectBatch {
+public:
+    explicit ProjectBatch(std::vector<CanvasWidget*> canvases);
+
+    void setMeasureColor(const QColor& color);
+    void setMeasureLineWidth(int width);
+    /// Przelicza długości według bieżącej skali każdej kondygnacji.
+    void recalculateLengths();
+    /**
+     * Wykonuje zebrane operacje i odświeża płótna; zwraca liczbę
+     * kondygnacji.  Bez operacji jedynie odświeża.
+     */
+    int run();
+
+private:
+    std::vector<CanvasWidget*> m_canvases;
+    std::optional<QColor> m_color;
+    std::optional<int> m_lineWidth;
+    bool m_lengths = false;
+};
@@ -0,0 +1,282 @@
+#include "ProjectGenerator.h"
+
+#include <QPainter>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const char* const kDeviceLabels[] = {
+    "Gniazdo 2x230 V", "Gniazdo 400 V", "Oprawa LED 40 W", "Łącznik schodowy",
+    "Puszka rozgałęźna", "Czujka ruchu", "Gniazdo RJ45", "Rozdzielnica RB-%1",
+    "Oprawa awaryjna", "Przycisk ppoż.",
+};
+constexpr int kDeviceLabelCount = int(sizeof(kDeviceLabels) / sizeof(kDeviceLabels[0]));
+
+const QColor kRouteColors[] = {
+    QColor(0, 155, 0), QColor(200, 30, 30), QColor(30, 60, 200), QColor(230, 140, 0),
+    QColor(120, 0, 160),
+};
+constexpr int kRouteColorCount = int(sizeof(kRouteColors) / sizeof(kRouteColors[0]));
+
+/**
+ * Układ kondygnacji: korytarz przez środek i dwa rzędy pomieszczeń
+ * o losowych szerokościach.  Używany zarówno do rysowania podkładu, jak
+ * i do prowadzenia tras, więc zależy tylko od rozmiaru i ziarna.
+ */
+void layoutRooms(const QSize& size, quint32 seed, std::vector<QRectF>& rooms, QRectF& corridor) {
+    std::mt19937 rng(seed ^ 0x9e3779b9u);
+    const double margin = std::min(size.width(), size.height()) * 0.04;
+    const QRectF plate(margin, margin, size.width() - 2 * margin, size.height() - 2 * margin);
+    const double corridorH = plate.height() * 0.12;
+    corridor = QRectF(plate.left(), plate.center().y() - corridorH / 2.0, plate.width(), corridorH);
+    rooms.clear();
+    for (int row = 0; row < 2; ++row) {
+        const double top = row == 0 ? plate.top() : corridor.bottom();
+        const double bottom = row == 0 ? corridor.top() : plate.bottom();
+        double x = plate.left();
+        while (x < plate.right() - 1.0) {
+            double w = plate.width() * (0.08 + 0.10 * ProjectGenerator::unit(rng));
+            if (plate.right() - (x + w) < plate.width() * 0.06) {
+                w = plate.right() - x;
+            }
+            rooms.emplace_back(x, top, w, bottom - top);
+            x += w;
+        }
+    }
+}
+
+} // namespace
+
+ProjectGenerator::ProjectGenerator(const Params& params)
+    : m_params(params), m_rng(params.seed) {}
+
+double ProjectGenerator::unit(std::mt19937& rng) {
+    return double(rng()) / 4294967296.0;
+}
+
+double ProjectGenerator::uniform(double lo, double hi) {
+    return lo + (hi - lo) * unit(m_rng);
+}
+
+int ProjectGenerator::uniformInt(int lo, int hi) {
+    if (hi <= lo) {
+        return lo;
+    }
+    return lo + int(unit(m_rng) * double(hi - lo + 1));
+}
+
+bool ProjectGenerator::chance(double p) {
+    return unit(m_rng) < p;
+}
+
+GeneratedProject ProjectGenerator::generate() {
+    GeneratedProject project;
+    project.name = QStringLiteral("Projekt testowy %1").arg(m_params.seed);
+    project.address = QStringLiteral("ul. Testowa %1").arg(m_params.seed % 200 + 1);
+    project.investor = QStringLiteral("Inwestor %1").arg(m_params.seed);
+    project.floorSize = m_params.floorSize;
+    project.seed = m_params.seed;
+    for (int b = 0; b < m_params.buildings; ++b) {
+        GeneratedBuilding building;
+        building.name = QString::fromUtf8("Budynek %1").arg(b + 1);
+        for (int f = 0; f < m_params.floorsPerBuilding; ++f) {
+            building.floors.push_back(generateFloor(QString::fromUtf8("Piętro %1").arg(f)));
+        }
+        project.buildings.push_back(std::move(building));
+    }
+    return project;
+}
+
+GeneratedFloor ProjectGenerator::generateFloor(const QString& name) {
+    std::vector<QRectF> rooms;
+    QRectF corridor;
+    layoutRooms(m_params.floorSize, m_params.seed, rooms, corridor);
+
+    GeneratedFloor floor;
+    floor.name = name;
+    floor.measures.reserve(size_t(std::max(0, m_params.measuresPerFloor)));
+    for (int i = 0; i < m_params.measuresPerFloor; ++i) {
+        const double kind = unit(m_rng);
+        if (kind < m_params.linearShare) {
+            floor.measures.push_back(makeLinear(rooms, floor.geometry));
+        } else {
+            floor.measures.push_back(makeRoute(rooms, corridor,
+                                               kind < m_params.linearShare + m_params.advancedShare,
+                                               floor.geometry));
+        }
+    }
+    floor.callouts.reserve(size_t(std::max(0, m_params.calloutsPerFloor)));
+    for (int i = 0; i < m_params.calloutsPerFloor; ++i) {
+        floor.callouts.push_back(makeCallout(rooms, i + 1));
+    }
+    return floor;
+}
+
+Measure ProjectGenerator::makeLinear(const std::vector<QRectF>& rooms, MeasureGeometry& geometry) {
+    // Odcinek wzdłuż losowej ściany pomieszczenia
+    const QRectF& room = rooms[size_t(uniformInt(0, int(rooms.size()) - 1))];
+    const double inset = 15.0;
+    const QRectF r = room.adjusted(inset, inset, -inset, -inset);
+    Measure m;
+    m.type = MeasureType::Linear;
+    m.color = kRouteColors[0];
+    m.lineWidthPx = 1;
+    m.name = QString::fromUtf8("Odcinek %1").arg(++m_measureCounter);
+    if (chance(0.5)) {
+        const double y = chance(0.5) ? r.top() : r.bottom();
+        const double x0 = uniform(r.left(), r.center().x());
+        const double x1 = uniform(r.center().x(), r.right());
+        m.points = geometry.append(std::vector<QPointF>{QPointF(x0, y), QPointF(x1, y)});
+    } else {
+        const double x = chance(0.5) ? r.left() : r.right();
+        const double y0 = uniform(r.top(), r.center().y());
+        const double y1 = uniform(r.center().y(), r.bottom());
+        m.points = geometry.append(std::vector<QPointF>{QPointF(x, y0), QPointF(x, y1)});
+    }
+    return m;
+}
+
+std::vector<QPointF> ProjectGenerator::route(const std::vector<QRectF>& rooms, const QRectF& corridor,
+                                             int vertices) {
+    // Trasa: z pomieszczenia przez drzwi do korytarza, korytarzem do
+    // drugiego pomieszczenia i dalej wzdłuż jego ścian.
+    const QRectF& from = rooms[size_t(uniformInt(0, int(rooms.size()) - 1))];
+    const QRectF& to = rooms[size_t(uniformInt(0, int(rooms.size()) - 1))];
+    const double laneY = uniform(corridor.top() + corridor.height() * 0.2,
+                                 corridor.bottom() - corridor.height() * 0.2);
+    const auto doorY = [&corridor](const QRectF& room) {
+        return room.center().y() < corridor.center().y() ? room.bottom() : room.top();
+    };
+    const double inset = 20.0;
+    const QRectF inner = to.adjusted(inset, inset, -inset, -inset);
+    std::vector<QPointF> waypoints;
+    waypoints.emplace_back(uniform(from.left() + inset, from.right() - inset),
+                           uniform(from.top() + inset, from.bottom() - inset));
+    const double fromDoorX = uniform(from.left() + inset, from.right() - inset);
+    waypoints.emplace_back(fromDoorX, waypoints.back().y());
+    waypoints.emplace_back(fromDoorX, doorY(from));
+    waypoints.emplace_back(fromDoorX, laneY);
+    const double toDoorX = uniform(inner.left(), inner.right());
+    waypoints.emplace_back(toDoorX, laneY);
+    waypoints.emplace_back(toDoorX, doorY(to));
+    // Obiegnięcie ścian docelowego pomieszczenia (gniazda wzdłuż listwy)
+    const bool nearTop = doorY(to) <= to.top() + 1.0;
+    const double entryY = nearTop ? inner.top() : inner.bottom();
+    const double farY = nearTop ? inner.bottom() : inner.top();
+    waypoints.emplace_back(toDoorX, entryY);
+    waypoints.emplace_back(inner.left(), entryY);
+    waypoints.emplace_back(inner.left(), farY);
+    waypoints.emplace_back(inner.right(), farY);
+    waypoints.emplace_back(inner.right(), entryY);
+
+    // Długość łamanej i równomierne rozmieszczenie wierzchołków
+    double total = 0.0;
+    for (size_t i = 1; i < waypoints.size(); ++i) {
+        total += std::hypot(waypoints[i].x() - waypoints[i - 1].x(), waypoints[i].y() - waypoints[i - 1].y());
+    }
+    std::vector<QPointF> pts;
+    if (total <= 0.0 || vertices <= int(waypoints.size())) {
+        return waypoints;
+    }
+    pts.reserve(size_t(vertices));
+    const double step = total / double(vertices - 1);
+    size_t leg = 1;
+    double legStart = 0.0;
+    for (int i = 0; i < vertices; ++i) {
+        const double s = std::min(step * i, total);
+        double legLen = std::hypot(waypoints[leg].x() - waypoints[leg - 1].x(),
+                                   waypoints[leg].y() - waypoints[leg - 1].y());
+        while (leg + 1 < waypoints.size() && s > legStart + legLen) {
+            legStart += legLen;
+            ++leg;
+            legLen = std::hypot(waypoints[leg].x() - waypoints[leg - 1].x(),
+                                waypoints[leg].y() - waypoints[leg - 1].y());
+        }
+        const double t = legLen > 0.0 ? (s - legStart) / legLen : 0.0;
+        const QPointF p = waypoints[leg - 1] + (waypoints[leg] - waypoints[leg - 1]) * t;
+        // Lekkie odchylenie jak przy ręcznym klikaniu
+        pts.emplace_back(p.x() + uniform(-1.5, 1.5), p.y() + uniform(-1.5, 1.5));
+    }
+    return pts;
+}
+
+Measure ProjectGenerator::makeRoute(const std::vector<QRectF>& rooms, const QRectF& corridor,
+                                    bool advanced, MeasureGeometry& geometry) {
+    // Większość tras ma kilkadziesiąt wierzchołków, część – setki
+    const int maxVertices = std::max(2, m_params.maxPolylineVertices);
+    const int vertices = chance(0.15) ? uniformInt(maxVertices / 2, maxVertices)
+                                      : uniformInt(std::min(12, maxVertices), std::max(2, maxVertices / 5));
+    Measure m;
+    m.type = advanced ? MeasureType::Advanced : MeasureType::Polyline;
+    m.color = kRouteColors[size_t(uniformInt(0, kRouteColorCount - 1))];
+    m.lineWidthPx = uniformInt(1, 3);
+    m.points = geometry.append(route(rooms, corridor, vertices));
+    if (advanced) {
+        m.name = QString::fromUtf8("Obwód %1").arg(++m_measureCounter);
+        m.bufferDefaultMeters = std::round(uniform(50.0, 300.0));
+        m.bufferFinalMeters = std::round(uniform(30.0, 200.0));
+    } else {
+        m.name = QString::fromUtf8("Trasa %1").arg(++m_measureCounter);
+    }
+    return m;
+}
+
+TextItem ProjectGenerator::makeCallout(const std::vector<QRectF>& rooms, int number) {
+    // Dymki skupiają się przy ścianach pomieszczeń, jak opisy urządzeń
+    const QRectF& room = rooms[size_t(uniformInt(0, int(rooms.size()) - 1))];
+    const QPointF anchor(uniform(room.left() + 30.0, room.right() - 30.0),
+                         chance(0.5) ? room.top() + uniform(20.0, 60.0) : room.bottom() - uniform(20.0, 60.0));
+    QString label = QString::fromUtf8(kDeviceLabels[uniformInt(0, kDeviceLabelCount - 1)]);
+    if (label.contains(QLatin1String("%1"))) {
+        label = label.arg(number);
+    }
+    TextItem item;
+    item.pos = anchor;
+    item.text = chance(0.3) ? QString::fromUtf8("%1\nobwód %2, h=%3 cm").arg(label).arg(uniformInt(1, 48)).arg(uniformInt(30, 250))
+                            : label;
+    item.anchor = CalloutAnchor::Bottom;
+    // Rozmiar dymka jak przy wstawianiu w powiększeniu 1
+    const double ppm = m_params.pixelsPerMeter > 0.0 ? m_params.pixelsPerMeter : 1.0;
+    const double lines = item.text.count(QLatin1Char('\n')) + 1;
+    const QSizeF bubblePx(170.0, 16.0 * lines + 12.0);
+    item.boundingRect = QRectF(anchor - QPointF(bubblePx.width() / 2.0, bubblePx.height() + 14.0),
+                               bubblePx / ppm);
+    return item;
+}
+
+QImage ProjectGenerator::makeFloorPlan(const QSize& size, quint32 seed) {
+    std::vector<QRectF> rooms;
+    QRectF corridor;
+    layoutRooms(size, seed, rooms, corridor);
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::white);
+    QPainter p(&image);
+    p.setRenderHint(QPainter::Antialiasing, true);
+    QPen wall(QColor(40, 40, 40));
+    wall.setWidthF(6.0);
+    p.setPen(wall);
+    for (const QRectF& room : rooms) {
+        p.drawRect(room);
+    }
+    p.setPen(QColor(120, 120, 120));
+    QFont font = p.font();
+    font.setPixelSize(28);
+    p.setFont(font);
+    for (size_t i = 0; i < rooms.size(); ++i) {
+        p.drawText(rooms[i], Qt::AlignCenter, QString::fromUtf8("Pom. %1").arg(i + 1));
+    }
+    p.drawText(corridor, Qt::AlignCenter, QString::fromUtf8("Korytarz"));
+    return image;
+}
+
+void ProjectGenerator::populate(CanvasWidget& canvas, const GeneratedFloor& floor) {
+    auto& tool = canvas.measurementsTool();
+    for (const Measure& m : floor.measures) {
+        tool.addMeasure(m, floor.geometry.points(m.points));
+    }
+    for (const TextItem& item : floor.callouts) {
+        canvas.addTextItem(item);
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <QImage>
+#include <QSize>
+#include <QString>
+#include <random>
+#include <vector>
+#include "CanvasWidget.h"
+#include "Measurements.h"
+
+/**
+ * Sztuczny projekt do testów obciążeniowych: budynki z kondygnacjami,
+ * na każdej kondygnacji pomiary (odcinki wzdłuż ścian, trasy kablowe
+ * z setkami wierzchołków, pomiary zaawansowane z zapasami) i gęste
+ * dymki opisujące urządzenia.  Dane mają postać struktur używanych przez
+ * MainWindow, MeasurementsTool i CanvasWidget.
+ *
+ * Wynik zależy wyłącznie od parametrów i ziarna: liczby losowe pochodzą
+ * z std::mt19937, a na przedziały są przeliczane własnym kodem (rozkłady
+ * biblioteki standardowej różnią się między implementacjami).
+ */
+struct GeneratedFloor {
+    QString name;
+    std::vector<Measure> measures;   ///< bez identyfikatorów – nadaje je addMeasure
+    MeasureGeometry geometry;        ///< punkty pomiarów (Measure::points)
+    std::vector<TextItem> callouts;  ///< współrzędne świata
+};
+
+struct GeneratedBuilding {
+    QString name;
+    std::vector<GeneratedFloor> floors;
+};
+
+struct GeneratedProject {
+    QString name;
+    QString address;
+    QString investor;
+    QSize floorSize;                 ///< rozmiar podkładu (jednostki świata)
+    quint32 seed = 0;                ///< ziarno, z którego powstał rzut (makeFloorPlan)
+    std::vector<GeneratedBuilding> buildings;
+};
+
+class ProjectGenerator {
+public:
+    struct Params {
+        quint32 seed = 1;
+        int buildings = 3;
+        int floorsPerBuilding = 5;
+        int measuresPerFloor = 400;
+        int calloutsPerFloor = 150;
+        /// Najdłuższe trasy kablowe mają tyle wierzchołków.
+        int maxPolylineVertices = 400;
+        double advancedShare = 0.2;  ///< udział pomiarów zaawansowanych
+        double linearShare = 0.3;    ///< udział odcinków
+        QSize floorSize = QSize(8000, 6000);
+        /// Skala płótna, według której wymiarowane są dymki (jak przy wstawianiu w powiększeniu 1).
+        double pixelsPerMeter = 100.0;
+    };
+
+    explicit ProjectGenerator(const Params& params);
+
+    GeneratedProject generate();
+    GeneratedFloor generateFloor(const QString& name);
+
+    /// Rzut kondygnacji (ściany pomieszczeń) jako podkład; zależy od ziarna.
+    static QImage makeFloorPlan(const QSize& size, quint32 seed);
+    /// Dodaje pomiary i dymki kondygnacji do płótna.
+    static void populate(CanvasWidget& canvas, const GeneratedFloor& floor);
+    /// Liczba z przedziału [0, 1) z surowego wyniku mt19937 (przenośnie).
+    static double unit(std::mt19937& rng);
+
+private:
+    double uniform(double lo, double hi);
+    int uniformInt(int lo, int hi); ///< przedział domknięty
+    bool chance(double p);
+
+    std::vector<QPointF> route(const std::vector<QRectF>& rooms, const QRectF& corridor, int vertices);
+    Measure makeLinear(const std::vector<QRectF>& rooms, MeasureGeometry& geometry);
+    Measure makeRoute(const std::vector<QRectF>& rooms, const QRectF& corridor, bool advanced,
+                      MeasureGeometry& geometry);
+    TextItem makeCallout(const std::vector<QRectF>& rooms, int number);
+
+    Params m_params;
+    std::mt19937 m_rng;
+    int m_measureCounter = 0;
+};
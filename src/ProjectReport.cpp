@@ -0,0 +1,103 @@
+#include "ProjectReport.h"
+
+#include "MeasureReportModel.h"
+#include "Trace.h"
+
+#include <QHash>
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <algorithm>
+
+namespace {
+
+// Sumy grup z indeksem identyfikatora grupy; wynik częściowy (jedna
+// kondygnacja) i końcowy mają tę samą postać.  Identyfikator rozróżnia
+// grupy, a nazwa (ProjectReportGroup::key) jest tylko wyświetlana.
+struct GroupSums {
+    std::vector<ProjectReportGroup> groups;
+    std::vector<QString> ids;
+    QHash<QString, int> index;
+
+    MeasureTotals& at(const QString& id, const QString& name) {
+        auto it = index.constFind(id);
+        if (it == index.constEnd()) {
+            it = index.insert(id, int(groups.size()));
+            groups.push_back(ProjectReportGroup{name, MeasureTotals()});
+            ids.push_back(id);
+        }
+        return groups[size_t(*it)].totals;
+    }
+    MeasureTotals& at(const QString& key) { return at(key, key); }
+};
+
+QString buildingId(const ProjectReportSource& source) {
+    return QString::number(source.buildingIndex);
+}
+
+QString floorId(const ProjectReportSource& source) {
+    return QStringLiteral("%1/%2").arg(source.buildingIndex).arg(source.floorIndex);
+}
+
+QString floorName(const ProjectReportSource& source) {
+    return QStringLiteral("%1 / %2").arg(source.building, source.floor);
+}
+
+} // namespace
+
+ProjectReport::ProjectReport(std::vector<ProjectReportSource> sources)
+    : m_sources(std::move(sources)) {
+    m_sources.erase(std::remove_if(m_sources.begin(), m_sources.end(),
+                                   [](const ProjectReportSource& s) { return s.measures == nullptr; }),
+                    m_sources.end());
+}
+
+std::vector<ProjectReportGroup> ProjectReport::group(ReportGrouping grouping) const {
+    TRACE_SCOPE("ProjectReport::group");
+    auto mapFloor = [grouping](const ProjectReportSource& source) {
+        GroupSums sums;
+        // Budynek i kondygnacja są wspólne dla całej listy pomiarów
+        if (grouping == ReportGrouping::Building || grouping == ReportGrouping::Floor) {
+            MeasureTotals& totals = grouping == ReportGrouping::Building
+                                        ? sums.at(buildingId(source), source.building)
+                                        : sums.at(floorId(source), floorName(source));
+            for (const Measure& m : *source.measures) {
+                totals.add(m);
+            }
+            return sums;
+        }
+        for (const Measure& m : *source.measures) {
+            switch (grouping) {
+                case ReportGrouping::Layer: sums.at(m.layer).add(m); break;
+                case ReportGrouping::Type: sums.at(MeasureReportModel::typeName(m.type)).add(m); break;
+                default: sums.at(m.name).add(m); break;
+            }
+        }
+        return sums;
+    };
+    auto reduce = [](GroupSums& result, const GroupSums& partial) {
+        for (size_t i = 0; i < partial.groups.size(); ++i) {
+            const ProjectReportGroup& g = partial.groups[i];
+            result.at(partial.ids[i], g.key).merge(g.totals);
+        }
+    };
+    GroupSums merged = QtConcurrent::blockingMappedReduced<GroupSums>(
+        m_sources, mapFloor, reduce, QtConcurrent::OrderedReduce);
+
+    if (grouping != ReportGrouping::Building && grouping != ReportGrouping::Floor) {
+        std::sort(merged.groups.begin(), merged.groups.end(),
+                  [](const ProjectReportGroup& a, const ProjectReportGroup& b) {
+                      return QString::localeAwareCompare(a.key, b.key) < 0;
+                  });
+    }
+    return std::move(merged.groups);
+}
+
+QString ProjectReport::groupingName(ReportGrouping grouping) {
+    switch (grouping) {
+        case ReportGrouping::Building: return QString::fromUtf8("Budynek");
+        case ReportGrouping::Floor: return QString::fromUtf8("Kondygnacja");
+        case ReportGrouping::Layer: return QString::fromUtf8("Warstwa");
+        case ReportGrouping::Type: return QString::fromUtf8("Typ");
+        case ReportGrouping::Name: default: return QString::fromUtf8("Nazwa");
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <QString>
+#include <vector>
+#include "Measurements.h"
+
+/// Kryterium grupowania raportu projektu.
+enum class ReportGrouping { Building, Floor, Layer, Type, Name };
+
+/**
+ * Pomiary jednej kondygnacji wraz z jej położeniem w projekcie.  Grupy
+ * budynków i kondygnacji są rozróżniane po indeksach, więc budynki (albo
+ * kondygnacje jednego budynku) o tej samej nazwie nie są scalane; nazwy
+ * służą tylko do wyświetlania.
+ */
+struct ProjectReportSource {
+    int buildingIndex = 0;
+    int floorIndex = 0;
+    QString building;
+    QString floor;
+    const std::vector<Measure>* measures = nullptr;
+};
+
+/// Sumy jednej grupy raportu projektu.
+struct ProjectReportGroup {
+    QString key; ///< nazwa grupy do wyświetlania
+    MeasureTotals totals;
+};
+
+/**
+ * Raport zbiorczy całego projektu: sumy pomiarów wszystkich kondygnacji
+ * wszystkich budynków pogrupowane według budynku, kondygnacji, warstwy,
+ * typu albo nazwy.
+ *
+ * Każda kondygnacja jest sumowana w osobnym zadaniu puli wątków
+ * (QtConcurrent::blockingMappedReduced), które czyta pomiary w miejscu
+ * i oddaje tylko sumy swoich grup; wyniki są scalane w kolejności
+ * kondygnacji.  Pomiary nie są kopiowane do wspólnej listy.
+ *
+ * Zadania tylko czytają listy pomiarów, a wątek GUI czeka na ich
+ * zakończenie, więc w tym czasie nie może tych list zmieniać (jak
+ * w ProjectBatch).
+ */
+class ProjectReport {
+public:
+    explicit ProjectReport(std::vector<ProjectReportSource> sources);
+
+    /**
+     * Sumy grup.  Budynki i kondygnacje są w kolejności projektu,
+     * pozostałe grupy – alfabetycznie.
+     */
+    std::vector<ProjectReportGroup> group(ReportGrouping grouping) const;
+
+    /// Nazwa grupowania do interfejsu („Budynek”, „Kondygnacja”…).
+    static QString groupingName(ReportGrouping grouping);
+
+    const std::vector<ProjectReportSource>& sources() const { return m_sources; }
+
+private:
+    std::vector<ProjectReportSource> m_sources;
+};
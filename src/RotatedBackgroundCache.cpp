@@ -0,0 +1,91 @@
+#include "RotatedBackgroundCache.h"
+
+#include <QPainter>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Górny limit liczby kafelków niezależny od rozmiaru okna (ok. 64 MB).
+constexpr int kMinTileBudget = 256;
+} // namespace
+
+quint64 RotatedBackgroundCache::tileId(int column, int row) {
+    return (quint64(quint32(column)) << 32) | quint64(quint32(row));
+}
+
+void RotatedBackgroundCache::clear() {
+    m_tiles.clear();
+    m_valid = false;
+}
+
+void RotatedBackgroundCache::invalidate(const QRectF& worldRect) {
+    if (!m_valid || worldRect.isEmpty()) {
+        return;
+    }
+    for (auto it = m_tiles.begin(); it != m_tiles.end();) {
+        const int c = int(qint32(quint32(it.key() >> 32)));
+        const int r = int(qint32(quint32(it.key() & 0xffffffffu)));
+        const QRectF tileRect(c * m_tileWorld, r * m_tileWorld, m_tileWorld, m_tileWorld);
+        it = tileRect.intersects(worldRect) ? m_tiles.erase(it) : std::next(it);
+    }
+}
+
+int RotatedBackgroundCache::draw(QPainter& painter, const QRectF& visibleWorld, double deviceZoom,
+                                 const Key& key, const PaintFunction& paint) {
+    if (visibleWorld.isEmpty() || deviceZoom <= 0.0) {
+        m_lastVisibleTiles = 0;
+        return 0;
+    }
+    // Przedziały powiększenia są potęgami dwójki; rysowany kafelek jest
+    // skalowany co najwyżej o czynnik pierwiastka z dwóch.
+    const int bucket = int(std::lround(std::log2(deviceZoom)));
+    if (!m_valid || key != m_key || bucket != m_zoomBucket) {
+        m_tiles.clear();
+        m_key = key;
+        m_zoomBucket = bucket;
+        m_valid = true;
+    }
+    const double bucketZoom = std::ldexp(1.0, bucket);
+    const double tileWorld = kTileSize / bucketZoom;
+    m_tileWorld = tileWorld;
+
+    const int c0 = int(std::floor(visibleWorld.left() / tileWorld));
+    const int c1 = int(std::floor(visibleWorld.right() / tileWorld));
+    const int r0 = int(std::floor(visibleWorld.top() / tileWorld));
+    const int r1 = int(std::floor(visibleWorld.bottom() / tileWorld));
+
+    int rendered = 0;
+    for (int r = r0; r <= r1; ++r) {
+        for (int c = c0; c <= c1; ++c) {
+            const QRectF tileRect(c * tileWorld, r * tileWorld, tileWorld, tileWorld);
+            auto it = m_tiles.find(tileId(c, r));
+            if (it == m_tiles.end()) {
+                QImage tile(kTileSize, kTileSize, QImage::Format_ARGB32_Premultiplied);
+                tile.fill(Qt::transparent);
+                QPainter tp(&tile);
+                tp.setRenderHint(QPainter::SmoothPixmapTransform, true);
+                tp.scale(bucketZoom, bucketZoom);
+                tp.translate(-tileRect.topLeft());
+                paint(tp, tileRect, bucketZoom);
+                tp.end();
+                it = m_tiles.insert(tileId(c, r), tile);
+                ++rendered;
+            }
+            painter.drawImage(tileRect, it.value());
+        }
+    }
+
+    // Ogranicz pamięć: przy nadmiarze usuwamy kafelki poza widokiem.
+    const int visibleCount = (c1 - c0 + 1) * (r1 - r0 + 1);
+    m_lastVisibleTiles = visibleCount;
+    if (m_tiles.size() > std::max(kMinTileBudget, 2 * visibleCount)) {
+        for (auto it = m_tiles.begin(); it != m_tiles.end();) {
+            const int c = int(qint32(quint32(it.key() >> 32)));
+            const int r = int(qint32(quint32(it.key() & 0xffffffffu)));
+            const bool visible = c >= c0 && c <= c1 && r >= r0 && r <= r1;
+            it = visible ? std::next(it) : m_tiles.erase(it);
+        }
+    }
+    return rendered;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <QHash>
+#include <QImage>
+#include <QPointF>
+#include <QRectF>
+#include <functional>
+
+class QPainter;
+
+/**
+ * Pamięć podręczna obróconego podkładu.  Obrót o dowolny kąt wymaga
+ * kosztownego przepróbkowania obrazu, dlatego podkład jest raz
+ * renderowany (z obrotem i przezroczystością) do kafelków wyrównanych
+ * do osi świata, w rozdzielczości odpowiadającej bieżącemu przedziałowi
+ * powiększenia.  Kolejne klatki, w tym przesuwanie widoku, jedynie
+ * kopiują gotowe kafelki; nowe powstają tylko dla odsłoniętych obszarów.
+ */
+class RotatedBackgroundCache {
+public:
+    /// Bok kafelka w pikselach urządzenia.
+    static constexpr int kTileSize = 256;
+
+    /**
+     * Parametry, od których zależy zawartość kafelków.  Zmiana dowolnego
+     * z nich unieważnia pamięć podręczną.
+     */
+    struct Key {
+        const void* asset = nullptr;
+        QPointF offset;
+        double rotationDeg = 0.0;
+        double opacity = 1.0;
+        bool operator==(const Key& other) const {
+            return asset == other.asset && offset == other.offset
+                && rotationDeg == other.rotationDeg && opacity == other.opacity;
+        }
+        bool operator!=(const Key& other) const { return !(*this == other); }
+    };
+
+    /**
+     * Funkcja rysująca przekształcony podkład.  Malarz ustawiony jest
+     * w układzie świata; visibleWorld to obszar kafelka, a deviceZoom
+     * liczba pikseli kafelka na jednostkę świata.
+     */
+    using PaintFunction = std::function<void(QPainter& painter, const QRectF& visibleWorld,
+                                             double deviceZoom)>;
+
+    /**
+     * Rysuje widoczny obszar (w układzie świata bieżącego malarza) z
+     * kafelków, renderując brakujące przy użyciu paint.  Zwraca liczbę
+     * kafelków, które trzeba było wyrenderować w tej klatce.
+     */
+    int draw(QPainter& painter, const QRectF& visibleWorld, double deviceZoom,
+             const Key& key, const PaintFunction& paint);
+
+    void clear();
+    /**
+     * Usuwa kafelki przecinające prostokąt świata, np. po nadejściu
+     * ostrego fragmentu PDF; pozostałe kafelki zostają w pamięci.
+     */
+    void invalidate(const QRectF& worldRect);
+    int tileCount() const { return m_tiles.size(); }
+    /// Liczba kafelków pokrywających widok w ostatnim wywołaniu draw.
+    int lastVisibleTileCount() const { return m_lastVisibleTiles; }
+
+private:
+    static quint64 tileId(int column, int row);
+
+    Key m_key;
+    int m_zoomBucket = 0;
+    double m_tileWorld = 0.0; ///< bok kafelka w jednostkach świata dla m_zoomBucket
+    bool m_valid = false;
+    int m_lastVisibleTiles = 0;
+    QHash<quint64, QImage> m_tiles;
+};
@@ -0,0 +1,146 @@
+#include "SegmentIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+SegmentIndex::SegmentIndex(double cellSize)
+    : m_cellSize(cellSize > 0.0 ? cellSize : kDefaultCellSize) {}
+
+int SegmentIndex::cellCoord(double v) const {
+    return int(std::floor(v / m_cellSize));
+}
+
+quint64 SegmentIndex::cellKey(int column, int row) {
+    return (quint64(quint32(column)) << 32) | quint64(quint32(row));
+}
+
+// Przejście po komórkach siatki wzdłuż odcinka (Amanatides–Woo).
+template <typename Fn>
+void SegmentIndex::forEachCell(const QPointF& a, const QPointF& b, Fn fn) const {
+    int cx = cellCoord(a.x());
+    int cy = cellCoord(a.y());
+    const int ex = cellCoord(b.x());
+    const int ey = cellCoord(b.y());
+    const double dx = b.x() - a.x();
+    const double dy = b.y() - a.y();
+    const int stepX = dx > 0 ? 1 : (dx < 0 ? -1 : 0);
+    const int stepY = dy > 0 ? 1 : (dy < 0 ? -1 : 0);
+    const double inf = std::numeric_limits<double>::infinity();
+    double tMaxX = stepX != 0 ? ((stepX > 0 ? cx + 1 : cx) * m_cellSize - a.x()) / dx : inf;
+    double tMaxY = stepY != 0 ? ((stepY > 0 ? cy + 1 : cy) * m_cellSize - a.y()) / dy : inf;
+    const double tDeltaX = stepX != 0 ? m_cellSize / std::abs(dx) : inf;
+    const double tDeltaY = stepY != 0 ? m_cellSize / std::abs(dy) : inf;
+
+    fn(cx, cy);
+    const int steps = std::abs(ex - cx) + std::abs(ey - cy);
+    for (int i = 0; i < steps; ++i) {
+        if (tMaxX < tMaxY) {
+            cx += stepX;
+            tMaxX += tDeltaX;
+        } else {
+            cy += stepY;
+            tMaxY += tDeltaY;
+        }
+        fn(cx, cy);
+    }
+    // Błędy zaokrągleń nie mogą pominąć komórki końcowej
+    if (cx != ex || cy != ey) {
+        fn(ex, ey);
+    }
+}
+
+void SegmentIndex::insert(int measureId, PointsView pts) {
+    if (pts.size() < 2) {
+        return;
+    }
+    MeasureCells& owned = m_measureCells[measureId];
+    for (size_t i = 1; i < pts.size(); ++i) {
+        const Entry entry{measureId, int(i - 1)};
+        forEachCell(pts[i - 1], pts[i], [&](int c, int r) {
+            const quint64 key = cellKey(c, r);
+            auto& cell = m_cells[key];
+            if (cell.empty() || !(cell.back() == entry)) {
+                cell.push_back(entry);
+                owned.cells.push_back(key);
+            }
+        });
+        ++owned.segments;
+        ++m_entryCount;
+    }
+    std::sort(owned.cells.begin(), owned.cells.end());
+    owned.cells.erase(std::unique(owned.cells.begin(), owned.cells.end()), owned.cells.end());
+}
+
+void SegmentIndex::remove(int measureId) {
+    auto owned = m_measureCells.find(measureId);
+    if (owned == m_measureCells.end()) {
+        return;
+    }
+    for (quint64 key : owned->cells) {
+        auto it = m_cells.find(key);
+        if (it == m_cells.end()) {
+            continue;
+        }
+        auto& cell = it.value();
+        cell.erase(std::remove_if(cell.begin(), cell.end(),
+                                  [measureId](const Entry& e) { return e.measureId == measureId; }),
+                   cell.end());
+        if (cell.empty()) {
+            m_cells.erase(it);
+        }
+    }
+    m_entryCount -= owned->segments;
+    m_measureCells.erase(owned);
+}
+
+void SegmentIndex::clear() {
+    m_cells.clear();
+    m_measureCells.clear();
+    m_entryCount = 0;
+}
+
+bool SegmentIndex::scale(double factor) {
+    if (!(factor > 0.0) || !std::isfinite(factor)) {
+        return false;
+    }
+    m_cellSize *= factor;
+    return true;
+}
+
+std::vector<SegmentIndex::Entry> SegmentIndex::candidates(const QRectF& area) const {
+    std::vector<Entry> result;
+    if (m_cells.isEmpty()) {
+        return result;
+    }
+    // Margines na zaokrąglenia: po scale() punkt leżący tuż przy granicy
+    // komórki może być wpisany do komórki sąsiedniej
+    const double margin = m_cellSize * 1e-9;
+    const QRectF r = area.normalized().adjusted(-margin, -margin, margin, margin);
+    const int c0 = cellCoord(r.left());
+    const int c1 = cellCoord(r.right());
+    const int r0 = cellCoord(r.top());
+    const int r1 = cellCoord(r.bottom());
+    // Duży obszar: taniej przejrzeć wszystkie niepuste komórki
+    if (qint64(c1 - c0 + 1) * (r1 - r0 + 1) > m_cells.size()) {
+        for (auto it = m_cells.constBegin(); it != m_cells.constEnd(); ++it) {
+            const int c = int(qint32(quint32(it.key() >> 32)));
+            const int row = int(qint32(quint32(it.key() & 0xffffffffu)));
+            if (c >= c0 && c <= c1 && row >= r0 && row <= r1) {
+                result.insert(result.end(), it->begin(), it->end());
+            }
+        }
+    } else {
+        for (int row = r0; row <= r1; ++row) {
+            for (int c = c0; c <= c1; ++c) {
+                auto it = m_cells.constFind(cellKey(c, row));
+                if (it != m_cells.constEnd()) {
+                    result.insert(result.end(), it->begin(), it->end());
+                }
+            }
+        }
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
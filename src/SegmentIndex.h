@@ -0,0 +1,78 @@
+#pragma once
+#include <QHash>
+#include <QPointF>
+#include <QRectF>
+#include <vector>
+
+#include "MeasureGeometry.h"
+
+/**
+ * Indeks przestrzenny odcinków pomiarów – równomierna siatka w układzie
+ * świata.  Każdy odcinek jest wpisany do komórek, przez które przechodzi,
+ * więc wybór pomiaru w punkcie sprawdza jedynie odcinki z kilku komórek
+ * wokół kursora zamiast wszystkich odcinków projektu.
+ *
+ * Pomiary są identyfikowane przez Measure::id.  Indeks aktualizuje się
+ * przyrostowo przy dodawaniu i usuwaniu pomiaru; usuwanie przechodzi po
+ * komórkach zapamiętanych przy wstawianiu, więc nie zależy od punktów.
+ * Skalowanie punktów względem początku układu odwzorowuje scale(), inne
+ * przekształcenia wymagają zbudowania indeksu od nowa.
+ */
+class SegmentIndex {
+public:
+    /// Domyślny bok komórki w jednostkach świata (pikselach podkładu).
+    static constexpr double kDefaultCellSize = 64.0;
+
+    struct Entry {
+        int measureId = 0;
+        int segment = 0; ///< odcinek między punktami segment i segment + 1 pomiaru
+        bool operator==(const Entry& other) const {
+            return measureId == other.measureId && segment == other.segment;
+        }
+        bool operator<(const Entry& other) const {
+            return measureId != other.measureId ? measureId < other.measureId
+                                                : segment < other.segment;
+        }
+    };
+
+    explicit SegmentIndex(double cellSize = kDefaultCellSize);
+
+    void insert(int measureId, PointsView pts);
+    /// Usuwa wszystkie odcinki pomiaru.
+    void remove(int measureId);
+    void clear();
+
+    /**
+     * Skaluje siatkę razem z punktami względem początku układu: bok komórki
+     * mnoży się przez factor, a przypisanie odcinków do komórek zostaje bez
+     * zmian, nic nie jest przeliczane.  Zwraca false dla współczynnika
+     * niedodatniego lub nieskończonego – wtedy indeks trzeba zbudować od nowa.
+     */
+    bool scale(double factor);
+
+    /**
+     * Zwraca odcinki z komórek przecinających area, bez powtórzeń,
+     * uporządkowane według identyfikatora pomiaru i numeru odcinka.
+     */
+    std::vector<Entry> candidates(const QRectF& area) const;
+
+    double cellSize() const { return m_cellSize; }
+    int entryCount() const { return m_entryCount; }
+
+private:
+    int cellCoord(double v) const;
+    static quint64 cellKey(int column, int row);
+    template <typename Fn>
+    void forEachCell(const QPointF& a, const QPointF& b, Fn fn) const;
+
+    /// Komórki, do których wpisano odcinki pomiaru (bez powtórzeń).
+    struct MeasureCells {
+        int segments = 0;
+        std::vector<quint64> cells;
+    };
+
+    double m_cellSize;
+    int m_entryCount = 0;
+    QHash<quint64, std::vector<Entry>> m_cells;
+    QHash<int, MeasureCells> m_measureCells;
+};
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <QFont>
 #include <QPointF>
+#include <QRectF>
 #include <QString>
 
 class QPainter;
@@ -9,16 +11,34 @@ class QKeyEvent;
 class QWidget;
 struct ProjectSettings;
 
+/**
+ * Warstwy płótna buforowane przez kompozytor.  Zawartość warstwy jest
+ * renderowana ponownie tylko po jej unieważnieniu (lub zmianie widoku);
+ * elementy rysowane w drawOverlay nie są buforowane.
+ */
+enum class CanvasLayer { Background, Measures, Callouts };
+
 class ToolHost {
 public:
     virtual ~ToolHost() = default;
     virtual QPointF toWorld(const QPointF& screen) const = 0;
     virtual QPointF toScreen(const QPointF& world) const = 0;
     virtual double zoom() const = 0;
+    /// Obszar świata widoczny w oknie (do pomijania obiektów spoza widoku).
+    virtual QRectF visibleWorldRect() const = 0;
     virtual double pixelsPerMeter() const = 0;
     virtual ProjectSettings* settings() const = 0;
     virtual bool isLayerVisible(const QString& layer) const = 0;
+    /// Czcionka, którą płótno rysuje nakładki narzędzi (np. etykiety długości).
+    virtual QFont overlayFont() const = 0;
+    /// Odświeża płótno bez zmiany buforowanych warstw (np. nakładka narzędzia).
     virtual void requestUpdate() = 0;
+    /// Odświeża tylko fragment nakładki (prostokąt w układzie świata).
+    virtual void requestUpdateRect(const QRectF& worldRect) = 0;
+    /// Unieważnia warstwę, której zawartość się zmieniła, i odświeża płótno.
+    virtual void invalidateLayer(CanvasLayer layer) = 0;
+    /// Unieważnia fragment warstwy (prostokąt w układzie świata).
+    virtual void invalidateLayerRect(CanvasLayer layer, const QRectF& worldRect) = 0;
 };
 
 class ToolModule {
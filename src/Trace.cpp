@@ -0,0 +1,177 @@
+#include "Trace.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+namespace Trace {
+namespace {
+// Górna granica liczby zdarzeń – długie sesje nie mogą zająć całej pamięci.
+constexpr size_t kMaxEvents = 2'000'000;
+
+struct Event {
+    const char* name;
+    const char* category;
+    qint64 startNs;
+    qint64 durationNs;
+    int thread;
+};
+
+struct State {
+    QMutex mutex;
+    QElapsedTimer clock;
+    QString path;
+    std::vector<Event> events;
+    QHash<Qt::HANDLE, int> threads;
+    QHash<int, QString> threadNames;
+    bool overflowed = false;
+};
+
+std::atomic<bool> g_enabled{false};
+
+State& state() {
+    static State s;
+    return s;
+}
+
+// Wywoływane pod blokadą; numer wątku jest krótki i stały w sesji.
+int threadIndex(State& s) {
+    const Qt::HANDLE id = QThread::currentThreadId();
+    auto it = s.threads.constFind(id);
+    if (it != s.threads.constEnd()) {
+        return it.value();
+    }
+    const int index = int(s.threads.size()) + 1;
+    s.threads.insert(id, index);
+    QThread* thread = QThread::currentThread();
+    QString name = thread ? thread->objectName() : QString();
+    if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread()) {
+        name = QStringLiteral("main");
+    } else if (name.isEmpty()) {
+        name = QStringLiteral("worker-%1").arg(index);
+    }
+    s.threadNames.insert(index, name);
+    return index;
+}
+
+QByteArray jsonString(const QString& text) {
+    QByteArray out = "\"";
+    for (const QChar ch : text) {
+        if (ch == QLatin1Char('"') || ch == QLatin1Char('\\')) {
+            out += '\\';
+            out += char(ch.unicode());
+        } else if (ch.unicode() < 0x20) {
+            out += QStringLiteral("\\u%1").arg(int(ch.unicode()), 4, 16, QLatin1Char('0')).toLatin1();
+        } else {
+            out += QString(ch).toUtf8();
+        }
+    }
+    out += '"';
+    return out;
+}
+} // namespace
+
+bool startFromArguments(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--trace") == 0) {
+            start(QString::fromLatin1(kDefaultFileName));
+            return true;
+        }
+        if (std::strncmp(arg, "--trace=", 8) == 0 && arg[8] != '\0') {
+            start(QString::fromLocal8Bit(arg + 8));
+            return true;
+        }
+    }
+    const QString env = qEnvironmentVariable(kEnvironmentVariable);
+    if (!env.isEmpty()) {
+        start(env);
+        return true;
+    }
+    return false;
+}
+
+void start(const QString& path) {
+    State& s = state();
+    QMutexLocker lock(&s.mutex);
+    s.path = path;
+    s.events.clear();
+    s.threads.clear();
+    s.threadNames.clear();
+    s.overflowed = false;
+    s.clock.start();
+    g_enabled.store(true, std::memory_order_release);
+}
+
+bool isEnabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+bool stop() {
+    if (!g_enabled.exchange(false)) {
+        return true;
+    }
+    State& s = state();
+    QMutexLocker lock(&s.mutex);
+    QSaveFile f(s.path);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    f.write("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    const auto separator = [&]() {
+        if (!first) {
+            f.write(",\n");
+        }
+        first = false;
+    };
+    for (auto it = s.threadNames.constBegin(); it != s.threadNames.constEnd(); ++it) {
+        separator();
+        f.write("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + QByteArray::number(it.key())
+                + ",\"args\":{\"name\":" + jsonString(it.value()) + "}}");
+    }
+    for (const Event& e : s.events) {
+        separator();
+        // Znaczniki czasu w mikrosekundach (z częścią ułamkową)
+        f.write("{\"name\":" + jsonString(QString::fromUtf8(e.name)) + ",\"cat\":"
+                + jsonString(QString::fromUtf8(e.category)) + ",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                + QByteArray::number(e.thread) + ",\"ts\":" + QByteArray::number(e.startNs / 1000.0, 'f', 3)
+                + ",\"dur\":" + QByteArray::number(e.durationNs / 1000.0, 'f', 3) + "}");
+    }
+    if (s.overflowed) {
+        separator();
+        f.write("{\"name\":\"trace buffer full\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":1,\"ts\":"
+                + QByteArray::number(s.clock.nsecsElapsed() / 1000.0, 'f', 3) + "}");
+    }
+    f.write("\n]}\n");
+    s.events.clear();
+    return f.commit();
+}
+
+Scope::Scope(const char* name, const char* category)
+    : m_name(name), m_category(category),
+      m_startNs(isEnabled() ? state().clock.nsecsElapsed() : -1) {}
+
+Scope::~Scope() {
+    if (m_startNs < 0 || !isEnabled()) {
+        return;
+    }
+    State& s = state();
+    const qint64 endNs = s.clock.nsecsElapsed();
+    QMutexLocker lock(&s.mutex);
+    if (s.events.size() >= kMaxEvents) {
+        s.overflowed = true;
+        return;
+    }
+    s.events.push_back(Event{m_name, m_category, m_startNs, endNs - m_startNs, threadIndex(s)});
+}
+
+} // namespace Trace
@@ -0,0 +1,53 @@
+#pragma once
+#include <QString>
+
+/**
+ * Lekkie punkty śledzenia w formacie Chrome Trace (chrome://tracing,
+ * ui.perfetto.dev).  Śledzenie włącza się zmienną środowiskową
+ * ELECCAD_TRACE=<plik.json> albo opcją --trace[=<plik.json>]; wtedy
+ * każdy TRACE_SCOPE zapisuje w pamięci zdarzenie z czasem trwania,
+ * a Trace::stop() zapisuje je do pliku.  Wyłączone śledzenie kosztuje
+ * jedno sprawdzenie flagi atomowej na punkt.
+ *
+ * Zdarzenia mogą pochodzić z dowolnego wątku (np. wczytywanie podkładu
+ * w tle).
+ */
+namespace Trace {
+
+/// Zmienna środowiskowa z nazwą pliku śladu.
+inline constexpr char kEnvironmentVariable[] = "ELECCAD_TRACE";
+/// Nazwa pliku przy --trace bez wartości.
+inline constexpr char kDefaultFileName[] = "eleccad_trace.json";
+
+/**
+ * Włącza śledzenie na podstawie argumentów programu (--trace,
+ * --trace=<plik>) lub zmiennej środowiskowej.  Zwraca true, gdy
+ * śledzenie zostało włączone.
+ */
+bool startFromArguments(int argc, char** argv);
+/// Włącza śledzenie; zdarzenia zostaną zapisane do path przy stop().
+void start(const QString& path);
+/// Zapisuje zebrane zdarzenia i wyłącza śledzenie; false przy błędzie zapisu.
+bool stop();
+bool isEnabled();
+
+/// Zdarzenie o czasie trwania od konstrukcji do destrukcji obiektu.
+class Scope {
+public:
+    explicit Scope(const char* name, const char* category = "app");
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    const char* m_name;
+    const char* m_category;
+    qint64 m_startNs; ///< -1 – śledzenie wyłączone
+};
+
+} // namespace Trace
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+/// Mierzy czas do końca bieżącego bloku; name musi być literałem.
+#define TRACE_SCOPE(name) ::Trace::Scope TRACE_CONCAT(traceScope_, __LINE__)(name)
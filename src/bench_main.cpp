@@ -0,0 +1,389 @@
+#include <QApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+#include "CanvasWidget.h"
+#include "Dialogs.h"
+#include "ExportManager.h"
+#include "MeasureReportModel.h"
+#include "PointKernels.h"
+#include "ProjectGenerator.h"
+#include "ProjectReport.h"
+#include "Settings.h"
+
+// Test wydajności bez okna (QT_QPA_PLATFORM=offscreen).  Buduje sztuczną
+// kondygnację (ProjectGenerator) z N pomiarami, M dymkami i dużym
+// podkładem z rzutem, mierzy najczęściej używane ścieżki i wypisuje
+// wyniki w formacie JSON (stdout albo --output).
+//
+// Użycie: BenchProgramEle [--measures N] [--callouts M] [--vertices V]
+//                         [--background SZERxWYS] [--iterations K]
+//                         [--seed S] [--output plik.json]
+// V to największa liczba wierzchołków trasy kablowej.
+
+namespace {
+
+struct Options {
+    int measures = 2000;
+    int callouts = 500;
+    int maxVertices = 400;
+    QSize background = QSize(8000, 6000);
+    int iterations = 10;
+    quint32 seed = 1;
+    QString output;
+};
+
+struct Result {
+    QString name;
+    std::vector<double> samplesMs;
+};
+
+bool parseOptions(const QStringList& args, Options& options, QString& error) {
+    for (int i = 1; i < args.size(); ++i) {
+        const QString& arg = args[i];
+        if (i + 1 >= args.size()) {
+            error = QStringLiteral("Brak wartości dla %1").arg(arg);
+            return false;
+        }
+        const QString value = args[++i];
+        bool ok = true;
+        if (arg == QLatin1String("--measures")) {
+            options.measures = value.toInt(&ok);
+        } else if (arg == QLatin1String("--callouts")) {
+            options.callouts = value.toInt(&ok);
+        } else if (arg == QLatin1String("--vertices")) {
+            options.maxVertices = std::max(2, value.toInt(&ok));
+        } else if (arg == QLatin1String("--iterations")) {
+            options.iterations = std::max(1, value.toInt(&ok));
+        } else if (arg == QLatin1String("--seed")) {
+            options.seed = value.toUInt(&ok);
+        } else if (arg == QLatin1String("--output")) {
+            options.output = value;
+        } else if (arg == QLatin1String("--background")) {
+            const QStringList parts = value.split(QLatin1Char('x'));
+            ok = parts.size() == 2;
+            if (ok) {
+                bool okW = false;
+                bool okH = false;
+                options.background = QSize(parts[0].toInt(&okW), parts[1].toInt(&okH));
+                ok = okW && okH && !options.background.isEmpty();
+            }
+        } else {
+            error = QStringLiteral("Nieznana opcja %1").arg(arg);
+            return false;
+        }
+        if (!ok) {
+            error = QStringLiteral("Niepoprawna wartość %1 dla %2").arg(value, arg);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Jeden przebieg rozgrzewający, potem `iterations` pomiarów.
+Result measure(const QString& name, int iterations, const std::function<void()>& fn) {
+    Result result;
+    result.name = name;
+    fn();
+    QElapsedTimer timer;
+    for (int i = 0; i < iterations; ++i) {
+        timer.start();
+        fn();
+        result.samplesMs.push_back(double(timer.nsecsElapsed()) / 1e6);
+    }
+    qDebug().noquote() << "  " << name << "ok";
+    return result;
+}
+
+QJsonObject summarize(const Result& result) {
+    std::vector<double> sorted = result.samplesMs;
+    std::sort(sorted.begin(), sorted.end());
+    double sum = 0.0;
+    for (double v : sorted) {
+        sum += v;
+    }
+    const auto at = [&sorted](double q) {
+        return sorted[size_t(q * double(sorted.size() - 1) + 0.5)];
+    };
+    QJsonObject obj;
+    obj["name"] = result.name;
+    obj["iterations"] = int(sorted.size());
+    obj["meanMs"] = sum / double(sorted.size());
+    obj["medianMs"] = at(0.5);
+    obj["p90Ms"] = at(0.9);
+    obj["minMs"] = sorted.front();
+    obj["maxMs"] = sorted.back();
+    return obj;
+}
+
+// Aplikacja nie zapisuje jeszcze geometrii w pliku projektu, dlatego
+// zapis/odczyt mierzymy na równoważnym dokumencie JSON z pomiarami
+// i dymkami.
+QJsonObject projectToJson(const CanvasWidget& canvas) {
+    QJsonArray measures;
+    const MeasurementsTool& tool = canvas.measurementsTool();
+    for (const Measure& m : tool.measures()) {
+        QJsonArray pts;
+        for (const QPointF& pt : tool.points(m)) {
+            pts.append(pt.x());
+            pts.append(pt.y());
+        }
+        QJsonObject obj;
+        obj["name"] = m.name;
+        obj["type"] = int(m.type);
+        obj["color"] = m.color.name(QColor::HexArgb);
+        obj["lineWidthPx"] = m.lineWidthPx;
+        obj["bufferDefaultMeters"] = m.bufferDefaultMeters;
+        obj["bufferFinalMeters"] = m.bufferFinalMeters;
+        obj["layer"] = m.layer;
+        obj["pts"] = pts;
+        measures.append(obj);
+    }
+    QJsonArray callouts;
+    for (const TextItem& t : canvas.textItems()) {
+        QJsonObject obj;
+        obj["text"] = t.text;
+        obj["x"] = t.pos.x();
+        obj["y"] = t.pos.y();
+        obj["rect"] = QJsonArray{t.boundingRect.x(), t.boundingRect.y(), t.boundingRect.width(),
+                                 t.boundingRect.height()};
+        obj["anchor"] = int(t.anchor);
+        obj["layer"] = t.layer;
+        callouts.append(obj);
+    }
+    QJsonObject root;
+    root["measures"] = measures;
+    root["callouts"] = callouts;
+    return root;
+}
+
+void projectFromJson(const QJsonObject& root, CanvasWidget& canvas) {
+    auto& tool = canvas.measurementsTool();
+    std::vector<QPointF> pts;
+    for (const QJsonValue& v : root["measures"].toArray()) {
+        const QJsonObject obj = v.toObject();
+        Measure m;
+        m.name = obj["name"].toString();
+        m.type = MeasureType(obj["type"].toInt());
+        m.color = QColor(obj["color"].toString());
+        m.lineWidthPx = obj["lineWidthPx"].toInt(1);
+        m.bufferDefaultMeters = obj["bufferDefaultMeters"].toDouble();
+        m.bufferFinalMeters = obj["bufferFinalMeters"].toDouble();
+        m.layer = obj["layer"].toString();
+        const QJsonArray coords = obj["pts"].toArray();
+        pts.clear();
+        for (int i = 0; i + 1 < coords.size(); i += 2) {
+            pts.emplace_back(coords[i].toDouble(), coords[i + 1].toDouble());
+        }
+        tool.addMeasure(std::move(m), pts);
+    }
+    for (const QJsonValue& v : root["callouts"].toArray()) {
+        const QJsonObject obj = v.toObject();
+        TextItem t;
+        t.text = obj["text"].toString();
+        t.pos = QPointF(obj["x"].toDouble(), obj["y"].toDouble());
+        const QJsonArray r = obj["rect"].toArray();
+        t.boundingRect = QRectF(r[0].toDouble(), r[1].toDouble(), r[2].toDouble(), r[3].toDouble());
+        t.anchor = CalloutAnchor(obj["anchor"].toInt());
+        t.layer = obj["layer"].toString();
+        canvas.addTextItem(t);
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    // Wymuszenie trybu offscreen (chyba że ustawiono inaczej)
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", QByteArray("offscreen"));
+    }
+    QApplication app(argc, argv);
+
+    Options options;
+    QString error;
+    if (!parseOptions(app.arguments(), options, error)) {
+        qCritical().noquote() << error;
+        return 2;
+    }
+    QTemporaryDir tmp;
+    if (!tmp.isValid()) {
+        qCritical() << "Nie można utworzyć katalogu tymczasowego";
+        return 1;
+    }
+
+    qDebug() << "Budowanie projektu testowego...";
+    std::mt19937 rng(options.seed);
+    ProjectSettings settings;
+    CanvasWidget canvas(nullptr, &settings);
+    canvas.resize(1600, 1000);
+    ProjectGenerator::Params params;
+    params.seed = options.seed;
+    params.buildings = 1;
+    params.floorsPerBuilding = 1;
+    params.measuresPerFloor = options.measures;
+    params.calloutsPerFloor = options.callouts;
+    params.maxPolylineVertices = options.maxVertices;
+    params.floorSize = options.background;
+    params.pixelsPerMeter = canvas.pixelsPerMeter();
+    canvas.setBackgroundImage(ProjectGenerator::makeFloorPlan(options.background, options.seed));
+    ProjectGenerator::populate(canvas, ProjectGenerator(params).generateFloor(QStringLiteral("Piętro 0")));
+    auto& tool = canvas.measurementsTool();
+
+    const int n = options.iterations;
+    std::vector<Result> results;
+    QImage frame(canvas.size(), QImage::Format_ARGB32_Premultiplied);
+
+    qDebug() << "Pomiary:";
+    results.push_back(measure(QStringLiteral("paint.full"), n, [&]() {
+        canvas.invalidateAllLayers();
+        canvas.render(&frame);
+    }));
+    results.push_back(measure(QStringLiteral("paint.cached"), n, [&]() { canvas.render(&frame); }));
+    int panStep = 0;
+    results.push_back(measure(QStringLiteral("paint.pan"), n, [&]() {
+        ++panStep;
+        canvas.setView(1.0, QPointF(-37.0 * panStep, -23.0 * panStep));
+        canvas.render(&frame);
+    }));
+    results.push_back(measure(QStringLiteral("paint.zoomedOut"), n, [&]() {
+        const double fit = std::min(double(canvas.width()) / options.background.width(),
+                                    double(canvas.height()) / options.background.height());
+        canvas.setView(fit, QPointF(0, 0));
+        canvas.invalidateAllLayers();
+        canvas.render(&frame);
+    }));
+    canvas.setView(1.0, QPointF(0, 0));
+
+    // Punkty przez przenośne odwzorowanie generatora – te same w każdej
+    // bibliotece standardowej, więc wyniki przebiegów są porównywalne
+    std::vector<QPointF> hitPoints;
+    for (int i = 0; i < 1000; ++i) {
+        const double x = ProjectGenerator::unit(rng) * options.background.width();
+        const double y = ProjectGenerator::unit(rng) * options.background.height();
+        hitPoints.emplace_back(x, y);
+    }
+    results.push_back(measure(QStringLiteral("hitTest.1000"), n, [&]() {
+        for (const QPointF& pt : hitPoints) {
+            tool.selectMeasureAt(pt, 5.0);
+        }
+    }));
+    tool.clearSelection();
+
+    results.push_back(measure(QStringLiteral("recalculateLengths"), n, [&]() { tool.recalculateLengths(); }));
+    // Jak po applyScaleFromPoints: skalowanie całej geometrii i nowe długości
+    int rescaleStep = 0;
+    results.push_back(measure(QStringLiteral("scaleAllPoints"), n, [&]() {
+        tool.scaleAllPoints(++rescaleStep % 2 ? 1.25 : 0.8);
+    }));
+    if (rescaleStep % 2) {
+        tool.scaleAllPoints(0.8);
+    }
+    std::vector<QPointF> allPoints;
+    for (const Measure& m : tool.measures()) {
+        const PointsView pts = tool.points(m);
+        allPoints.insert(allPoints.end(), pts.begin(), pts.end());
+    }
+    const QTransform rotation = QTransform().rotate(0.5).translate(3.0, -2.0);
+    results.push_back(measure(QStringLiteral("points.transform"), n, [&]() {
+        PointKernels::transform(allPoints.data(), allPoints.size(), rotation);
+    }));
+
+    std::vector<Measure> reportMeasures = tool.measures();
+    results.push_back(measure(QStringLiteral("report.construct"), n, [&]() {
+        ReportDialog dlg(nullptr, &settings, &reportMeasures);
+    }));
+
+    // Raport projektu: 15 kondygnacji (3 budynki × 5) z pomiarami tego płótna
+    std::vector<ProjectReportSource> reportSources;
+    for (int b = 0; b < 3; ++b) {
+        for (int f = 0; f < 5; ++f) {
+            reportSources.push_back(ProjectReportSource{b, f, QStringLiteral("Budynek %1").arg(b + 1),
+                                                        QStringLiteral("Piętro %1").arg(f),
+                                                        &tool.measures()});
+        }
+    }
+    const ProjectReport projectReport(std::move(reportSources));
+    results.push_back(measure(QStringLiteral("projectReport.byName"), n, [&]() {
+        projectReport.group(ReportGrouping::Name);
+    }));
+
+    const QList<Measure> exportList(tool.measures().begin(), tool.measures().end());
+    const QString csvPath = QDir(tmp.path()).filePath(QStringLiteral("bench.csv"));
+    const QString pdfPath = QDir(tmp.path()).filePath(QStringLiteral("bench.pdf"));
+    results.push_back(measure(QStringLiteral("export.csv"), n, [&]() {
+        ExportManager::exportToCSV(csvPath, tool.measures(), settings.decimals);
+    }));
+    // CSV raportu ze wszystkimi kolumnami danych, jak z ReportDialog
+    const MeasureReportModel reportModel(&reportMeasures, &settings, nullptr);
+    QVector<int> reportColumns;
+    for (int c = MeasureReportModel::ColCheck; c <= MeasureReportModel::ColDate; ++c) {
+        reportColumns.append(c);
+    }
+    results.push_back(measure(QStringLiteral("export.reportCsv"), n, [&]() {
+        ExportManager::writeReportCSV(csvPath, reportModel, reportColumns);
+    }));
+    results.push_back(measure(QStringLiteral("export.pdf"), n, [&]() {
+        ExportManager::writePDF(pdfPath, exportList);
+    }));
+
+    const QString projectPath = QDir(tmp.path()).filePath(QStringLiteral("bench.json"));
+    results.push_back(measure(QStringLiteral("project.save"), n, [&]() {
+        QFile f(projectPath);
+        if (f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            f.write(QJsonDocument(projectToJson(canvas)).toJson(QJsonDocument::Compact));
+        }
+    }));
+    results.push_back(measure(QStringLiteral("project.load"), n, [&]() {
+        QFile f(projectPath);
+        if (!f.open(QIODevice::ReadOnly)) {
+            return;
+        }
+        CanvasWidget loaded(nullptr, &settings);
+        projectFromJson(QJsonDocument::fromJson(f.readAll()).object(), loaded);
+    }));
+
+    QJsonObject config;
+    config["measures"] = options.measures;
+    config["callouts"] = options.callouts;
+    config["maxVertices"] = options.maxVertices;
+    config["background"] = QStringLiteral("%1x%2").arg(options.background.width()).arg(options.background.height());
+    config["viewport"] = QStringLiteral("%1x%2").arg(canvas.width()).arg(canvas.height());
+    config["iterations"] = options.iterations;
+    config["seed"] = qint64(options.seed);
+    config["pointKernels"] = QString::fromLatin1(PointKernels::activeVariant());
+
+    QJsonArray resultArray;
+    for (const Result& r : results) {
+        resultArray.append(summarize(r));
+    }
+    QJsonObject root;
+    root["benchmark"] = QStringLiteral("BenchProgramEle");
+    root["qtVersion"] = QString::fromLatin1(qVersion());
+    root["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    root["config"] = config;
+    root["results"] = resultArray;
+    const QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Indented);
+
+    if (options.output.isEmpty()) {
+        std::fwrite(json.constData(), 1, size_t(json.size()), stdout);
+        return 0;
+    }
+    QFile out(options.output);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate) || out.write(json) != json.size()) {
+        qCritical().noquote() << "Nie udało się zapisać" << options.output;
+        return 1;
+    }
+    return 0;
+}
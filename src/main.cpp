@@ -1,7 +1,30 @@
 #include <QApplication>
 #include "MainWindow.h"
+#include "ProjectGenerator.h"
+#include "Trace.h"
 int main(int argc, char *argv[]) {
     QApplication app(argc, argv);
-    MainWindow w; w.show();
-    return app.exec();
+    // --trace[=plik.json] lub ELECCAD_TRACE=plik.json zapisuje ślad Chrome
+    Trace::startFromArguments(argc, argv);
+    int rc = 0;
+    {
+        MainWindow w; w.show();
+        // --generate-project[=ziarno] otwiera duży projekt testowy
+        for (const QString& arg : app.arguments()) {
+            if (arg == QLatin1String("--generate-project") || arg.startsWith(QLatin1String("--generate-project="))) {
+                ProjectGenerator::Params params;
+                params.seed = arg.section(QLatin1Char('='), 1).toUInt();
+                if (params.seed == 0) {
+                    params.seed = 1;
+                }
+                w.loadGeneratedProject(ProjectGenerator(params).generate());
+                break;
+            }
+        }
+        rc = app.exec();
+    }
+    if (Trace::isEnabled() && !Trace::stop()) {
+        qWarning("Nie udało się zapisać pliku śladu");
+    }
+    return rc;
 }
@@ -1,10 +1,446 @@
 #include <QApplication>
+#include <QBuffer>
 #include <QDebug>
+#include <QLocale>
 #include <QTimer>
+#include <algorithm>
+#include <clocale>
+#include <cmath>
+#include <vector>
+#include "CalloutIndex.h"
 #include "CalloutItem.h"
+#include "CsvWriter.h"
+#include "MeasureReportModel.h"
+#include "MeasurementsTool.h"
+#include "PointKernels.h"
+#include "ProjectReport.h"
 
 // Test logiczny CalloutItem w środowisku offscreen (QApplication).
 
+// Pomiary przy granicach komórek siatki, skalowanie i usunięcie
+// wszystkich pomiarów – w indeksie odcinków nie może nic zostać.
+static bool testSegmentIndexAfterScale() {
+    MeasurementsTool tool(nullptr, {});
+    const double cell = SegmentIndex::kDefaultCellSize;
+    for (int i = 0; i < 40; ++i) {
+        const double edge = cell * (i % 7) - 1e-9 * (i % 3);
+        std::vector<QPointF> pts{QPointF(edge, cell * 3 - 1e-12),
+                                 QPointF(edge + cell * 0.5 * i, cell * (i % 5)),
+                                 QPointF(cell * 9 + 1e-10, edge)};
+        tool.addMeasure(Measure(), pts);
+    }
+    for (double factor : {1.1, 0.3, 7.0 / 3.0}) {
+        tool.scaleAllPoints(factor);
+    }
+    while (tool.hasAnyMeasure()) {
+        const Measure& m = tool.measures().front();
+        const QPointF at = tool.points(m).front();
+        if (!tool.selectMeasureAt(at, 1e-3)) {
+            qDebug() << "❌ SegmentIndex: pomiar" << m.id << "nie został znaleziony po skalowaniu";
+            return false;
+        }
+        tool.deleteSelectedMeasure();
+    }
+    const SegmentIndex& index = tool.segmentIndex();
+    const bool empty = index.entryCount() == 0
+        && index.candidates(QRectF(-1e6, -1e6, 2e6, 2e6)).empty();
+    if (!empty) {
+        qDebug() << "❌ SegmentIndex: po usunięciu pomiarów zostały wpisy:" << index.entryCount();
+        return false;
+    }
+    qDebug() << "✅ SegmentIndex: insert → scale → remove nie zostawia wpisów";
+    return true;
+}
+
+// Każdy dostępny wariant PointKernels (SSE2, AVX2) musi dawać te same
+// wyniki co skalarny (długość, skalowanie, przekształcenie afiniczne) – dla 0–17 punktów (pętle główne i reszty) oraz
+// tablic przesuniętych względem wyrównania 16/32 bajtów.
+static bool testPointKernels() {
+    const std::vector<PointKernels::Variant> variants = PointKernels::availableVariants();
+    const PointKernels::Variant& scalar = variants.front();
+    const QTransform transform = QTransform().rotate(17.0).scale(1.5, -0.75).translate(3.0, -2.0);
+    bool ok = true;
+    for (size_t shift = 0; shift < 4; ++shift) {
+        for (size_t count = 0; count <= 17; ++count) {
+            std::vector<QPointF> source(count + 4);
+            for (size_t i = 0; i < source.size(); ++i) {
+                source[i] = QPointF(std::sin(double(i) * 1.7) * 100.0 + double(i), std::cos(double(i) * 0.9) * 37.5);
+            }
+            const QPointF* pts = source.data() + shift;
+            const double expectedLength = scalar.length(pts, count);
+            std::vector<QPointF> expectedScaled(source);
+            scalar.scale(expectedScaled.data() + shift, count, 1.37);
+            std::vector<QPointF> expectedTransformed(source);
+            scalar.transform(expectedTransformed.data() + shift, count, transform);
+            for (const PointKernels::Variant& v : variants) {
+                const double length = v.length(pts, count);
+                if (std::abs(length - expectedLength) > 1e-12 * std::max(1.0, expectedLength)) {
+                    qDebug() << "❌ PointKernels" << v.name << "length: count" << count << "shift" << shift
+                             << length << "!=" << expectedLength;
+                    ok = false;
+                }
+                std::vector<QPointF> scaled(source);
+                v.scale(scaled.data() + shift, count, 1.37);
+                // Mnożenie jest dokładnie takie samo w każdym wariancie; punkty
+                // poza zakresem nie mogą się zmienić.
+                for (size_t i = 0; i < scaled.size(); ++i) {
+                    if (scaled[i].x() != expectedScaled[i].x() || scaled[i].y() != expectedScaled[i].y()) {
+                        qDebug() << "❌ PointKernels" << v.name << "scale: count" << count << "shift" << shift
+                                 << "index" << i;
+                        ok = false;
+                        break;
+                    }
+                }
+                std::vector<QPointF> transformed(source);
+                v.transform(transformed.data() + shift, count, transform);
+                for (size_t i = 0; i < transformed.size(); ++i) {
+                    const QPointF d = transformed[i] - expectedTransformed[i];
+                    const double tolerance = 1e-12 * std::max(1.0, std::abs(expectedTransformed[i].x())
+                                                                     + std::abs(expectedTransformed[i].y()));
+                    if (std::abs(d.x()) > tolerance || std::abs(d.y()) > tolerance) {
+                        qDebug() << "❌ PointKernels" << v.name << "transform: count" << count << "shift" << shift
+                                 << "index" << i << transformed[i] << "!=" << expectedTransformed[i];
+                        ok = false;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    if (ok) {
+        QStringList names;
+        for (const PointKernels::Variant& v : variants) {
+            names << QString::fromLatin1(v.name);
+        }
+        qDebug() << "✅ PointKernels: warianty zgodne ze skalarnym:" << names.join(QStringLiteral(", "));
+    }
+    return ok;
+}
+
+// CsvWriter: cytowanie pól (separator, cudzysłów, nowa linia), polskie
+// znaki w UTF-8 jak QString::toUtf8() oraz kropka dziesiętna niezależnie
+// od ustawień regionalnych. Mały bufor wymusza opróżnianie w trakcie pól.
+static bool testCsvWriter() {
+    const QString polish = QString::fromUtf8("Zażółć gęślą jaźń – ĄĘŁŃÓŚŹŻ");
+    const QString longText = polish.repeated(40);
+    const QByteArray savedLocale = std::setlocale(LC_ALL, nullptr);
+    const QLocale savedQLocale;
+    std::setlocale(LC_ALL, "pl_PL.UTF-8");
+    QLocale::setDefault(QLocale(QLocale::Polish, QLocale::Poland));
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    bool flushed = false;
+    {
+        CsvWriter csv(&buffer, ',', "\n", 256);
+        csv.writeBom();
+        csv.field(u"a,b");
+        csv.field(u"powiedział \"tak\"");
+        csv.field(u"linia 1\nlinia 2");
+        csv.field(u"średnik;bez cytowania");
+        csv.endRow();
+        csv.field(polish);
+        csv.field(1.5, 2, " cm");
+        csv.field(-1234.5678, 3);
+        csv.field(qint64(-42));
+        csv.endRow();
+        csv.field(longText);
+        csv.endRow();
+        flushed = csv.flush();
+    }
+    std::setlocale(LC_ALL, savedLocale.constData());
+    QLocale::setDefault(savedQLocale);
+    if (!flushed) {
+        qDebug() << "❌ CsvWriter: błąd zapisu do QBuffer";
+        return false;
+    }
+
+    const QByteArray expected = QByteArray("\xEF\xBB\xBF")
+        + QString::fromUtf8("\"a,b\",\"powiedział \"\"tak\"\"\",\"linia 1\nlinia 2\",średnik;bez cytowania\n").toUtf8()
+        + polish.toUtf8() + ",1.50 cm,-1234.568,-42\n"
+        + longText.toUtf8() + "\n";
+    if (buffer.data() != expected) {
+        qDebug() << "❌ CsvWriter: niezgodny wynik" << buffer.data() << "!=" << expected;
+        return false;
+    }
+    qDebug() << "✅ CsvWriter: cytowanie, UTF-8 i liczby niezależne od locale";
+    return true;
+}
+
+// Pomiary o powtarzalnych długościach, zapasach, nazwach i warstwach.
+static std::vector<Measure> makeTestMeasures(int count, int seed) {
+    static const MeasureType types[] = {MeasureType::Linear, MeasureType::Polyline, MeasureType::Advanced};
+    std::vector<Measure> measures(size_t(count));
+    for (int i = 0; i < count; ++i) {
+        Measure& m = measures[size_t(i)];
+        const double t = double(i * 31 + seed * 17);
+        m.id = i + 1;
+        m.type = types[(i + seed) % 3];
+        m.name = QStringLiteral("Obwód %1").arg((i + seed) % 7);
+        m.layer = QStringLiteral("Warstwa %1").arg(i % 4);
+        m.lengthMeters = 50.0 + std::abs(std::sin(t * 0.37)) * 4000.0;
+        if (m.type == MeasureType::Advanced) {
+            m.bufferDefaultMeters = 10.0 + std::abs(std::cos(t)) * 90.0;
+            m.bufferFinalMeters = 5.0 + std::abs(std::sin(t * 1.3)) * 40.0;
+        }
+        m.updateTotal();
+    }
+    return measures;
+}
+
+template <typename Predicate>
+static MeasureTotals serialTotals(const std::vector<Measure>& measures, Predicate include) {
+    MeasureTotals totals;
+    for (size_t i = 0; i < measures.size(); ++i) {
+        if (include(i)) {
+            totals.add(measures[i]);
+        }
+    }
+    return totals;
+}
+
+static MeasureTotals serialTotals(const std::vector<Measure>& measures) {
+    return serialTotals(measures, [](size_t) { return true; });
+}
+
+// Sumy przyrostowe różnią się od sumy szeregowej tylko kolejnością dodawania.
+static bool sameTotals(const MeasureTotals& a, const MeasureTotals& b) {
+    auto close = [](double x, double y) { return std::abs(x - y) <= 1e-9 * std::max(1.0, std::abs(y)); };
+    return a.count == b.count && close(a.lengthMeters, b.lengthMeters) && close(a.buffersMeters, b.buffersMeters);
+}
+
+// MeasureTotals: dodawanie, edycja (replace), usuwanie i scalanie sum
+// częściowych muszą dać to samo co suma policzona od nowa.
+static bool testMeasureTotals() {
+    std::vector<Measure> measures = makeTestMeasures(500, 1);
+    MeasureTotals totals;
+    for (const Measure& m : measures) {
+        totals.add(m);
+    }
+    for (size_t i = 0; i < measures.size(); i += 7) {
+        const Measure before = measures[i];
+        measures[i].lengthMeters *= 1.5;
+        measures[i].bufferFinalMeters += 0.25;
+        measures[i].updateTotal();
+        totals.replace(before, measures[i]);
+    }
+    std::vector<Measure> kept;
+    for (size_t i = 0; i < measures.size(); ++i) {
+        if (i % 5 == 0) {
+            totals.remove(measures[i]);
+        } else {
+            kept.push_back(measures[i]);
+        }
+    }
+    const MeasureTotals expected = serialTotals(kept);
+    if (!sameTotals(totals, expected)) {
+        qDebug() << "❌ MeasureTotals: sumy przyrostowe" << totals.count << totals.totalMeters()
+                 << "!=" << expected.count << expected.totalMeters();
+        return false;
+    }
+    const size_t half = kept.size() / 2;
+    MeasureTotals merged = serialTotals(kept, [half](size_t i) { return i < half; });
+    merged.merge(serialTotals(kept, [half](size_t i) { return i >= half; }));
+    if (!sameTotals(merged, expected)) {
+        qDebug() << "❌ MeasureTotals: scalenie sum częściowych" << merged.totalMeters() << "!=" << expected.totalMeters();
+        return false;
+    }
+    MeasureTotals emptied = expected;
+    for (const Measure& m : kept) {
+        emptied.remove(m);
+    }
+    if (emptied.count != 0 || emptied.lengthMeters != 0.0 || emptied.buffersMeters != 0.0) {
+        qDebug() << "❌ MeasureTotals: po usunięciu wszystkich pomiarów zostały resztki" << emptied.lengthMeters;
+        return false;
+    }
+    qDebug() << "✅ MeasureTotals: add/replace/remove/merge zgodne z sumą szeregową";
+    return true;
+}
+
+// CalloutIndex::candidates musi zwracać dokładnie te elementy, których
+// prostokąt styka się z obszarem, rosnąco i bez powtórzeń – także dla
+// prostokątów zdegenerowanych i po przesunięciu elementów.
+static bool testCalloutIndex() {
+    const double cell = CalloutIndex::kDefaultCellSize;
+    CalloutIndex index;
+    std::vector<QRectF> envelopes;
+    for (int i = 0; i < 300; ++i) {
+        const QPointF at(std::sin(i * 0.71) * cell * 10.0, std::cos(i * 1.13) * cell * 6.0);
+        const QSizeF size(i % 9 == 0 ? 0.0 : cell * (0.1 + (i % 5) * 0.6), cell * 0.1 * (i % 4));
+        envelopes.push_back(QRectF(at, size));
+        index.set(i, envelopes.back());
+    }
+    for (int i = 0; i < 300; i += 3) {
+        envelopes[size_t(i)].translate(cell * 1.5, -cell * 0.75);
+        index.set(i, envelopes[size_t(i)]);
+    }
+    auto touches = [](const QRectF& a, const QRectF& b) {
+        return a.left() <= b.right() && b.left() <= a.right() && a.top() <= b.bottom() && b.top() <= a.bottom();
+    };
+    for (int q = 0; q < 60; ++q) {
+        const QPointF at(std::cos(q * 0.53) * cell * 11.0, std::sin(q * 0.29) * cell * 7.0);
+        const QRectF area(at, QSizeF(q % 4 == 0 ? 0.0 : cell * 0.05 * q, cell * 0.03 * q));
+        std::vector<int> expected;
+        for (int i = 0; i < int(envelopes.size()); ++i) {
+            if (touches(envelopes[size_t(i)], area)) {
+                expected.push_back(i);
+            }
+        }
+        if (index.candidates(area) != expected) {
+            qDebug() << "❌ CalloutIndex: niezgodne kandydaty dla" << area;
+            return false;
+        }
+    }
+    qDebug() << "✅ CalloutIndex: kandydaci zgodni z przeglądem wszystkich dymków";
+    return true;
+}
+
+// Sumy zaznaczonych wierszy i projektu w MeasureReportModel po odznaczeniu,
+// edycji i usunięciu wierszy (także niepobranych jeszcze przez widok).
+static bool testMeasureReportModel() {
+    std::vector<Measure> measures = makeTestMeasures(MeasureReportModel::kFetchChunk * 2 + 100, 2);
+    MeasureTotals project = serialTotals(measures);
+    MeasureReportModel model(&measures, nullptr, &project);
+    for (int r = 0; r < model.rowCount(); r += 3) {
+        model.setData(model.index(r, MeasureReportModel::ColCheck), int(Qt::Unchecked), Qt::CheckStateRole);
+    }
+    for (int r = 1; r < model.measureCount(); r += 11) {
+        const Measure before = model.measureAt(r);
+        Measure& m = model.measureAt(r);
+        m.lengthMeters += 2.0;
+        m.bufferDefaultMeters = 0.5;
+        m.updateTotal();
+        model.measureEdited(r, before);
+    }
+    for (int r = model.measureCount() - 1; r >= 0; r -= 13) {
+        model.removeMeasure(r);
+    }
+    const MeasureTotals checked = serialTotals(measures, [&model](size_t i) { return model.isChecked(int(i)); });
+    if (!sameTotals(model.checkedTotals(), checked)) {
+        qDebug() << "❌ MeasureReportModel: sumy zaznaczonych" << model.checkedTotals().totalMeters()
+                 << "!=" << checked.totalMeters();
+        return false;
+    }
+    if (!sameTotals(project, serialTotals(measures))) {
+        qDebug() << "❌ MeasureReportModel: sumy projektu nie odpowiadają pomiarom po edycji i usunięciu";
+        return false;
+    }
+    qDebug() << "✅ MeasureReportModel: sumy zaznaczonych i projektu po edycji i usunięciu";
+    return true;
+}
+
+// ProjectReport::group: każde grupowanie sumuje się do sumy szeregowej
+// wszystkich kondygnacji, a budynki i kondygnacje o tych samych nazwach
+// pozostają osobnymi grupami.
+static bool testProjectReport() {
+    struct FloorSpec { int building; int floor; const char* buildingName; const char* floorName; int count; };
+    const FloorSpec specs[] = {
+        {0, 0, "Budynek A", "Parter", 120}, {0, 1, "Budynek A", "Piętro 1", 80},
+        {1, 0, "Budynek A", "Parter", 95},  {2, 0, "Budynek B", "Parter", 60},
+        {2, 1, "Budynek B", "Parter", 140}, {2, 2, "Budynek B", "Piętro 2", 0},
+    };
+    std::vector<std::vector<Measure>> floors;
+    for (const FloorSpec& spec : specs) {
+        floors.push_back(makeTestMeasures(spec.count, spec.building * 10 + spec.floor));
+    }
+    std::vector<ProjectReportSource> sources;
+    std::vector<Measure> all;
+    for (size_t i = 0; i < floors.size(); ++i) {
+        const FloorSpec& spec = specs[i];
+        sources.push_back(ProjectReportSource{spec.building, spec.floor, QString::fromUtf8(spec.buildingName),
+                                              QString::fromUtf8(spec.floorName), &floors[i]});
+        all.insert(all.end(), floors[i].begin(), floors[i].end());
+    }
+    const ProjectReport report(std::move(sources));
+    const MeasureTotals expected = serialTotals(all);
+    bool ok = true;
+    for (ReportGrouping grouping : {ReportGrouping::Building, ReportGrouping::Floor, ReportGrouping::Layer,
+                                    ReportGrouping::Type, ReportGrouping::Name}) {
+        const std::vector<ProjectReportGroup> groups = report.group(grouping);
+        MeasureTotals sum;
+        for (const ProjectReportGroup& g : groups) {
+            sum.merge(g.totals);
+        }
+        if (!sameTotals(sum, expected)) {
+            qDebug() << "❌ ProjectReport:" << ProjectReport::groupingName(grouping) << sum.totalMeters()
+                     << "!=" << expected.totalMeters();
+            ok = false;
+        }
+        if (grouping == ReportGrouping::Name) {
+            for (const ProjectReportGroup& g : groups) {
+                const MeasureTotals byName = serialTotals(all, [&](size_t i) { return all[i].name == g.key; });
+                if (!sameTotals(g.totals, byName)) {
+                    qDebug() << "❌ ProjectReport: grupa" << g.key << "niezgodna z sumą szeregową";
+                    ok = false;
+                }
+            }
+        }
+    }
+    const std::vector<ProjectReportGroup> buildings = report.group(ReportGrouping::Building);
+    if (buildings.size() != 3) {
+        qDebug() << "❌ ProjectReport: budynki o tej samej nazwie scalone, grup:" << buildings.size();
+        ok = false;
+    }
+    const std::vector<ProjectReportGroup> floorGroups = report.group(ReportGrouping::Floor);
+    if (floorGroups.size() != floors.size()) {
+        qDebug() << "❌ ProjectReport: kondygnacje o tej samej nazwie scalone, grup:" << floorGroups.size();
+        ok = false;
+    } else {
+        for (size_t i = 0; i < floors.size(); ++i) {
+            if (!sameTotals(floorGroups[i].totals, serialTotals(floors[i]))) {
+                qDebug() << "❌ ProjectReport: kondygnacja" << floorGroups[i].key << "niezgodna z sumą szeregową";
+                ok = false;
+            }
+        }
+    }
+    if (ok) {
+        qDebug() << "✅ ProjectReport: grupy zgodne z sumą szeregową, nazwy nie scalają grup";
+    }
+    return ok;
+}
+
+// MeasureGeometry::compact po usunięciu części pomiarów i zmianie ich
+// kolejności: bufor bez dziur, fragmenty kolejno, punkty bez zmian.
+static bool testMeasureGeometryCompact() {
+    MeasureGeometry geometry;
+    std::vector<Measure> measures;
+    std::vector<std::vector<QPointF>> expected;
+    for (int i = 0; i < 200; ++i) {
+        std::vector<QPointF> pts;
+        for (int k = 0; k < i % 9; ++k) {
+            pts.push_back(QPointF(i * 10.0 + k, std::sin(i + k * 0.5) * 100.0));
+        }
+        Measure m;
+        m.id = i;
+        m.points = geometry.append(pts);
+        measures.push_back(m);
+        expected.push_back(pts);
+    }
+    for (int i = int(measures.size()) - 1; i >= 0; i -= 3) {
+        geometry.release(measures[size_t(i)].points);
+        measures.erase(measures.begin() + i);
+    }
+    std::reverse(measures.begin(), measures.end());
+    geometry.compact(measures);
+
+    size_t offset = 0;
+    for (const Measure& m : measures) {
+        const PointsView pts = geometry.points(m.points);
+        const std::vector<QPointF>& want = expected[size_t(m.id)];
+        if (m.points.offset != offset || !std::equal(pts.begin(), pts.end(), want.begin(), want.end())) {
+            qDebug() << "❌ MeasureGeometry: pomiar" << m.id << "ma inne punkty po compact";
+            return false;
+        }
+        offset += m.points.count;
+    }
+    if (geometry.pointCount() != offset || geometry.unusedPointCount() != 0) {
+        qDebug() << "❌ MeasureGeometry: po compact bufor ma" << geometry.pointCount() << "punktów zamiast" << offset;
+        return false;
+    }
+    qDebug() << "✅ MeasureGeometry: compact zachowuje punkty i usuwa nieużywane fragmenty";
+    return true;
+}
+
 int main(int argc, char *argv[]) {
     // Wymuszenie trybu offscreen
     qputenv("QT_QPA_PLATFORM", QByteArray("offscreen"));
@@ -13,8 +449,9 @@ int main(int argc, char *argv[]) {
     qDebug() << "🧪 Running enhanced headless logic test (offscreen + GUI)...";
 
     try {
+        int failures = 0;
         // Krótka przerwa, żeby Qt w pełni zainicjalizował środowisko graficzne
-        QTimer::singleShot(100, []() {
+        QTimer::singleShot(100, [&failures]() {
             try {
                 // Utworzenie obiektu CalloutItem
                 CalloutItem item(QPointF(100, 100));
@@ -37,7 +474,25 @@ int main(int argc, char *argv[]) {
                 if (rect.width() < 1 || rect.height() < 1)
                     qDebug() << "⚠️ Warning: bounding rect too small!";
 
-                qDebug() << "✅ Headless logic test completed successfully.";
+                if (!testSegmentIndexAfterScale())
+                    failures++;
+                if (!testPointKernels())
+                    failures++;
+                if (!testCsvWriter())
+                    failures++;
+                if (!testMeasureTotals())
+                    failures++;
+                if (!testCalloutIndex())
+                    failures++;
+                if (!testMeasureReportModel())
+                    failures++;
+                if (!testProjectReport())
+                    failures++;
+                if (!testMeasureGeometryCompact())
+                    failures++;
+
+                if (failures == 0)
+                    qDebug() << "✅ Headless logic test completed successfully.";
             } catch (std::exception &e) {
                 qDebug() << "❌ Exception in inner logic:" << e.what();
             } catch (...) {
@@ -45,7 +500,7 @@ int main(int argc, char *argv[]) {
             }
 
             // Zakończ aplikację po wykonaniu testu
-            QCoreApplication::exit(0);
+            QCoreApplication::exit(failures ? 1 : 0);
         });
 
         // Uruchom główną pętlę (potrzebna dla QApplication)